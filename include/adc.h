@@ -9,21 +9,102 @@
 
 #include <Arduino.h>
 
+// Most scans in each block handed over by a hardware triggered scan
+#ifndef ADC_SCAN_BLOCK
+#define ADC_SCAN_BLOCK 16
+#endif
+
 /*
  * Name:    adc_init
- * Desc:    Configure the Teensy's ADC to operate at 13-bit resolution.
+ * Desc:    Configure the Teensy's ADCs with the profile named by the
+ *            adc_profile setting.
  */
 void adc_init(void);
 
+/*
+ * Name:    adc_setProfile
+ *  name:   "default" (13-bit), "fast" (10-bit, no averaging) or "quiet"
+ *            (16-bit, averaged in hardware and software)
+ *  return: true if the profile was found and applied
+ * Desc:    Configure both ADCs for a profile and measure how it performs.
+ *            Can't be changed while scanning.
+ */
+bool adc_setProfile(const char* name);
+
+/*
+ * Name:    adc_resolution
+ *  return: number of bits in each reading with the current profile
+ */
+uint8_t adc_resolution();
+
+/*
+ * Name:    adc_channelTime
+ *  return: time adc_sample takes per channel with the current profile (us),
+ *            as measured when the profile was applied
+ */
+float adc_channelTime();
+
 /*
  * Name:      adc_sample
  *  channels: array of channels to sample from
  *  count:    number of channels to sample
  * Desc:      Sample from multiple ADC channels. Indexes passed into `channels`
  *              array will be replaced with the corresponding channel's reading.
+ *              Channels are converted in pairs, one on each of the two ADCs,
+ *              using an assignment worked out when the channel list changes.
  */
 void adc_sample(uint16_t* channels, uint8_t count);
 
+/*
+ * Name:      adc_scanStart
+ *  channels: channel indices to scan, in output order
+ *  count:    number of channels
+ *  rate:     scans per second
+ *  return:   true if the scan was started
+ * Desc:      Scan channels without the CPU. The PDB triggers a conversion on
+ *              both ADCs for each pair in the plan and DMA moves the results
+ *              into one of two blocks, swapping blocks when one fills. The CPU
+ *              is only interrupted once per block. adc_sample does nothing
+ *              until the scan is stopped. Every pin an ADC scans must use the
+ *              same mux. Refused if converting every pair, at the conversion
+ *              time measured for the ADC profile, takes longer than a scan.
+ */
+bool adc_scanStart(const uint16_t* channels, uint8_t count, uint16_t rate);
+
+/*
+ * Name:    adc_scanStop
+ * Desc:    Stop the scan and hand the ADCs back to adc_sample
+ */
+void adc_scanStop();
+
+/*
+ * Name:    adc_scanRunning
+ *  return: true while a scan is running
+ */
+bool adc_scanRunning();
+
+/*
+ * Name:      adc_scanLatest
+ *  channels: set to a recent scan, in the order given to adc_scanStart
+ *  count:    number of channels wanted
+ * Desc:      Copy a scan from the last completed block. All zeros until the
+ *              first block completes. Call from an ISR at the default priority
+ *              so the copy can't be torn.
+ */
+void adc_scanLatest(uint16_t* channels, uint8_t count);
+
+/*
+ * Name:    adc_scanNextBlock
+ *  out:    where to copy the block, ADC_SCAN_BLOCK scans of `count` readings
+ *  seq:    set to the number of the block since the scan started
+ *  return: number of scans copied, or 0 if no block is ready
+ * Desc:    Copy out the newest completed block. Its buffer is refilled once
+ *            the next block completes, so blocks not copied by then are lost
+ *            and counted as overruns, leaving gaps in `seq`. Call from the
+ *            main loop at least once per block.
+ */
+uint16_t adc_scanNextBlock(uint16_t* out, uint32_t* seq);
+
 /*
  * Name:      adc_readTask
  *  unused:   unused argument
@@ -0,0 +1,59 @@
+/*
+ * File:    adcplan.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Assignment of ADC channels to the Teensy's two ADCs, so channels
+ *            can be converted two at a time. Only depends on the C library so
+ *            the pairing can be tested on a host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define ADCPLAN_MAX_CHANNELS 16
+#define ADCPLAN_NO_PIN 0xFF
+
+// ADCs that can convert a pin
+#define ADCPLAN_ON_ADC0 0x01
+#define ADCPLAN_ON_ADC1 0x02
+
+// One or two channels converted at the same time, one on each ADC
+typedef struct adc_pair_t
+{
+    uint8_t pin[2];         // Pin converted by ADC0 and ADC1, or ADCPLAN_NO_PIN
+    uint8_t slot[2];        // Position of each result in the output
+} adc_pair_t;
+
+// Assignment of channels to ADCs, built once per channel list
+typedef struct adc_plan_t
+{
+    uint8_t index[ADCPLAN_MAX_CHANNELS];    // Channel indices the plan is for
+    uint8_t count;
+    uint8_t pairs;
+    adc_pair_t pair[ADCPLAN_MAX_CHANNELS];
+} adc_plan_t;
+
+/*
+ * Name:    adcplan_build
+ *  plan:   set to the assignment
+ *  index:  channel indices, in output order
+ *  pin:    pin of each channel
+ *  reach:  ADCPLAN_ON_ADC0 and/or ADCPLAN_ON_ADC1 for each channel
+ *  count:  number of channels, at most ADCPLAN_MAX_CHANNELS
+ * Desc:    Pair up channels so each pair can be converted by both ADCs at
+ *            once. Channels only one ADC can reach are paired with channels
+ *            only the other can reach first, then with channels either can.
+ *            A channel neither can reach is left to ADC0 to fail on.
+ */
+void adcplan_build(adc_plan_t* plan, const uint16_t* index, const uint8_t* pin,
+                   const uint8_t* reach, uint8_t count);
+
+/*
+ * Name:    adcplan_matches
+ *  plan:   plan to check
+ *  index:  channel indices, in output order
+ *  count:  number of channels
+ *  return: true if the plan is for exactly these channels
+ */
+bool adcplan_matches(const adc_plan_t* plan, const uint16_t* index, uint8_t count);
@@ -0,0 +1,86 @@
+/*
+ * File:    adcscan.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Block hand-off and layout for the hardware triggered ADC scan. DMA
+ *            fills the two halves of each ADC's buffer in turn, one result
+ *            per pair in the plan for each scan. Only depends on the C
+ *            library so the hand-off can be tested on a host against a
+ *            simulated DMA.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "adcplan.h"
+
+// Blocks handed from the DMA interrupt to the main loop
+typedef struct adcscan_handoff_t
+{
+    volatile uint32_t blocks;   // Blocks completed
+    volatile uint8_t newest;    // Half of the buffer holding the last block
+    uint32_t read;              // Blocks handed out, or lost
+    uint32_t overruns;          // Blocks refilled before they were read
+} adcscan_handoff_t;
+
+/*
+ * Name:    adcscan_complete
+ *  handoff: hand-off to update
+ *  writing: half of the buffer the DMA has moved on to, 0 or 1
+ * Desc:    Record that the other half has just been filled
+ * !!! CALLED BY DMA INTERRUPT !!!
+ */
+void adcscan_complete(adcscan_handoff_t* handoff, uint8_t writing);
+
+/*
+ * Name:     adcscan_take
+ *  handoff: hand-off to take from
+ *  seq:     set to the number of the block, counting from 0
+ *  return:  half of the buffer holding the block, or -1 if no new block has
+ *             completed
+ * Desc:     Take the newest completed block. Older blocks have already been
+ *             refilled, so they are counted as overruns. Copy the block out,
+ *             then check it with adcscan_release.
+ */
+int8_t adcscan_take(adcscan_handoff_t* handoff, uint32_t* seq);
+
+/*
+ * Name:     adcscan_release
+ *  handoff: hand-off the block was taken from
+ *  seq:     number of the block, from adcscan_take
+ *  return:  true if the copy is good, false if the DMA may have started
+ *             refilling the block while it was copied, which counts as an
+ *             overrun
+ */
+bool adcscan_release(adcscan_handoff_t* handoff, uint32_t seq);
+
+/*
+ * Name:    adcscan_offset
+ *  block:  scans in each block
+ *  pairs:  pairs in the plan
+ *  half:   half of the buffer, 0 or 1
+ *  scan:   scan within the block
+ *  return: position of the scan's first result in each ADC's buffer
+ */
+uint16_t adcscan_offset(uint16_t block, uint8_t pairs, uint8_t half, uint16_t scan);
+
+/*
+ * Name:    adcscan_unpack
+ *  plan:   plan the scan was started with
+ *  adc0:   ADC0's results for the scan, one per pair
+ *  adc1:   ADC1's results for the scan, one per pair
+ *  out:    set to `plan->count` results in channel order
+ */
+void adcscan_unpack(const adc_plan_t* plan, const volatile uint16_t* adc0,
+                    const volatile uint16_t* adc1, uint32_t* out);
+
+/*
+ * Name:           adcscan_rateFits
+ *  pairs:         pairs in the plan
+ *  rate:          scans per second
+ *  conversion_us: time for one conversion
+ *  return:        true if every pair can be converted before the next is
+ *                   triggered
+ */
+bool adcscan_rateFits(uint8_t pairs, uint16_t rate, float conversion_us);
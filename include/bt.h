@@ -12,6 +12,12 @@
 
 #include "logger.h"
 
+// Extra memory given to the HM-10 UART transmit buffer, drained by the UART
+//   interrupt so writes don't have to wait for bytes to go out
+#ifndef BT_TX_BUF_LEN
+#define BT_TX_BUF_LEN   4096
+#endif
+
 /*
  * Name:    bt_init
  * Desc:    Start the Blueoother serial and flush the recieve buffer
@@ -27,7 +33,8 @@ bool bt_active();
 
 /*
  * Name:    bt_tick
- * Desc:    collect received characters and dispatch commands
+ * Desc:    collect received characters, dispatch commands and advance any
+ *            historical transfer. Called every loop; never blocks.
  */
 bool bt_tick();
 
@@ -41,10 +48,29 @@ bool bt_isLive();
 /*
  * Name:    bt_sendSample
  *  sample: pointer to sample
- * Desc:    Send a single sample as bytes and a '#' delimiter
+ * Desc:    Queue a live sample to be sent. Samples are batched into FRAME_LIVE
+ *            frames (see frame.h) as deltas from the previous sample, and sent
+ *            once a frame is full or `live_flush_ms` has passed.
  */
 void bt_sendSample(log_entry_t* sample);
 
+/*
+ * Name:    bt_write
+ *  data:   bytes to send to the app
+ *  len:    number of bytes
+ *  partial: accept as much as fits rather than all or nothing
+ *  return: number of bytes queued, 0 if nothing was queued
+ * Desc:    Queue bytes for the HM-10 without waiting. Callers should skip or
+ *            defer work when the data is not accepted.
+ */
+uint16_t bt_write(const void* data, uint16_t len, bool partial = false);
+
+/*
+ * Name:    bt_writeSpace
+ *  return: number of bytes that can be queued right now
+ */
+uint16_t bt_writeSpace();
+
 /*
  * Name:    bt_console
  *  argc:   number of arguments
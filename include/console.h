@@ -11,6 +11,7 @@
 #include "bt.h"
 #include "mpu.h"
 #include "clock.h"
+#include "logger.h"
 #include "storage.h"
 
 // Function pointer for individual command handler
@@ -30,7 +31,8 @@ const console_command_t command_table[] =
     { "adc", adc_console },
     { "clock", clock_console },
     { "sd", storage_console },
-    { "bt", bt_console }
+    { "bt", bt_console },
+    { "log", logger_console }
 };
 
 /*
@@ -0,0 +1,65 @@
+/* 
+ * File:    csv.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Fast conversion between log entries and CSV log file rows.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "logger.h"
+
+// Longest possible row: timestamp, 7 MPU values and every ADC channel
+#define CSV_ROW_MAX_LEN (16 + 7 * 7 + LOGGER_MAX_ADC_CHANNELS * 6 + 2)
+
+// Lines starting with this are comments, not rows
+#define CSV_COMMENT '#'
+
+// Comment recording the ADC channels in the rows after it, e.g.
+//   "#channel_mask,8191" for channels 0 to 12
+#define CSV_MASK_PREFIX "#channel_mask,"
+#define CSV_MASK_MAX_LEN (sizeof(CSV_MASK_PREFIX) - 1 + 5 + 2)
+
+/*
+ * Name:      csv_formatRow
+ *  buf:      buffer of at least CSV_ROW_MAX_LEN bytes to write the row to
+ *  entry:    log entry to format
+ *  channels: number of ADC channels to include
+ *  return:   length of the row, not null terminated
+ * Desc:      Format a log entry as a CSV row ending in "\r\n". Output is
+ *              identical to printing "%lu.%03d" for the timestamp and "%d"
+ *              for every other value.
+ */
+uint16_t csv_formatRow(char* buf, const log_entry_t* entry, uint8_t channels);
+
+/*
+ * Name:    csv_parseRow
+ *  row:    row text, without the line ending
+ *  len:    number of characters in the row
+ *  entry:  log entry to populate, zeroed first
+ *  return: number of values parsed, counting the seconds and milliseconds of
+ *            the timestamp separately (at least 9 for a valid row)
+ * Desc:    Parse a CSV log row in a single pass. Parsing stops at the first
+ *            malformed value.
+ */
+uint8_t csv_parseRow(const char* row, uint16_t len, log_entry_t* entry);
+
+/*
+ * Name:    csv_formatMask
+ *  buf:    buffer of at least CSV_MASK_MAX_LEN bytes to write the line to
+ *  mask:   ADC channels in the rows that follow, lowest first
+ *  return: length of the line, not null terminated
+ * Desc:    Format the channel mask comment, ending in "\r\n"
+ */
+uint16_t csv_formatMask(char* buf, uint16_t mask);
+
+/*
+ * Name:    csv_parseComment
+ *  row:    line text, without the line ending
+ *  len:    number of characters in the line
+ *  mask:   set if the line is a channel mask comment, otherwise unchanged
+ *  return: true if the line is a comment and should not be read as a row
+ */
+bool csv_parseComment(const char* row, uint16_t len, uint16_t* mask);
@@ -0,0 +1,126 @@
+/* 
+ * File:    frame.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Binary framing for data sent to the app over Bluetooth. A frame is
+ *            a type byte, a 16-bit sequence number, a payload and a CRC16,
+ *            COBS encoded so that 0x00 only ever appears as the delimiter
+ *            ending the frame. Only depends on the C library so the encoder
+ *            and decoder can be built on a host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Large enough for a minute rollup with every ADC channel
+#define FRAME_MAX_PAYLOAD   160
+
+// Header (type + sequence) and CRC around the payload
+#define FRAME_OVERHEAD      5
+
+// Worst case encoded size: COBS adds one byte per 254, plus the delimiter
+#define FRAME_MAX_ENCODED   (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD + \
+                             (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD) / 254 + 2)
+
+/*
+ * FRAME_LIVE payload:
+ *   uint8_t count, uint8_t channels, then the first sample as a binary log
+ *   record with `channels` ADC readings. Each of the remaining count - 1
+ *   samples is a varint of milliseconds since the previous sample followed
+ *   by zigzag varint deltas from the previous sample of the 7 MPU values and
+ *   each ADC reading.
+ */
+typedef enum
+{
+    FRAME_LIVE = 1,         // Batch of live samples, see above
+    FRAME_HIST,             // Historical sample, sequence is the low 16 bits of its
+                            //   sample number within the hour file. An hour at a
+                            //   poll rate under 55 ms has more than 65536 samples,
+                            //   so the sequence wraps; frames arrive in order, so
+                            //   the app adds 65536 each time it goes backwards to
+                            //   get the full number (e.g. to resume a `get`).
+    FRAME_END,              // End of a historical transfer, payload is the uint32_t
+                            //   number of samples sent then the uint32_t sample
+                            //   number (local epoch for queries) to resume from
+    FRAME_QUERY,            // Sample matching a filtered query, laid out like a
+                            //   binary log record with only the query's ADC
+                            //   channels. Sequence counts matches sent.
+    FRAME_ROLLUP            // One minute rollup: minute, count and channels as
+                            //   in log_rollup_t (storage.h), then the min, max
+                            //   and mean of the 7 + channels values
+} frame_type_t;
+
+/*
+ * Name:    frame_crc16
+ *  data:   bytes to checksum
+ *  len:    number of bytes
+ *  crc:    initial value, 0xFFFF for a new checksum
+ *  return: CRC16-CCITT of the data
+ */
+uint16_t frame_crc16(const uint8_t* data, uint16_t len, uint16_t crc);
+
+/*
+ * Name:    frame_encode
+ *  out:    buffer of at least FRAME_MAX_ENCODED bytes
+ *  type:   frame type
+ *  seq:    sequence number
+ *  payload: payload bytes
+ *  len:    payload length, at most FRAME_MAX_PAYLOAD
+ *  return: number of bytes written including the 0x00 delimiter, 0 on error
+ * Desc:    Build a COBS encoded frame ready to send.
+ */
+uint16_t frame_encode(uint8_t* out, uint8_t type, uint16_t seq, const uint8_t* payload, uint16_t len);
+
+/*
+ * Name:    frame_decode
+ *  in:     encoded frame, without the 0x00 delimiter
+ *  len:    number of encoded bytes
+ *  type:   decoded frame type
+ *  seq:    decoded sequence number
+ *  payload: buffer of at least FRAME_MAX_PAYLOAD bytes for the payload
+ *  payload_len: decoded payload length
+ *  return: true if the frame decoded and its CRC matched
+ * Desc:    Decode a frame received up to (not including) a 0x00 delimiter.
+ */
+bool frame_decode(const uint8_t* in, uint16_t len, uint8_t* type, uint16_t* seq,
+                  uint8_t* payload, uint16_t* payload_len);
+
+/*
+ * Name:    frame_putVarint
+ *  out:    where to write, at least 5 bytes
+ *  val:    value to write
+ *  return: number of bytes written
+ * Desc:    Write a value 7 bits at a time, least significant first, with the
+ *            top bit of each byte set if more follow.
+ */
+uint8_t frame_putVarint(uint8_t* out, uint32_t val);
+
+/*
+ * Name:    frame_getVarint
+ *  in:     where to read from
+ *  len:    bytes available
+ *  val:    decoded value
+ *  return: number of bytes read, 0 if truncated
+ */
+uint8_t frame_getVarint(const uint8_t* in, uint16_t len, uint32_t* val);
+
+/*
+ * Name:    frame_zigzag
+ *  val:    signed value
+ *  return: value mapped so small magnitudes are small (0, -1, 1, -2, ...)
+ */
+static inline uint32_t frame_zigzag(int32_t val)
+{
+    return ((uint32_t) val << 1) ^ (uint32_t) (val >> 31);
+}
+
+/*
+ * Name:    frame_unzigzag
+ *  val:    value from frame_zigzag
+ *  return: original signed value
+ */
+static inline int32_t frame_unzigzag(uint32_t val)
+{
+    return (int32_t) (val >> 1) ^ -(int32_t) (val & 1);
+}
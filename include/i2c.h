@@ -0,0 +1,76 @@
+/*
+ * File:    i2c.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Interrupt driven register reads on I2C0, so sensors can be read
+ *            without waiting on the bus. Shares the bus with Wire: blocking
+ *            Wire users must hold the bus with i2c_acquire while they use it.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// Priority of the I2C0 interrupt. The same as IntervalTimer so completions
+//   never run in the middle of a sampling ISR, and vice versa.
+#ifndef I2C_IRQ_PRIORITY
+#define I2C_IRQ_PRIORITY 128
+#endif
+
+// Time after which a transfer that has not completed is abandoned
+#ifndef I2C_TIMEOUT_US
+#define I2C_TIMEOUT_US 2000
+#endif
+
+/*
+ * Name:    i2c_done_t
+ *  ok:     true if every byte was read, false on a NACK, lost arbitration or
+ *            timeout
+ *  ctx:    context passed to i2c_readAsync
+ * Desc:    Called from the I2C interrupt when a transfer finishes. The bus is
+ *            free again by the time this is called.
+ */
+typedef void (*i2c_done_t)(bool ok, void* ctx);
+
+/*
+ * Name:    i2c_init
+ * Desc:    Take over the I2C0 interrupt. Must be called after Wire.begin(),
+ *            which sets up the pins and bus clock.
+ */
+void i2c_init();
+
+/*
+ * Name:    i2c_readAsync
+ *  addr:   7-bit device address
+ *  reg:    first register to read
+ *  buf:    where to read to, must stay valid until `done` is called
+ *  len:    number of bytes to read
+ *  done:   called when the transfer finishes
+ *  ctx:    passed to `done`
+ *  return: true if the transfer was started, false if the bus is in use
+ * Desc:    Start reading consecutive registers and return straight away.
+ */
+bool i2c_readAsync(uint8_t addr, uint8_t reg, uint8_t* buf, uint8_t len, i2c_done_t done, void* ctx);
+
+/*
+ * Name:    i2c_busy
+ *  return: true if a transfer is in progress or the bus is held
+ * Desc:    Also abandons a transfer that has passed I2C_TIMEOUT_US, calling
+ *            its `done` with ok = false.
+ */
+bool i2c_busy();
+
+/*
+ * Name:    i2c_acquire
+ *  timeout_us: how long to wait for a transfer in progress to finish
+ *  return: true if the bus is now held
+ * Desc:    Hold the bus for blocking Wire transactions. No transfers are
+ *            started until i2c_release is called.
+ */
+bool i2c_acquire(uint32_t timeout_us);
+
+/*
+ * Name:    i2c_release
+ * Desc:    Release the bus held with i2c_acquire
+ */
+void i2c_release();
@@ -13,6 +13,25 @@
 
 #define LOGGER_MAX_ADC_CHANNELS 16
 
+// Number of samples buffered between the sample ISR and the SD writer. Must be
+//   a power of two; can be overridden with a build flag.
+#ifndef LOGGER_RING_LEN
+#define LOGGER_RING_LEN 64
+#endif
+
+// Number of FIFO IMU samples buffered between the FIFO drain and the SD writer.
+//   Must be a power of two.
+#ifndef LOGGER_IMU_RING_LEN
+#define LOGGER_IMU_RING_LEN 512
+#endif
+
+// Period of the main loop's IMU FIFO drain when `mpu_rate` is set. The 1 KB
+//   FIFO holds 73 samples (73 ms at 1 kHz), so this, and any stall of the
+//   main loop such as a slow SD write, must stay under 73 sample periods.
+#ifndef LOGGER_IMU_DRAIN_MS
+#define LOGGER_IMU_DRAIN_MS 10
+#endif
+
 typedef struct log_entry_t
 {
     uint32_t time;          // Seconds since epoch
@@ -21,13 +40,33 @@ typedef struct log_entry_t
     int16_t  mpu_gyro[3];   // MPU gyro X, Y, Z (rad/s)
     int16_t  mpu_temp;      // MPU temperature (degC)
 
-    // Array of raw 13-bit ADC readings
+    // Array of raw ADC readings, at the resolution of the ADC profile
     uint16_t adc_data[LOGGER_MAX_ADC_CHANNELS];
 } log_entry_t;
 
+/*
+ * Name:    logger_loadConfig
+ * Desc:    Build a sampling plan from the config and hand it to the sample
+ *            ISR. While sampling, only a new period takes effect straight
+ *            away; channel, IMU and scan changes wait for the next start.
+ *            While stopped, samples still waiting to be written keep their
+ *            layout, and the plan takes over once logger_serviceBuffer has
+ *            written them.
+ */
+void logger_loadConfig();
+
 /*
  * Name:    logger_startSampling
- * Desc:    Start the timer ISR at the configured period
+ * Desc:    Write out any samples left from the last run, then load the config
+ *            and start the timer ISR at the configured period.
+ *            If `mpu_rate` is set the IMU samples into its FIFO at that rate,
+ *            and logger_serviceBuffer drains the FIFO into the hour's IMU
+ *            file. If `adc_scan_hz` is set the ADCs scan at that rate and
+ *            logger_serviceBuffer copies each block of scans into the hour's
+ *            scan file. Doesn't start if the sample ISR would have to convert
+ *            every channel, because the scan is off or can't start, and that
+ *            takes more than half the period. Does nothing if already
+ *            sampling.
  */
 void logger_startSampling();
 
@@ -44,8 +83,34 @@ void logger_stopSampling();
  */
 bool logger_getState();
 
+/*
+ * Name:    logger_channelCount
+ *  return: number of ADC channels in each sample
+ * Desc:    Get the number of channels sampled since sampling was started
+ */
+uint8_t logger_channelCount();
+
+/*
+ * Name:    logger_channelMask
+ *  return: ADC channels in each sample, one bit per channel index. Readings
+ *            are stored lowest channel first.
+ * Desc:    Get the channels sampled since sampling was started
+ */
+uint16_t logger_channelMask();
+
 /*
  * Name:    logger_serviceBuffer
- * Desc:    Attempt to write the next sample to the SD card as a CSV row
+ * Desc:    Attempt to write the next sample to the SD card as a CSV row or
+ *            binary record, depending on the `log_format` setting. Also
+ *            drains the IMU FIFO every LOGGER_IMU_DRAIN_MS while it runs, and
+ *            copies out each completed ADC scan block.
  */
 void logger_serviceBuffer();
+
+/*
+ * Name:    logger_console
+ *  argc:   number of arguments
+ *  argv:   list of arguments
+ * Desc:    Logger console command handler
+ */
+bool logger_console(uint8_t argc, char* argv[]);
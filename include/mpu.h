@@ -9,6 +9,28 @@
 
 #include <Arduino.h>
 
+// I2C bus clock, fast mode by default
+#ifndef MPU_I2C_CLOCK
+#define MPU_I2C_CLOCK   400000
+#endif
+
+#ifndef MPU_HEALTH_MS
+#define MPU_HEALTH_MS   1000    // Period of the connection health check
+#endif
+
+#ifndef MPU_RETRY_MS
+#define MPU_RETRY_MS    10000   // Time between attempts to reconnect a lost IMU
+#endif
+
+// Most samples read from the FIFO per mpu_readFifo call (14 bytes each)
+#ifndef MPU_FIFO_BURST
+#define MPU_FIFO_BURST  18
+#endif
+
+#ifndef MPU_FAIL_LIMIT
+#define MPU_FAIL_LIMIT  3       // Consecutive failed reads before reinitializing
+#endif
+
 typedef enum 
 {
     GYRO_250_DEG_PER_S = 0,
@@ -36,6 +58,23 @@ typedef enum
     FILTER_5_HZ
 } mpu_filter_range_t;
 
+// Sample read from the MPU 6050's FIFO
+typedef struct mpu_sample_t
+{
+    uint32_t time;          // Local epoch
+    uint16_t millis;        // Milliseconds into current second
+    int16_t  accel[3];      // Raw counts
+    int16_t  gyro[3];
+    int16_t  temp;
+} mpu_sample_t;
+
+/*
+ * Name:    mpu_done_t
+ *  ok:     true if the sample was read
+ * Desc:    Called from the I2C interrupt when an async sample read finishes
+ */
+typedef void (*mpu_done_t)(bool ok);
+
 typedef struct mpu_cal_t
 {
     int16_t ax;
@@ -59,6 +98,13 @@ const mpu_cal_t mpu_cal_configs[] =
  */
 bool mpu_init();
 
+/*
+ * Name:    mpu_tick
+ * Desc:    Check the health of the IMU connection, reinitializing it after
+ *            repeated failed reads or a failed init. Called every loop.
+ */
+void mpu_tick();
+
 /*
  * Name:    mpu_configure
  *  accel:  accelerometer range option
@@ -88,10 +134,63 @@ uint16_t mpu_getGyroRange();
  *  accel:  accelerometer data {x, y, z} (raw counts)
  *  gyro:   gyro data {x, y, z} (raw counts)
  *  temp:   temperature reading (raw counts)
- * Desc:    Get a single MPU 6050 sample and keep in raw integer format
+ *  return: true if the sample was read
+ * Desc:    Get a single MPU 6050 sample and keep in raw integer format. All
+ *            registers are read in one I2C burst. Waits for the bus, so
+ *            should not be called from an ISR; see mpu_sampleAsync.
  */
 bool mpu_sampleRaw(int16_t accel[3], int16_t gyro[3], int16_t* temp);
 
+/*
+ * Name:    mpu_sampleAsync
+ *  accel:  accelerometer data {x, y, z} (raw counts)
+ *  gyro:   gyro data {x, y, z} (raw counts)
+ *  temp:   temperature reading (raw counts)
+ *  done:   called once the sample has been read, or the read failed
+ *  return: true if the read was started
+ * Desc:    Start reading a sample without waiting for the bus. The outputs
+ *            must stay valid until `done` is called. A read that can't start,
+ *            because the sensor is disconnected or the bus is in use, counts
+ *            as a failed read and leaves the outputs alone.
+ */
+bool mpu_sampleAsync(int16_t accel[3], int16_t gyro[3], int16_t* temp, mpu_done_t done);
+
+/*
+ * Name:    mpu_startFifo
+ *  rate:   sample rate (Hz)
+ *  return: true if the FIFO was started
+ * Desc:    Have the MPU 6050 sample on its own clock into its FIFO, at the
+ *            closest rate its sample rate divider allows. The FIFO is restarted
+ *            if the sensor is reinitialized.
+ */
+bool mpu_startFifo(uint16_t rate);
+
+/*
+ * Name:    mpu_stopFifo
+ * Desc:    Stop sampling into the FIFO
+ */
+void mpu_stopFifo();
+
+/*
+ * Name:    mpu_fifoRate
+ *  return: FIFO sample rate (Hz), 0 if the FIFO is not running
+ */
+uint16_t mpu_fifoRate();
+
+/*
+ * Name:    mpu_readFifo
+ *  out:    where to read samples to, times are not set
+ *  max:    max number of samples to read
+ *  behind: number of samples still in the FIFO after those read
+ *  return: number of samples read
+ * Desc:    Read a burst of samples from the FIFO. I2Cdev splits reads into
+ *            32 byte chunks, each a register write and a read, so samples
+ *            are read two at a time to keep every chunk whole. Waits for the
+ *            bus, so must be called from the main loop rather than an ISR.
+ *            The FIFO is reset, losing its contents, if it has overflowed.
+ */
+uint16_t mpu_readFifo(mpu_sample_t* out, uint16_t max, uint16_t* behind);
+
 /*
  * Name:    mpu_sampleFloat
  *  accel:  accelerometer data {x, y, z} (m/s^2)
@@ -0,0 +1,29 @@
+/* 
+ * File:    oversample.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Fixed-point averaging and decimation of ADC conversions. A sum of
+ *            2^n conversions scaled back to the converted resolution is
+ *            their average, which lowers noise but adds no resolution. Only
+ *            sums of 4^k conversions can keep k extra bits, and only when
+ *            the input is noisy enough to dither. Only depends on the C
+ *            library so the kernel can be built and timed on a host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Name:        oversample_decimate
+ *  sums:       per channel sum of 2^oversample conversions
+ *  out:        set to each channel's reading
+ *  count:      number of channels
+ *  in_bits:    resolution of each conversion
+ *  oversample: log2 of the number of conversions in each sum
+ *  out_bits:   resolution of the readings
+ * Desc:        Scale each sum to `out_bits`, rounding to nearest and clamping
+ *                to the largest reading.
+ */
+void oversample_decimate(const uint32_t* sums, uint16_t* out, uint8_t count,
+                         uint8_t in_bits, uint8_t oversample, uint8_t out_bits);
@@ -0,0 +1,148 @@
+/*
+ * File:    ring.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Lock-free single-producer/single-consumer ring buffer. The producer
+ *            (typically an ISR) and the consumer (the main loop) each own one
+ *            index, so no locking is needed. Only depends on the standard
+ *            library so it can also be built and exercised on a host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t LEN>
+class ring_t
+{
+    static_assert(LEN >= 2 && !(LEN & (LEN - 1)), "ring length must be a power of two");
+
+  public:
+    ring_t() : _head(0), _tail(0), _drops(0), _high_water(0) {}
+
+    /*
+     * Name:    reserve
+     *  return: pointer to the next free slot, or nullptr if the ring is full
+     * Desc:    Producer only. Get a slot to fill in place. Nothing is visible
+     *            to the consumer until commit() is called. A full ring counts
+     *            as a dropped entry.
+     */
+    T* reserve()
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+
+        if (head - _tail.load(std::memory_order_acquire) >= LEN)
+        {
+            _drops.store(_drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        return &_buf[head & (LEN - 1)];
+    }
+
+    /*
+     * Name:    commit
+     * Desc:    Producer only. Publish the slot returned by the last reserve().
+     */
+    void commit()
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed) + 1;
+        uint32_t used = head - _tail.load(std::memory_order_relaxed);
+
+        if (used > _high_water.load(std::memory_order_relaxed))
+            _high_water.store(used, std::memory_order_relaxed);
+
+        _head.store(head, std::memory_order_release);
+    }
+
+    /*
+     * Name:    push
+     *  item:   entry to copy into the ring
+     *  return: true if the entry was added, false if it was dropped
+     * Desc:    Producer only. Copy an entry into the ring.
+     */
+    bool push(const T& item)
+    {
+        T* slot = reserve();
+        if (!slot)
+            return false;
+
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    /*
+     * Name:    peek
+     *  return: pointer to the oldest unread entry, or nullptr if empty
+     * Desc:    Consumer only. The entry stays valid until pop() is called.
+     */
+    T* peek()
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+
+        if (_head.load(std::memory_order_acquire) == tail)
+            return nullptr;
+
+        return &_buf[tail & (LEN - 1)];
+    }
+
+    /*
+     * Name:    pop
+     * Desc:    Consumer only. Release the entry returned by peek().
+     */
+    void pop()
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /*
+     * Name:    count
+     *  return: number of entries waiting to be read
+     */
+    uint32_t count() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    /*
+     * Name:    capacity
+     *  return: total number of slots in the ring
+     */
+    static constexpr uint32_t capacity() { return LEN; }
+
+    /*
+     * Name:    drops
+     *  return: number of entries rejected because the ring was full
+     */
+    uint32_t drops() const { return _drops.load(std::memory_order_relaxed); }
+
+    /*
+     * Name:    highWater
+     *  return: largest number of entries that have been waiting at once
+     */
+    uint32_t highWater() const { return _high_water.load(std::memory_order_relaxed); }
+
+    /*
+     * Name:    resetStats
+     * Desc:    Clear the drop and high-water counters. Counts in flight on the
+     *            producer side may be lost, which is fine for diagnostics.
+     */
+    void resetStats()
+    {
+        _drops.store(0, std::memory_order_relaxed);
+        _high_water.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    T _buf[LEN];
+
+    // Free-running indices, masked on access. Head is only written by the
+    //   producer and tail only by the consumer.
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+
+    std::atomic<uint32_t> _drops;
+    std::atomic<uint32_t> _high_water;
+};
@@ -9,11 +9,45 @@
 #pragma once
 
 #include <Arduino.h>
+#include <stddef.h>
 
+#include "adc.h"
 #include "logger.h"
+#include "mpu.h"
 
 #define CONFIG_STRING_LEN 32
 
+// Size of the log write-combining buffer. Must be a multiple of the 512 byte
+//   SD sector size; can be overridden with a build flag.
+#ifndef LOG_WRITE_BUF_LEN
+#define LOG_WRITE_BUF_LEN 8192
+#endif
+
+// Size of the block buffer used when reading log files back
+#ifndef LOG_READ_BUF_LEN
+#define LOG_READ_BUF_LEN 4096
+#endif
+
+// Number of hourly log files tracked by the log catalog
+#ifndef LOG_CATALOG_LEN
+#define LOG_CATALOG_LEN 1024
+#endif
+
+// Size of the write buffer for FIFO IMU samples
+#ifndef LOG_IMU_BUF_LEN
+#define LOG_IMU_BUF_LEN 4096
+#endif
+
+// Size of the write buffer for ADC scan blocks
+#ifndef LOG_SCAN_BUF_LEN
+#define LOG_SCAN_BUF_LEN 4096
+#endif
+
+// Maximum time buffered log data may wait before it is forced to the card
+#ifndef LOG_FLUSH_MS
+#define LOG_FLUSH_MS 1000
+#endif
+
 typedef enum
 {
     CONFIG_DEV_NAME = 0,
@@ -22,9 +56,138 @@ typedef enum
     CONFIG_MPU_ID,
     CONFIG_CHANNEL_BOT,
     CONFIG_CHANNEL_TOP,
+    CONFIG_LOG_FORMAT,
+    CONFIG_LIVE_FLUSH,
+    CONFIG_MPU_RATE,
+    CONFIG_ADC_SCAN_RATE,
+    CONFIG_ADC_PROFILE,
+    CONFIG_CHANNEL_MASK,
     CONFIG_COUNT
 } config_keys_t;
 
+typedef enum
+{
+    LOG_FORMAT_CSV = 0,
+    LOG_FORMAT_BIN
+} log_format_t;
+
+#define LOG_BIN_MAGIC   "DSLG"
+#define LOG_BIN_VERSION 2
+
+#define LOG_IMU_MAGIC   "DSIM"
+#define LOG_IMU_VERSION 1
+
+#define LOG_SCAN_MAGIC   "DSSC"
+#define LOG_SCAN_VERSION 1
+
+// Bytes in a binary log record holding `channels` ADC readings. Records are
+//   the leading part of a log_entry_t, so no conversion is needed.
+#define LOG_BIN_RECORD_SIZE(channels) \
+    (offsetof(log_entry_t, adc_data) + (channels) * sizeof(uint16_t))
+
+// Entry in the index kept alongside each log file (".csv.idx" or ".bin.idx"),
+//   one per second of data
+typedef struct __attribute__((packed)) log_index_entry_t
+{
+    uint32_t time;      // Local epoch of the first sample in this second
+    uint32_t offset;    // Byte offset of that sample in the log file
+    uint32_t sample;    // Index of that sample within the log file
+} log_index_entry_t;
+
+// Log catalog entry describing one hour of logs. An hour whose format was
+//   changed part way through has a file in each format, counted together.
+typedef struct __attribute__((packed)) log_catalog_entry_t
+{
+    uint32_t hour;      // UTC epoch of the start of the hour
+    uint32_t first;     // Local epoch of the first sample
+    uint32_t last;      // Local epoch of the last sample
+    uint32_t samples;   // Number of samples in the hour's files
+    uint32_t size;      // Total size of the hour's files (bytes)
+    uint8_t  formats;   // Bit (1 << log_format_t) set for each file
+} log_catalog_entry_t;
+
+// Values summarised in a rollup: accel x/y/z, gyro x/y/z and temperature,
+//   then each ADC channel
+#define LOG_ROLLUP_VALUES   (7 + LOGGER_MAX_ADC_CHANNELS)
+
+// One minute of samples summarised, kept in a file alongside each log file.
+//   MPU values are int16_t and ADC values uint16_t, both stored as raw bits.
+typedef struct __attribute__((packed)) log_rollup_t
+{
+    uint32_t minute;    // Local epoch of the start of the minute
+    uint16_t count;     // Number of samples in the minute
+    uint8_t  channels;  // Number of ADC channels, later values are unused
+    uint16_t min[LOG_ROLLUP_VALUES];
+    uint16_t max[LOG_ROLLUP_VALUES];
+    uint16_t mean[LOG_ROLLUP_VALUES];
+} log_rollup_t;
+
+// Header at the start of every binary log file, followed by packed records
+typedef struct __attribute__((packed)) log_bin_header_t
+{
+    char     magic[4];        // LOG_BIN_MAGIC, not null terminated
+    uint8_t  version;         // LOG_BIN_VERSION
+    uint8_t  header_size;     // sizeof(log_bin_header_t)
+    uint16_t record_size;     // Bytes per record
+    char     device_name[CONFIG_STRING_LEN];
+    uint16_t poll_rate;       // Sample period (ms)
+    uint8_t  channel_bottom;
+    uint8_t  channel_top;
+    uint8_t  channel_count;   // ADC readings per record
+    uint8_t  mpu_id;
+    uint8_t  accel_range;     // Accelerometer full scale (+/- g)
+    uint16_t gyro_range;      // Gyro full scale (+/- deg/s)
+    int8_t   timezone;        // Offset of record timestamps from UTC (hours)
+    uint8_t  adc_bits;        // Resolution of ADC readings, since version 2
+    uint16_t channel_mask;    // ADC channels in each record, lowest first, since version 2
+} log_bin_header_t;
+
+// Header at the start of every IMU sample file, followed by mpu_sample_t
+//   records from the MPU 6050's FIFO
+typedef struct __attribute__((packed)) log_imu_header_t
+{
+    char     magic[4];        // LOG_IMU_MAGIC, not null terminated
+    uint8_t  version;         // LOG_IMU_VERSION
+    uint8_t  header_size;     // sizeof(log_imu_header_t)
+    uint16_t record_size;     // sizeof(mpu_sample_t)
+    uint16_t rate;            // Sample rate (Hz)
+    uint8_t  mpu_id;
+    uint8_t  accel_range;     // Accelerometer full scale (+/- g)
+    uint16_t gyro_range;      // Gyro full scale (+/- deg/s)
+} log_imu_header_t;
+
+// Header at the start of every ADC scan file, followed by log_scan_block_t
+//   records
+typedef struct __attribute__((packed)) log_scan_header_t
+{
+    char     magic[4];        // LOG_SCAN_MAGIC, not null terminated
+    uint8_t  version;         // LOG_SCAN_VERSION
+    uint8_t  header_size;     // sizeof(log_scan_header_t)
+    uint16_t block_header_size; // Bytes in a block before its readings
+} log_scan_header_t;
+
+// Block of scans from the hardware triggered ADC scan. Each block describes
+//   itself, as the scan may be restarted with other settings in the hour.
+//   Only the first `scans * channel_count` readings are written, one scan
+//   after another in channel order. Fields are laid out without padding, as
+//   for log_entry_t, so blocks are written as they are.
+typedef struct log_scan_block_t
+{
+    uint32_t time;            // Local epoch of the first scan
+    uint16_t millis;          // Milliseconds past `time`
+    uint16_t rate;            // Scans per second
+    uint32_t seq;             // Block number since the scan started, gaps are lost blocks
+    uint16_t channel_mask;    // ADC channels in each scan, lowest first
+    uint8_t  channel_count;
+    uint8_t  adc_bits;        // Resolution of the readings
+    uint16_t scans;           // Scans in the block
+    uint16_t adc_data[ADC_SCAN_BLOCK * LOGGER_MAX_ADC_CHANNELS];
+} log_scan_block_t;
+
+// Bytes written for a scan block
+#define LOG_SCAN_BLOCK_SIZE(block) \
+    (offsetof(log_scan_block_t, adc_data) + (block)->scans * (block)->channel_count * sizeof(uint16_t))
+
 /*
  * Name:    storge_init
  *  return: true if successfully communicating with SD card
@@ -83,35 +246,181 @@ float storage_configGetNum(config_keys_t option);
  */
 char* storage_configGetString(config_keys_t option);
 
+/*
+ * Name:    storage_logFormat
+ *  return: format that data passed to storage_addToLogFile must be in
+ * Desc:    Get the format of the current log file, or the configured format
+ *            if no file is open.
+ */
+log_format_t storage_logFormat();
+
 /*
  * Name:    storage_addToLogFile
- *  text:   String to append to current log file
+ *  text:   String or binary record to append to current log file
  *  len:    max number of bytes to append
+ *  format: format of `text`, from storage_logFormat()
+ *  time:   local epoch of the sample, used to index the file
  *  return: True if len bytes were written to file
- * Desc:    Add data to the current logfile. The file is created and opened if
- *            needed and automatically swapped to a new file every hour.
+ * Desc:    Add data to the current logfile. The file is kept open and only
+ *            swapped for a new one when the hour rolls over or after an I/O
+ *            error. Data is buffered and written to the card in whole sectors.
  */
-bool storage_addToLogFile(char* text, uint16_t len);
+bool storage_addToLogFile(char* text, uint16_t len, log_format_t format, uint32_t time);
+
+/*
+ * Name:    storage_serviceLog
+ * Desc:    Flush buffered log data once it has been waiting for LOG_FLUSH_MS.
+ *            Should be called regularly from the main loop.
+ */
+void storage_serviceLog();
+
+/*
+ * Name:    storage_flushLog
+ *  return: true if all buffered log data was written and synced
+ * Desc:    Write any buffered log data to the card and sync the file.
+ */
+bool storage_flushLog();
 
 /*
  * Name:    storage_getLogFiles
  *  count:  pointer to variable to store number of logs found
  *  start:  get entries newer than this time
  *  end:    get entiries older than this
- * Desc:    Get a list of log entires within the provided range. If start or end
- *            is 0, return all entires. Array must be freed manually.
+ *  return: pointer to the first matching catalog entry
+ * Desc:    Get a list of log entires within the provided range from the log
+ *            catalog, sorted by hour. If start or end is 0, return all
+ *            entires. The entries must not be freed or modified.
+ */
+const log_catalog_entry_t* storage_getLogFiles(uint16_t* count, uint32_t start, uint32_t end);
+
+/*
+ * Name:    storage_catalogRebuild
+ *  return: true if the catalog was rebuilt and saved
+ * Desc:    Rebuild the log catalog by scanning the card for log files.
  */
-uint32_t* storage_getLogFiles(uint16_t* count, uint32_t start, uint32_t end);
+bool storage_catalogRebuild();
 
 /*
  * Name:    storage_getNextSample
- *  time:   epoch of hour file to get next sample from
+ *  time:   UTC epoch of the hour to get the next sample from, as in the log
+ *            catalog. The file is named for the hour in the configured
+ *            timezone.
  *  log:    log entry struct to populate
  *  return: true if a entry was aquired, else false (error, EOF, etc)
- * Desc:    Get the next entry for a given log file.
+ * Desc:    Get the next entry for a given log file. Both CSV and binary log
+ *            files are supported, and an hour with a file in each format is
+ *            read as one file, earliest samples first. Files are read in
+ *            blocks; malformed rows are skipped and a truncated final row is
+ *            ignored.
  */
 bool storage_getNextSample(uint32_t time, log_entry_t* log);
 
+/*
+ * Name:    storage_getSampleChannels
+ *  return: number of ADC channels in the last sample read
+ * Desc:    Get the number of ADC channels present in the last sample returned
+ *            by storage_getNextSample.
+ */
+uint8_t storage_getSampleChannels();
+
+/*
+ * Name:    storage_getSampleMask
+ *  return: ADC channels in the last sample read, lowest first
+ * Desc:    Get the channels the readings of the last sample returned by
+ *            storage_getNextSample are for, from the binary file's header or
+ *            the CSV file's latest mask comment.
+ */
+uint16_t storage_getSampleMask();
+
+/*
+ * Name:    storage_seekSample
+ *  time:   epoch of hour file to seek in, as for storage_getNextSample
+ *  sample_time: local epoch of the sample to seek to
+ *  millis: milliseconds into `sample_time`
+ *  return: true if a sample at or after the requested time was found
+ * Desc:    Position the reader so the next storage_getNextSample call returns
+ *            the first sample at or after the requested time. The hour's index
+ *            file is binary searched, so only about a second of samples is
+ *            walked through.
+ */
+bool storage_seekSample(uint32_t time, uint32_t sample_time, uint16_t millis);
+
+/*
+ * Name:    storage_seekSampleIndex
+ *  time:   epoch of hour file to seek in, as for storage_getNextSample
+ *  sample: number of the sample within the file, starting from 0
+ *  return: true if the file has that many samples
+ * Desc:    Position the reader so the next storage_getNextSample call returns
+ *            the given sample. Binary files are seeked to directly and CSV
+ *            files through the hour's index file.
+ */
+bool storage_seekSampleIndex(uint32_t time, uint32_t sample);
+
+/*
+ * Name:    storage_getSampleIndex
+ *  return: number of the sample the next storage_getNextSample call returns
+ * Desc:    After reaching the end of a file this is the number of samples in
+ *            the file.
+ */
+uint32_t storage_getSampleIndex();
+
+/*
+ * Name:    storage_addToImuFile
+ *  sample: IMU sample read from the FIFO
+ *  return: true if the sample was buffered or written
+ * Desc:    Add a sample to the hour's IMU file, kept alongside the log file
+ *            when `mpu_rate` is set. Samples are buffered and written with
+ *            the log.
+ */
+bool storage_addToImuFile(const mpu_sample_t* sample);
+
+/*
+ * Name:    storage_getImuSamples
+ *  time:   epoch of the hour, as for storage_getNextSample
+ *  first:  number of the first sample to read, from 0
+ *  out:    where to read the samples to
+ *  max:    most samples to read
+ *  return: number of samples read, 0 past the end or if the hour has no valid
+ *            IMU file
+ * Desc:    Read samples back from an hour's IMU file. Records are read at the
+ *            size the header gives, so files with longer records from newer
+ *            firmware still read. Samples still in the write buffer are seen
+ *            once written, within LOG_FLUSH_MS.
+ */
+uint16_t storage_getImuSamples(uint32_t time, uint32_t first, mpu_sample_t* out, uint16_t max);
+
+/*
+ * Name:    storage_addToScanFile
+ *  block:  block of scans from adc_scanNextBlock
+ *  return: true if the block was buffered or written
+ * Desc:    Add a block to the hour's ADC scan file (".scn"), kept alongside the
+ *            log file when `adc_scan_hz` is set. Blocks are buffered and
+ *            written with the log.
+ */
+bool storage_addToScanFile(const log_scan_block_t* block);
+
+/*
+ * Name:    storage_addToRollup
+ *  entry:  sample that has been logged
+ *  channels: number of ADC channels in the sample
+ * Desc:    Add a sample to the running per-minute rollup. Each minute is
+ *            written to the hour's rollup file once a sample from a later
+ *            minute arrives or the log file is closed.
+ */
+void storage_addToRollup(const log_entry_t* entry, uint8_t channels);
+
+/*
+ * Name:    storage_getNextRollup
+ *  start:  local epoch to start from
+ *  end:    local epoch to stop at
+ *  rollup: where to read the rollup to
+ *  return: true if a rollup was found
+ * Desc:    Get the first minute rollup at or after `start` and no later than
+ *            `end`, moving on through the hours in the log catalog. Reading
+ *            is fastest when called with increasing start times.
+ */
+bool storage_getNextRollup(uint32_t start, uint32_t end, log_rollup_t* rollup);
+
 /*
  * Name:    storage_console
  *  argc:   number of arguments
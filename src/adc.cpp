@@ -6,11 +6,111 @@
  */
 
 #include "adc.h"
+#include "adcplan.h"
+#include "adcscan.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <ADC.h>
+#include <DMAChannel.h>
 
-#define ADC_RES_BITS 13
+#include "logger.h"
+#include "oversample.h"
+#include "storage.h"
+
+#define ADC_NO_PIN ADCPLAN_NO_PIN
+#define ADC_MAX_CHANNELS ADCPLAN_MAX_CHANNELS
+
+// A DMA channel that links to another can count at most this many transfers
+#define ADC_SCAN_MAX_ITER 511
+
+// Readings taken to measure a profile
+#define ADC_PROFILE_RUNS 64
+
+// Trade-off between noise and conversion time, chosen with adc_profile
+typedef struct adc_profile_t
+{
+    const char* name;
+    uint8_t hw_bits;            // Resolution the ADCs convert at
+    uint8_t averaging;          // Conversions averaged by the ADCs themselves
+    uint8_t oversample;         // log2 of conversions adc_sample averages
+    uint8_t out_bits;           // Resolution of the readings returned
+    ADC_CONVERSION_SPEED conversion;
+    ADC_SAMPLING_SPEED sampling;
+} adc_profile_t;
+
+// Measured performance of a profile
+typedef struct adc_profile_stats_t
+{
+    float channel_us;           // Time for adc_sample to read one channel
+    float enob;                 // Effective number of bits from reading noise
+} adc_profile_stats_t;
+
+// Hardware triggered scan, see adc_scanStart
+typedef struct adc_scan_t
+{
+    volatile bool running;
+    bool used[2];               // ADCs with pins to convert
+    uint8_t irq;                // ADC whose DMA interrupts at the end of a block
+    uint8_t count;              // Channels in each scan
+    uint16_t rate;              // Scans per second
+    uint16_t block;             // Scans in each block
+    uint32_t sc1a[2][ADC_MAX_CHANNELS]; // Channel selects written after each conversion
+    adcscan_handoff_t handoff;  // Blocks passed from _scanISR to adc_scanNextBlock
+    uint16_t latest[ADC_MAX_CHANNELS];  // Recent scan, in channel order
+} adc_scan_t;
+
+/*
+ * Name:    _planBuild
+ *  plan:   set to the assignment
+ *  index:  channel indices, in output order
+ *  count:  number of channels
+ * Desc:    Look up each channel's pin and the ADCs that can reach it, then
+ *            pair them up with adcplan_build
+ */
+static void _planBuild(adc_plan_t* plan, const uint16_t* index, uint8_t count);
+
+/*
+ * Name:     _profileApply
+ *  profile: profile to configure both ADCs for
+ */
+static void _profileApply(const adc_profile_t* profile);
+
+/*
+ * Name:     _profileMeasure
+ *  stats:   set to the measured performance of the current profile
+ * Desc:     Time repeated readings of channel 0 and work out the effective
+ *             number of bits from their spread
+ */
+static void _profileMeasure(adc_profile_stats_t* stats);
+
+/*
+ * Name:    _scanSelect
+ *  adc:    0 or 1
+ *  pin:    pin to convert
+ *  sc1a:   set to the ADC's channel select value for the pin
+ *  mux:    set to the ADC's mux select (CFG2 MUXSEL) for the pin
+ *  return: true if the ADC can convert the pin
+ * Desc:    Find the register values for a pin by converting it once
+ */
+static bool _scanSelect(uint8_t adc, uint8_t pin, uint32_t* sc1a, uint32_t* mux);
+
+/*
+ * Name:    _scanSample
+ *  block:  block to read from, 0 or 1
+ *  scan:   scan within the block
+ *  out:    `count` readings in channel order
+ * Desc:    Reassemble one scan from the two ADCs' buffers
+ */
+static void _scanSample(uint8_t block, uint16_t scan, uint16_t* out);
+
+/*
+ * Name:    _scanISR
+ * Desc:    Called when half of the DMA buffer has been filled
+ * !!! CALLED BY DMA INTERRUPT !!!
+ */
+static void _scanISR();
 
 const uint8_t chan_order[] = { 9, 8, 7, 6, 3, 2, 1, 0, 19, 18, 17, 16, 15, 14, 20, 21};
 
@@ -24,16 +124,145 @@ const uint8_t _analog_to_pin[] = {
 
 uint8_t _channel_count = 1;
 uint16_t _print_samples = 0;
+uint32_t _conversion_errors = 0;
+
+// The first profile is the default
+const adc_profile_t _profiles[] =
+{
+    { "default", 16, 4,  0, 13, ADC_CONVERSION_SPEED::HIGH_SPEED,      ADC_SAMPLING_SPEED::HIGH_SPEED },
+    { "fast",    10, 1,  0, 10, ADC_CONVERSION_SPEED::VERY_HIGH_SPEED, ADC_SAMPLING_SPEED::VERY_HIGH_SPEED },
+    { "quiet",   16, 16, 3, 16, ADC_CONVERSION_SPEED::MED_SPEED,       ADC_SAMPLING_SPEED::MED_SPEED }
+};
+
+#define ADC_PROFILE_COUNT (sizeof(_profiles) / sizeof(_profiles[0]))
+
+ADC _adc;
+adc_plan_t _plan;
+
+const adc_profile_t* _profile = &_profiles[0];
+adc_profile_stats_t _profile_stats;
+
+// Results of a scan, written by DMA. Each ADC has two blocks, each of which
+//   is `block` scans of one result per pair.
+volatile uint16_t _scan_buf[2][2 * ADC_SCAN_BLOCK * ADC_MAX_CHANNELS];
+adc_scan_t _scan;
+
+// For each ADC, one channel moves results to _scan_buf and the other selects
+//   the next pin as soon as a result has been moved
+DMAChannel _dma_result[2];
+DMAChannel _dma_select[2];
+
+volatile uint32_t* const _adc_sc1a[] = { &ADC0_SC1A, &ADC1_SC1A };
+volatile uint32_t* const _adc_ra[] = { &ADC0_RA, &ADC1_RA };
+volatile uint32_t* const _adc_sc2[] = { &ADC0_SC2, &ADC1_SC2 };
+volatile uint32_t* const _adc_cfg2[] = { &ADC0_CFG2, &ADC1_CFG2 };
+const uint8_t _adc_dmamux[] = { DMAMUX_SOURCE_ADC0, DMAMUX_SOURCE_ADC1 };
 
 void adc_init(void)
 {
-    analogReadResolution(ADC_RES_BITS);
+    const char* name = storage_configGetString(CONFIG_ADC_PROFILE);
+
+    if (!adc_setProfile(name))
+    {
+        Serial.printf("Unknown ADC profile \"%s\", using \"%s\"\r\n", name, _profiles[0].name);
+        adc_setProfile(_profiles[0].name);
+    }
+}
+
+bool adc_setProfile(const char* name)
+{
+    if (_scan.running)
+        return false;
+
+    for (uint8_t i = 0; i < ADC_PROFILE_COUNT; i++)
+    {
+        if (!strcmp(name, _profiles[i].name))
+        {
+            _profile = &_profiles[i];
+            _profileApply(_profile);
+            _profileMeasure(&_profile_stats);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint8_t adc_resolution()
+{
+    return _profile->out_bits;
+}
+
+float adc_channelTime()
+{
+    return _profile_stats.channel_us;
 }
 
 void adc_sample(uint16_t* channels, uint8_t count)
 {
-    for (uint8_t i = 0; i < count; i++)
-        channels[i] = analogRead(_analog_to_pin[chan_order[i]]);
+    // Both ADCs belong to the scan while it runs
+    if (_scan.running)
+        return;
+
+    count = min(count, (uint8_t) ADC_MAX_CHANNELS);
+
+    // Build a new plan aside and publish it whole, so _plan is never seen
+    //   half built. The console refuses to sample while logging, so only one
+    //   context ever calls this at a time.
+    if (!adcplan_matches(&_plan, channels, count))
+    {
+        adc_plan_t plan;
+
+        _planBuild(&plan, channels, count);
+        _plan = plan;
+    }
+
+    uint32_t sums[ADC_MAX_CHANNELS] = { 0 };
+    uint16_t failed = 0;
+
+    for (uint16_t n = 0; n < (1U << _profile->oversample); n++)
+    {
+        for (uint8_t i = 0; i < _plan.pairs; i++)
+        {
+            const adc_pair_t* pair = &_plan.pair[i];
+            int32_t result[2];
+
+            if (pair->pin[0] != ADC_NO_PIN && pair->pin[1] != ADC_NO_PIN)
+            {
+                ADC::Sync_result sync = _adc.analogSynchronizedRead(pair->pin[0], pair->pin[1]);
+                result[0] = sync.result_adc0;
+                result[1] = sync.result_adc1;
+            }
+            else if (pair->pin[0] != ADC_NO_PIN)
+                result[0] = _adc.adc0->analogRead(pair->pin[0]);
+            else
+                result[1] = _adc.adc1->analogRead(pair->pin[1]);
+
+            for (uint8_t a = 0; a < 2; a++)
+            {
+                if (pair->pin[a] == ADC_NO_PIN)
+                    continue;
+
+                if (result[a] == ADC_ERROR_VALUE)
+                    failed |= 1 << pair->slot[a];
+                else
+                    sums[pair->slot[a]] += (uint16_t) result[a];
+            }
+        }
+    }
+
+    oversample_decimate(sums, channels, count, _profile->hw_bits, _profile->oversample, _profile->out_bits);
+
+    // A failed conversion would otherwise read as full scale, so report the
+    //   channel as 0 and count it
+    for (uint8_t i = 0; failed && i < count; i++)
+    {
+        if (failed & (1 << i))
+        {
+            channels[i] = 0;
+            _conversion_errors++;
+        }
+    }
 
     if (_print_samples)
     {
@@ -46,10 +275,335 @@ void adc_sample(uint16_t* channels, uint8_t count)
     }
 }
 
+static void _planBuild(adc_plan_t* plan, const uint16_t* index, uint8_t count)
+{
+    uint8_t pin[ADC_MAX_CHANNELS], reach[ADC_MAX_CHANNELS];
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        pin[i] = _analog_to_pin[chan_order[index[i] % ADC_MAX_CHANNELS]];
+        reach[i] = (_adc.adc0->checkPin(pin[i]) ? ADCPLAN_ON_ADC0 : 0) |
+                   (_adc.adc1->checkPin(pin[i]) ? ADCPLAN_ON_ADC1 : 0);
+    }
+
+    adcplan_build(plan, index, pin, reach, count);
+}
+
+bool adc_scanStart(const uint16_t* channels, uint8_t count, uint16_t rate)
+{
+    if (_scan.running || !rate || !count)
+        return false;
+
+    count = min(count, (uint8_t) ADC_MAX_CHANNELS);
+    _planBuild(&_plan, channels, count);
+
+    // Each pair must be converted before the PDB triggers the next. The
+    //   measured time per channel includes adc_sample's own overhead, so
+    //   this errs on the safe side.
+    float conversion_us = _profile_stats.channel_us / (1 << _profile->oversample);
+    if (!adcscan_rateFits(_plan.pairs, rate, conversion_us))
+    {
+        Serial.printf("ADC scan rate of %u Hz is too fast for %d conversions of %.1f us\r\n",
+                      rate, _plan.pairs, conversion_us);
+        return false;
+    }
+
+    // Both ADCs are triggered together, so each does one conversion per pair.
+    //   An ADC with nothing to convert in a pair converts one of its other
+    //   pins again, and an ADC with nothing to convert at all is left idle.
+    for (uint8_t a = 0; a < 2; a++)
+    {
+        uint8_t filler = ADC_NO_PIN;
+        uint32_t mux = 0;
+
+        for (uint8_t i = 0; i < _plan.pairs && filler == ADC_NO_PIN; i++)
+            filler = _plan.pair[i].pin[a];
+
+        _scan.used[a] = filler != ADC_NO_PIN;
+
+        for (uint8_t i = 0; _scan.used[a] && i < _plan.pairs; i++)
+        {
+            uint8_t pin = (_plan.pair[i].pin[a] == ADC_NO_PIN) ? filler : _plan.pair[i].pin[a];
+            uint32_t this_mux;
+
+            // DMA only writes the channel select, so every pin must share a mux
+            if (!_scanSelect(a, pin, &_scan.sc1a[a][i], &this_mux) || (i && this_mux != mux))
+            {
+                Serial.printf("ADC%d can't scan pin %d\r\n", a, pin);
+                return false;
+            }
+
+            mux = this_mux;
+        }
+
+        if (_scan.used[a])
+            *_adc_cfg2[a] = (*_adc_cfg2[a] & ~ADC_CFG2_MUXSEL) | mux;
+    }
+
+    // Find the fastest PDB clock that can count a whole trigger period
+    uint32_t triggers = (uint32_t) rate * _plan.pairs;
+    uint8_t prescale = 0;
+    while (prescale < 7 && F_BUS / (1UL << prescale) / triggers > 0xFFFF)
+        prescale++;
+
+    uint32_t mod = F_BUS / (1UL << prescale) / triggers;
+    if (!mod || mod > 0xFFFF)
+    {
+        Serial.println("ADC scan rate out of range");
+        return false;
+    }
+
+    // Blocks are as long as the DMA can count to
+    _scan.count = count;
+    _scan.rate = rate;
+    _scan.block = min((uint16_t) ADC_SCAN_BLOCK, (uint16_t) (ADC_SCAN_MAX_ITER / (2 * _plan.pairs)));
+    _scan.irq = _scan.used[0] ? 0 : 1;
+    memset(&_scan.handoff, 0, sizeof(_scan.handoff));
+    memset(_scan.latest, 0, sizeof(_scan.latest));
+
+    for (uint8_t a = 0; a < 2; a++)
+    {
+        if (!_scan.used[a])
+            continue;
+
+        // The first pin is selected up front, so the DMA's list starts at the
+        //   second and wraps around to the first
+        uint32_t first = _scan.sc1a[a][0];
+        memmove(_scan.sc1a[a], _scan.sc1a[a] + 1, (_plan.pairs - 1) * sizeof(uint32_t));
+        _scan.sc1a[a][_plan.pairs - 1] = first;
+
+        // Clear interrupts left over from the last scan
+        _dma_result[a].TCD->CSR = 0;
+        _dma_result[a].source((volatile uint16_t&) *_adc_ra[a]);
+        _dma_result[a].destinationBuffer(_scan_buf[a], 2 * _scan.block * _plan.pairs * sizeof(uint16_t));
+        _dma_result[a].triggerAtHardwareEvent(_adc_dmamux[a]);
+
+        _dma_select[a].sourceBuffer(_scan.sc1a[a], _plan.pairs * sizeof(uint32_t));
+        _dma_select[a].destination(*_adc_sc1a[a]);
+        _dma_select[a].triggerAtCompletionOf(_dma_result[a]);
+
+        if (a == _scan.irq)
+        {
+            _dma_result[a].attachInterrupt(_scanISR);
+            _dma_result[a].interruptAtHalf();
+            _dma_result[a].interruptAtCompletion();
+        }
+
+        // Conversions now wait for the PDB, and each result triggers the DMA
+        *_adc_sc2[a] |= ADC_SC2_ADTRG | ADC_SC2_DMAEN;
+        *_adc_sc1a[a] = first;
+
+        _dma_select[a].enable();
+        _dma_result[a].enable();
+    }
+
+    // One PDB trigger starts a conversion on both ADCs
+    SIM_SCGC6 |= SIM_SCGC6_PDB;
+    PDB0_MOD = mod - 1;
+    PDB0_IDLY = 0;
+    PDB0_CH0C1 = _scan.used[0] ? (PDB_CHnC1_TOS(1) | PDB_CHnC1_EN(1)) : 0;
+    PDB0_CH1C1 = _scan.used[1] ? (PDB_CHnC1_TOS(1) | PDB_CHnC1_EN(1)) : 0;
+    PDB0_SC = PDB_SC_TRGSEL(15) | PDB_SC_PDBEN | PDB_SC_CONT |
+              PDB_SC_PRESCALER(prescale) | PDB_SC_MULT(0) | PDB_SC_LDOK;
+
+    _scan.running = true;
+    PDB0_SC |= PDB_SC_SWTRIG;
+
+    return true;
+}
+
+void adc_scanStop()
+{
+    if (!_scan.running)
+        return;
+
+    PDB0_SC = 0;
+
+    for (uint8_t a = 0; a < 2; a++)
+    {
+        if (!_scan.used[a])
+            continue;
+
+        _dma_result[a].disable();
+        _dma_select[a].disable();
+        *_adc_sc2[a] &= ~(ADC_SC2_ADTRG | ADC_SC2_DMAEN);
+    }
+
+    _dma_result[_scan.irq].detachInterrupt();
+    _scan.running = false;
+}
+
+bool adc_scanRunning()
+{
+    return _scan.running;
+}
+
+void adc_scanLatest(uint16_t* channels, uint8_t count)
+{
+    memcpy(channels, _scan.latest, min(count, _scan.count) * sizeof(uint16_t));
+}
+
+uint16_t adc_scanNextBlock(uint16_t* out, uint32_t* seq)
+{
+    if (!_scan.running)
+        return 0;
+
+    int8_t half = adcscan_take(&_scan.handoff, seq);
+    if (half < 0)
+        return 0;
+
+    for (uint16_t s = 0; s < _scan.block; s++)
+        _scanSample(half, s, out + s * _scan.count);
+
+    return adcscan_release(&_scan.handoff, *seq) ? _scan.block : 0;
+}
+
+static void _profileApply(const adc_profile_t* profile)
+{
+    ADC_Module* modules[] = { _adc.adc0, _adc.adc1 };
+
+    for (uint8_t a = 0; a < 2; a++)
+    {
+        modules[a]->setResolution(profile->hw_bits);
+        modules[a]->setAveraging(profile->averaging);
+        modules[a]->setConversionSpeed(profile->conversion);
+        modules[a]->setSamplingSpeed(profile->sampling);
+    }
+
+    // Pin routing may have changed, so plan again on the next sample
+    _plan.count = 0;
+}
+
+static void _profileMeasure(adc_profile_stats_t* stats)
+{
+    uint16_t readings[ADC_PROFILE_RUNS];
+    uint16_t print_samples = _print_samples;
+
+    _print_samples = 0;
+    uint32_t start = micros();
+
+    for (uint16_t i = 0; i < ADC_PROFILE_RUNS; i++)
+    {
+        readings[i] = 0;
+        adc_sample(&readings[i], 1);
+    }
+
+    stats->channel_us = (float) (micros() - start) / ADC_PROFILE_RUNS;
+    _print_samples = print_samples;
+
+    float mean = 0, var = 0;
+    for (uint16_t i = 0; i < ADC_PROFILE_RUNS; i++)
+        mean += readings[i];
+    mean /= ADC_PROFILE_RUNS;
+
+    for (uint16_t i = 0; i < ADC_PROFILE_RUNS; i++)
+        var += (readings[i] - mean) * (readings[i] - mean);
+    var /= ADC_PROFILE_RUNS;
+
+    // Noise no larger than quantisation noise costs no bits
+    float noise = sqrtf(var * 12);
+    stats->enob = _profile->out_bits - (noise > 1 ? log2f(noise) : 0);
+}
+
+static bool _scanSelect(uint8_t adc, uint8_t pin, uint32_t* sc1a, uint32_t* mux)
+{
+    ADC_Module* module = adc ? _adc.adc1 : _adc.adc0;
+
+    if (!module->checkPin(pin) || !module->startSingleRead(pin))
+        return false;
+
+    *sc1a = *_adc_sc1a[adc] & ADC_SC1_ADCH(0x1F);
+    *mux = *_adc_cfg2[adc] & ADC_CFG2_MUXSEL;
+
+    while (!module->isComplete());
+    module->readSingle();
+
+    return true;
+}
+
+static void _scanSample(uint8_t block, uint16_t scan, uint16_t* out)
+{
+    uint16_t offset = adcscan_offset(_scan.block, _plan.pairs, block, scan);
+    uint32_t results[ADC_MAX_CHANNELS];
+
+    adcscan_unpack(&_plan, _scan_buf[0] + offset, _scan_buf[1] + offset, results);
+
+    // Each result is a single conversion, only hardware averaging applies
+    oversample_decimate(results, out, _scan.count, _profile->hw_bits, 0, _profile->out_bits);
+}
+
+static void _scanISR()
+{
+    DMAChannel* dma = &_dma_result[_scan.irq];
+    dma->clearInterrupt();
+
+    // Whichever half the DMA isn't writing to has just been filled
+    volatile uint16_t* second = _scan_buf[_scan.irq] + _scan.block * _plan.pairs;
+    uint8_t writing = ((volatile uint16_t*) dma->destinationAddress() < second) ? 0 : 1;
+
+    // The other ADC's last result may still be on its way, so take the scan
+    //   before it. Sample ISRs run at the same priority so this can't be torn.
+    _scanSample(writing ? 0 : 1, _scan.block - 2, _scan.latest);
+    adcscan_complete(&_scan.handoff, writing);
+}
+
 bool adc_console(uint8_t argc, char* argv[])
 {
+    if (!strcmp("profile", argv[1]))
+    {
+        if (logger_getState())
+        {
+            Serial.println("Stop sampling first!");
+            return false;
+        }
+
+        if (argc > 2)
+        {
+            if (!adc_setProfile(argv[2]))
+            {
+                Serial.printf("Unknown profile \"%s\"\r\n", argv[2]);
+                return false;
+            }
+
+            Serial.printf("Using \"%s\": %.1f us per channel, %.1f effective bits\r\n",
+                          _profile->name, _profile_stats.channel_us, _profile_stats.enob);
+            return true;
+        }
+
+        // Measure every profile, then go back to the current one
+        const adc_profile_t* current = _profile;
+        adc_profile_stats_t current_stats = _profile_stats;
+
+        Serial.println("Profile  Bits  HwAvg  SwAvg  us/chan  ENOB");
+        for (uint8_t i = 0; i < ADC_PROFILE_COUNT; i++)
+        {
+            adc_profile_stats_t stats;
+
+            _profile = &_profiles[i];
+            _profileApply(_profile);
+            _profileMeasure(&stats);
+
+            Serial.printf("%-8s %-5d %-6d %-6d %-8.1f %.1f%s\r\n", _profile->name,
+                          _profile->out_bits, _profile->averaging, 1 << _profile->oversample,
+                          stats.channel_us, stats.enob, _profile == current ? " *" : "");
+        }
+
+        _profile = current;
+        _profile_stats = current_stats;
+        _profileApply(_profile);
+
+        return true;
+    }
+
     if (!strcmp("init", argv[1]))
     {
+        // Measuring the profile samples, which the sample ISR may be doing
+        if (logger_getState())
+        {
+            Serial.println("Stop sampling first!");
+            return false;
+        }
+
         adc_init();
         Serial.println("ADC initialized!");
         return true;
@@ -63,21 +617,78 @@ bool adc_console(uint8_t argc, char* argv[])
             return false;
         }
 
-        uint16_t channels[16];
+        if (_scan.running)
+        {
+            Serial.println("ADC is busy scanning!");
+            return false;
+        }
+
+        // The sample ISR owns the ADCs and the plan while logging
+        if (logger_getState())
+        {
+            Serial.println("Stop sampling first!");
+            return false;
+        }
 
-        for (uint8_t i = 0; i < argc - 2; i++)
+        uint16_t channels[ADC_MAX_CHANNELS];
+        uint8_t count = min(argc - 2, ADC_MAX_CHANNELS);
+
+        for (uint8_t i = 0; i < count; i++)
             channels[i] = (uint16_t) atoi(argv[i + 2]);
         
-        adc_sample(channels, argc - 2);
+        adc_sample(channels, count);
 
         Serial.printf("[%" PRIu16, channels[0]);
-        for (uint8_t i = 1; i < argc - 2; i++)
+        for (uint8_t i = 1; i < count; i++)
             Serial.printf(", %" PRIu16, channels[i]);
         Serial.println("]");
 
         return true;
     }
 
+    if (!strcmp("plan", argv[1]))
+    {
+        Serial.printf("%d channels in %d conversions, %lu failed conversions\r\n",
+                      _plan.count, _plan.pairs, _conversion_errors);
+        Serial.println("ADC0  ADC1");
+
+        for (uint8_t i = 0; i < _plan.pairs; i++)
+        {
+            for (uint8_t a = 0; a < 2; a++)
+            {
+                if (_plan.pair[i].pin[a] == ADC_NO_PIN)
+                    Serial.print("-     ");
+                else
+                    Serial.printf("%-6d", _plan.index[_plan.pair[i].slot[a]]);
+            }
+            Serial.println();
+        }
+
+        return true;
+    }
+
+    if (!strcmp("scan", argv[1]))
+    {
+        if (!_scan.running)
+        {
+            Serial.println("Not scanning");
+            return true;
+        }
+
+        Serial.printf("Rate:     %d Hz\r\n", _scan.rate);
+        Serial.printf("Channels: %d in %d conversions per ADC\r\n", _scan.count, _plan.pairs);
+        Serial.printf("Block:    %d scans\r\n", _scan.block);
+        Serial.printf("Blocks:   %lu\r\n", _scan.handoff.blocks);
+        Serial.printf("Overruns: %lu\r\n", _scan.handoff.overruns);
+
+        Serial.printf("Latest:   [%" PRIu16, _scan.latest[0]);
+        for (uint8_t i = 1; i < _scan.count; i++)
+            Serial.printf(", %" PRIu16, _scan.latest[i]);
+        Serial.println("]");
+
+        return true;
+    }
+
     if (!strcmp("print", argv[1]))
     {
         if (argc < 3)
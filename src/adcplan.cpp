@@ -0,0 +1,74 @@
+/*
+ * File:    adcplan.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Assignment of ADC channels to the Teensy's two ADCs, so channels
+ *            can be converted two at a time. Only depends on the C library so
+ *            the pairing can be tested on a host.
+ */
+
+#include "adcplan.h"
+
+void adcplan_build(adc_plan_t* plan, const uint16_t* index, const uint8_t* pin,
+                   const uint8_t* reach, uint8_t count)
+{
+    uint8_t only0[ADCPLAN_MAX_CHANNELS], only1[ADCPLAN_MAX_CHANNELS], either[ADCPLAN_MAX_CHANNELS];
+    uint8_t n0 = 0, n1 = 0, ne = 0;
+
+    if (count > ADCPLAN_MAX_CHANNELS)
+        count = ADCPLAN_MAX_CHANNELS;
+
+    plan->count = count;
+    plan->pairs = 0;
+
+    // Sort channels by which ADCs can reach them
+    for (uint8_t i = 0; i < count; i++)
+    {
+        plan->index[i] = index[i];
+
+        if ((reach[i] & ADCPLAN_ON_ADC0) && (reach[i] & ADCPLAN_ON_ADC1))
+            either[ne++] = i;
+        else if (reach[i] & ADCPLAN_ON_ADC1)
+            only1[n1++] = i;
+        else
+            only0[n0++] = i;
+    }
+
+    // Then pair them up, most constrained first. Every pair takes at least one
+    //   channel, so there are never more pairs than channels.
+    uint8_t i0 = 0, i1 = 0, ie = 0;
+    while (i0 < n0 || i1 < n1 || ie < ne)
+    {
+        adc_pair_t* pair = &plan->pair[plan->pairs++];
+        int16_t slot[2] = { -1, -1 };
+
+        if (i0 < n0)
+            slot[0] = only0[i0++];
+        if (i1 < n1)
+            slot[1] = only1[i1++];
+        if (slot[0] < 0 && ie < ne)
+            slot[0] = either[ie++];
+        if (slot[1] < 0 && ie < ne)
+            slot[1] = either[ie++];
+
+        for (uint8_t a = 0; a < 2; a++)
+        {
+            pair->slot[a] = (slot[a] < 0) ? 0 : slot[a];
+            pair->pin[a] = (slot[a] < 0) ? ADCPLAN_NO_PIN : pin[slot[a]];
+        }
+    }
+}
+
+bool adcplan_matches(const adc_plan_t* plan, const uint16_t* index, uint8_t count)
+{
+    if (count != plan->count)
+        return false;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (plan->index[i] != index[i])
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * File:    adcscan.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Block hand-off and layout for the hardware triggered ADC scan. DMA
+ *            fills the two halves of each ADC's buffer in turn, one result
+ *            per pair in the plan for each scan. Only depends on the C
+ *            library so the hand-off can be tested on a host against a
+ *            simulated DMA.
+ */
+
+#include "adcscan.h"
+
+void adcscan_complete(adcscan_handoff_t* handoff, uint8_t writing)
+{
+    // Published before the count, so a reader that sees the new count sees
+    //   where the block is
+    handoff->newest = writing ? 0 : 1;
+    handoff->blocks = handoff->blocks + 1;
+}
+
+int8_t adcscan_take(adcscan_handoff_t* handoff, uint32_t* seq)
+{
+    uint32_t blocks = handoff->blocks;
+
+    if (blocks == handoff->read)
+        return -1;
+
+    // Only the newest block is still in the buffer. If another completes
+    //   before `newest` is read, adcscan_release throws the copy away.
+    handoff->overruns += blocks - handoff->read - 1;
+    handoff->read = blocks;
+    *seq = blocks - 1;
+
+    return handoff->newest;
+}
+
+bool adcscan_release(adcscan_handoff_t* handoff, uint32_t seq)
+{
+    // The DMA moves on to the block just taken once the next one completes
+    if (handoff->blocks != seq + 1)
+    {
+        handoff->overruns++;
+        return false;
+    }
+
+    return true;
+}
+
+uint16_t adcscan_offset(uint16_t block, uint8_t pairs, uint8_t half, uint16_t scan)
+{
+    return (half * block + scan) * pairs;
+}
+
+void adcscan_unpack(const adc_plan_t* plan, const volatile uint16_t* adc0,
+                    const volatile uint16_t* adc1, uint32_t* out)
+{
+    const volatile uint16_t* results[] = { adc0, adc1 };
+
+    for (uint8_t i = 0; i < plan->pairs; i++)
+    {
+        for (uint8_t a = 0; a < 2; a++)
+        {
+            if (plan->pair[i].pin[a] != ADCPLAN_NO_PIN)
+                out[plan->pair[i].slot[a]] = results[a][i];
+        }
+    }
+}
+
+bool adcscan_rateFits(uint8_t pairs, uint16_t rate, float conversion_us)
+{
+    return (float) pairs * conversion_us * rate <= 1e6f;
+}
@@ -8,7 +8,10 @@
 
 #include "bt.h"
 
+#include <TimeLib.h>
+
 #include "console.h"
+#include "frame.h"
 #include "mpu.h"
 #include "clock.h"
 
@@ -17,9 +20,47 @@
 #define RECV_BUF        128
 #define ASCII_BOT       0x20
 #define ASCII_TOP       0x7E
-#define MAX_ARGS        4
+#define MAX_ARGS        8
 #define FLUSH_RECV      while (HM_10_SERIAL.available()) HM_10_SERIAL.read()
 #define ACK_PERIOD      5000
+#define HM_10_MTU       20      // Bytes per BLE notification
+#define REPLY_MAX       64      // Longest single protocol reply write
+
+// Live batch payload that fills 5 notifications once framed and COBS encoded
+#define LIVE_BATCH_MAX  (5 * HM_10_MTU - FRAME_OVERHEAD - 2)
+
+// Bytes waiting in the TX queue above which the link is treated as falling
+//   behind: two full live frames, about 17 ms at 115200 baud. This used to
+//   be two FRAME_MAX_ENCODED frames, which grew from 206 to 334 bytes when
+//   FRAME_MAX_PAYLOAD was raised for rollups. The queue itself is much
+//   larger so that nothing has to block.
+#define TX_BACKLOG      (10 * HM_10_MTU)
+
+// A single frame of any size must not count as a backlog on its own, and
+//   the queue must have room for a frame on top of a backlog
+static_assert(TX_BACKLOG >= FRAME_MAX_ENCODED, "TX_BACKLOG must hold the largest frame");
+static_assert(BT_TX_BUF_LEN >= 4 * TX_BACKLOG, "BT_TX_BUF_LEN is too small for TX_BACKLOG");
+static_assert(offsetof(log_rollup_t, min) + 3 * LOG_ROLLUP_VALUES * sizeof(uint16_t) <= FRAME_MAX_PAYLOAD,
+              "rollups must fit in a frame");
+
+// Live feed decimation, raised when the link falls behind and lowered again
+//   once it has been keeping up for a while
+#define LIVE_DECIM_MAX      6       // Decimate by at most 2^6
+#define LIVE_RATE_HOLD_MS   1000    // Min time between decimation increases
+#define LIVE_RATE_RAISE_MS  5000    // Time without congestion before halving decimation
+#define LIVE_ACK_MARGIN_MS  500     // Lateness past the app's usual ack interval
+                                    //   taken as congestion
+
+#define XFER_BUDGET_US  2000    // Max time spent on a transfer per tick
+#define XFER_WINDOW     16      // Frames that may be sent before the app grants credit
+#define XFER_START_EPOCH 1000000000 // Smaller transfer starts are sample numbers
+
+// Gap between historical frames, adapted to keep the HM-10 from overflowing
+//   (it locks up and reboots if sent data faster than it can forward it)
+#define XFER_GAP_START_US   7000
+#define XFER_GAP_MIN_US     1000
+#define XFER_GAP_MAX_US     20000
+#define XFER_GAP_STEP_US    100
 
 typedef enum
 {
@@ -28,6 +69,60 @@ typedef enum
     BT_XFER
 } bt_states_t;
 
+typedef enum
+{
+    XFER_GET = 0,           // Whole hour file, see _proto_get
+    XFER_FILTER,            // Filtered query, see _proto_filter
+    XFER_ROLLUP             // Minute rollups, see _proto_rollup
+} bt_xfer_mode_t;
+
+// Historical transfer in progress, advanced a little each tick
+typedef struct bt_xfer_t
+{
+    uint32_t hour;          // UTC epoch of the hour file being sent
+    uint32_t next_send;     // micros() at which the next sample may be sent
+    uint32_t gap;           // Current gap between frames (us)
+    uint32_t sent;          // Number of samples sent so far
+    uint32_t count;         // Max number of samples to send, 0 for no limit
+    uint16_t credits;       // Frames the app has room for
+    bool stalled;           // Backed off, and the link hasn't caught up yet
+    bt_xfer_mode_t mode;
+
+    // Filtered queries and rollups
+    uint32_t end;           // Local epoch after which to stop
+    uint32_t reached;       // Local epoch to resume from
+    uint16_t mask;          // ADC channels to send, bit n for channel n
+    uint16_t decimate;      // Check 1 in this many samples
+    uint16_t skip;          // Samples left to skip before the next check
+    uint16_t adc_over;      // Send if any masked channel is above this, 0 to ignore
+    uint32_t accel_over;    // Send if accel magnitude squared is above this, 0 to ignore
+} bt_xfer_t;
+
+// Live samples waiting to be sent together in one frame
+typedef struct bt_live_batch_t
+{
+    uint8_t payload[LIVE_BATCH_MAX];
+    uint16_t len;           // Bytes used in payload, 0 if empty
+    uint32_t started;       // millis() when the first sample was added
+    log_entry_t last;       // Previous sample, deltas are taken from it
+} bt_live_batch_t;
+
+// Live feed rate controller, averages samples together when decimating
+typedef struct bt_live_rate_t
+{
+    uint8_t shift;          // Live feed carries 1 in 2^shift samples
+    uint8_t count;          // Samples summed so far
+    int32_t accel[3];       // Sums of the samples being averaged
+    int32_t gyro[3];
+    int32_t temp;
+    int32_t adc[LOGGER_MAX_ADC_CHANNELS];
+    uint32_t last_change;       // millis() of the last decimation change
+    uint32_t last_congestion;   // millis() of the last sign of congestion
+    uint32_t ack_interval;      // Average time between acks (ms), 0 until measured
+    bool acked;                 // An ack has arrived since live mode started
+    uint32_t dropped;           // Frames dropped because the UART was full
+} bt_live_rate_t;
+
 /*
  * Name:    _handleCommand
  *  command: command string to parse and run
@@ -35,6 +130,150 @@ typedef enum
  */
 static void _handleCommand(char* command);
 
+/*
+ * Name:    _serviceXfer
+ * Desc:    Send historical samples until the per-tick time budget is used up or
+ *            the next sample is not due yet. Ends the transfer at end of file.
+ */
+static void _serviceXfer();
+
+/*
+ * Name:    _xferStalled
+ * Desc:    Slow a transfer down when the app runs out of credit or the UART
+ *            backs up
+ */
+static void _xferStalled();
+
+/*
+ * Name:    _nextXferSample
+ *  log:    where to read the sample to
+ *  return: true if a sample was read, false at the end of the transfer
+ * Desc:    Read the next sample of a transfer. Queries move on through the
+ *            following hours until the end of their range.
+ */
+static bool _nextXferSample(log_entry_t* log);
+
+/*
+ * Name:    _nextXferHour
+ *  return: true if a later hour with samples in the query's range was found
+ * Desc:    Move a query on to the next hour in the log catalog after
+ *            `_xfer.hour`, so hours without log files cost nothing
+ */
+static bool _nextXferHour();
+
+/*
+ * Name:    _filterMatch
+ *  log:    sample to check
+ *  return: true if the sample should be sent for the current query
+ */
+static bool _filterMatch(const log_entry_t* log);
+
+/*
+ * Name:      _filterReadings
+ *  channels: number of ADC readings in the sample
+ *  return:   mask of the readings, by position in the sample, that are on the
+ *              query's channels
+ * Desc:      Map the query's mask, which is by channel number, through the
+ *              channels the sample holds
+ */
+static uint16_t _filterReadings(uint8_t channels);
+
+/*
+ * Name:    _sendFiltered
+ *  log:    sample to send
+ *  channels: number of ADC channels in the sample
+ * Desc:    Send a sample with only the query's masked ADC channels
+ */
+static void _sendFiltered(const log_entry_t* log, uint8_t channels);
+
+/*
+ * Name:    _sendRollup
+ *  return: true if a rollup was sent, false if there are no more in range
+ * Desc:    Send the next minute rollup of a rollup transfer
+ */
+static bool _sendRollup();
+
+/*
+ * Name:    _endXfer
+ * Desc:    Tell the app how many samples were sent and where to resume from,
+ *            then end the transfer.
+ */
+static void _endXfer();
+
+/*
+ * Name:    _flushLive
+ * Desc:    Send the pending live batch, if any
+ */
+static void _flushLive();
+
+/*
+ * Name:    _queueLive
+ *  sample: sample to add
+ * Desc:    Add a sample to the live batch, sending the batch first if full
+ */
+static void _queueLive(const log_entry_t* sample);
+
+/*
+ * Name:    _liveCongested
+ * Desc:    Note that the live link is falling behind and raise decimation if
+ *            it has not just been raised.
+ */
+static void _liveCongested();
+
+/*
+ * Name:    _liveReset
+ *  shift:  decimation to use (live feed carries 1 in 2^shift samples)
+ * Desc:    Set the live decimation and clear any partly averaged sample
+ */
+static void _liveReset(uint8_t shift);
+
+/*
+ * Name:    _encodeDelta
+ *  out:    where to write the delta
+ *  sample: sample to encode
+ *  prev:   previous sample
+ *  channels: number of ADC channels
+ *  return: number of bytes written, 0 if the sample can't be delta encoded
+ * Desc:    Encode a sample as differences from the previous one
+ */
+static uint16_t _encodeDelta(uint8_t* out, const log_entry_t* sample, const log_entry_t* prev, uint8_t channels);
+
+/*
+ * Name:    _txPending
+ *  return: number of bytes queued but not yet sent by the UART
+ */
+static uint16_t _txPending();
+
+/*
+ * Name:    _reply
+ *  format: printf style format string
+ * Desc:    Send a protocol reply. Replies are short and must not be dropped,
+ *            so this waits for queue space in the rare case there is none
+ *            and counts the time spent as stall time.
+ */
+static void _reply(const char* format, ...);
+
+/*
+ * Name:    _sendFrame
+ *  type:   frame type
+ *  seq:    sequence number
+ *  payload: payload bytes
+ *  len:    payload length
+ *  return: true if queued, false if there was no room for the whole frame
+ * Desc:    Encode and queue a frame to the app without waiting
+ */
+static bool _sendFrame(frame_type_t type, uint16_t seq, const void* payload, uint16_t len);
+
+/*
+ * Name:    _sendSampleFrame
+ *  type:   frame type
+ *  seq:    sequence number
+ *  sample: sample to send
+ *  channels: number of ADC channels to include
+ * Desc:    Send a sample as a frame
+ */
+static void _sendSampleFrame(frame_type_t type, uint16_t seq, log_entry_t* sample, uint8_t channels);
+
 /*
  * BLUETOOTH PROTOCOL FUNCTIONS
  * - See "Foot App Function Spec" on Google Drive for descriptions
@@ -45,6 +284,11 @@ static bool _proto_rtc(uint8_t argc, char* argv[]);
 static bool _proto_live(uint8_t argc, char* argv[]);
 static bool _proto_query(uint8_t argc, char* argv[]);
 static bool _proto_get(uint8_t argc, char* argv[]);
+static bool _proto_credit(uint8_t argc, char* argv[]);
+static bool _proto_rate(uint8_t argc, char* argv[]);
+static bool _proto_filter(uint8_t argc, char* argv[]);
+static bool _proto_rollup(uint8_t argc, char* argv[]);
+static bool _proto_channels(uint8_t argc, char* argv[]);
 
 const console_command_t _bt_proto[] =
 {
@@ -54,16 +298,33 @@ const console_command_t _bt_proto[] =
     { "lon", _proto_live },
     { "loff", _proto_live },
     { "qry", _proto_query },
-    { "get", _proto_get }
+    { "get", _proto_get },
+    { "crd", _proto_credit },
+    { "lrt", _proto_rate },
+    { "flt", _proto_filter },
+    { "rol", _proto_rollup },
+    { "chn", _proto_channels }
 };
 
 char _recv_buf[RECV_BUF];
 bt_states_t _state = BT_IDLE;
 uint32_t _last_ack = 0;
+uint16_t _live_seq = 0;
+bt_live_batch_t _live;
+bt_live_rate_t _live_rate;
+bt_xfer_t _xfer;
+
+uint8_t _tx_buf[BT_TX_BUF_LEN];
+uint16_t _tx_capacity = 0;
+uint32_t _tx_queued = 0;
+uint32_t _tx_rejected = 0;
+uint32_t _tx_stall_us = 0;
 
 void bt_init()
 {
     HM_10_SERIAL.begin(HM_10_BAUDRATE);
+    HM_10_SERIAL.addMemoryForWrite(_tx_buf, sizeof(_tx_buf));
+    _tx_capacity = HM_10_SERIAL.availableForWrite();
 
     FLUSH_RECV;
 }
@@ -84,6 +345,13 @@ bool bt_tick()
         if (byte == '\r')
             continue;
 
+        // During a transfer the app acks with a bare 'a' (not the "ack" command)
+        if (_state == BT_XFER && byte == 'a' && pos == _recv_buf && HM_10_SERIAL.peek() != 'c')
+        {
+            _last_ack = millis();
+            continue;
+        }
+
         if (byte == '\n')
         {
             *pos = '\0';
@@ -101,7 +369,7 @@ bool bt_tick()
             continue;
         }
 
-        if (byte >= ASCII_BOT && byte <= ASCII_TOP)
+        if (byte >= ASCII_BOT && byte <= ASCII_TOP && pos - _recv_buf < RECV_BUF - 1)
             *pos++ = byte;
     }
 
@@ -109,7 +377,36 @@ bool bt_tick()
     if (_state != BT_IDLE)
     {
         if (millis() - _last_ack > ACK_PERIOD)
+        {
+            if (_state == BT_XFER)
+                Serial.println("Acked out");
+
             _state = BT_IDLE;
+        }
+    }
+
+    if (_state == BT_XFER)
+        _serviceXfer();
+
+    // Send a partly filled live batch once it has waited long enough
+    if (_live.len && millis() - _live.started >= (uint32_t) storage_configGetNum(CONFIG_LIVE_FLUSH))
+        _flushLive();
+
+    if (_state == BT_LIVE)
+    {
+        uint32_t now = millis();
+
+        // Late acks mean the app is not getting data through in time
+        if (_live_rate.ack_interval && now - _last_ack > _live_rate.ack_interval + LIVE_ACK_MARGIN_MS)
+            _liveCongested();
+
+        // Try a higher rate once things have been calm for a while
+        if (_live_rate.shift && now - _live_rate.last_congestion > LIVE_RATE_RAISE_MS &&
+            now - _live_rate.last_change > LIVE_RATE_RAISE_MS)
+        {
+            _liveReset(_live_rate.shift - 1);
+            _live_rate.last_change = now;
+        }
     }
 
     return true;
@@ -122,12 +419,81 @@ bool bt_isLive()
 
 void bt_sendSample(log_entry_t* sample)
 {
-    HM_10_SERIAL.write((uint8_t*) sample, sizeof(*sample));
-    HM_10_SERIAL.write('#');
+    uint8_t channels = logger_channelCount();
+
+    // Sum samples until there are enough to average into one
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        _live_rate.accel[i] += sample->mpu_accel[i];
+        _live_rate.gyro[i] += sample->mpu_gyro[i];
+    }
+    _live_rate.temp += sample->mpu_temp;
+    for (uint8_t i = 0; i < channels; i++)
+        _live_rate.adc[i] += sample->adc_data[i];
+
+    if (++_live_rate.count < (1 << _live_rate.shift))
+        return;
+
+    // Averaged sample takes the latest timestamp
+    log_entry_t avg = *sample;
+    int32_t count = _live_rate.count;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        avg.mpu_accel[i] = _live_rate.accel[i] / count;
+        avg.mpu_gyro[i] = _live_rate.gyro[i] / count;
+    }
+    avg.mpu_temp = _live_rate.temp / count;
+    for (uint8_t i = 0; i < channels; i++)
+        avg.adc_data[i] = _live_rate.adc[i] / count;
+
+    _liveReset(_live_rate.shift);
+    _queueLive(&avg);
+}
+
+uint16_t bt_write(const void* data, uint16_t len, bool partial)
+{
+    uint16_t space = bt_writeSpace();
+
+    if (len > space)
+    {
+        uint16_t accepted = partial ? space : 0;
+
+        _tx_rejected += len - accepted;
+        len = accepted;
+    }
+
+    if (!len)
+        return 0;
+
+    HM_10_SERIAL.write((const uint8_t*) data, len);
+    _tx_queued += len;
+
+    return len;
+}
+
+uint16_t bt_writeSpace()
+{
+    return HM_10_SERIAL.availableForWrite();
 }
 
 bool bt_console(uint8_t argc, char* argv[])
 {
+    if (!strcmp("stats", argv[1]))
+    {
+        uint16_t pending = _txPending();
+
+        Serial.printf("TX queue: %u bytes (%u pending)\r\n", _tx_capacity, pending);
+        Serial.printf("Bytes queued: %lu\r\n", _tx_queued);
+        Serial.printf("Bytes sent: %lu\r\n", _tx_queued - pending);
+        Serial.printf("Bytes rejected: %lu\r\n", _tx_rejected);
+        Serial.printf("Stall time: %lu ms\r\n", _tx_stall_us / 1000);
+        Serial.printf("Live frames dropped: %lu\r\n", _live_rate.dropped);
+        Serial.printf("Live decimation: 1/%d\r\n", 1 << _live_rate.shift);
+
+        return true;
+    }
+
     if (!strcmp("at", argv[1]))
     {
         FLUSH_RECV;
@@ -176,6 +542,9 @@ void _handleCommand(char* command)
         }
         else if (was_space)
         {
+            if (argc == MAX_ARGS)
+                break;
+
             was_space = false;
             argv[argc] = cursor;
             argc++;
@@ -203,19 +572,32 @@ void _handleCommand(char* command)
 
 static bool _proto_ack(uint8_t argc, char* argv[])
 {
+    uint32_t now = millis();
+
     if (_state == BT_IDLE)
     {
-        HM_10_SERIAL.print("ok\r\n");
+        _reply("ok\r\n");
     }
 
-    _last_ack = millis();
+    // Learn how often the app acks, so a late ack can be told apart from the
+    //   app's own timing. The first ack after lon only starts the measurement.
+    if (_state == BT_LIVE && _live_rate.acked)
+    {
+        uint32_t interval = now - _last_ack;
+
+        _live_rate.ack_interval = _live_rate.ack_interval ? (3 * _live_rate.ack_interval + interval) / 4
+                                                          : interval;
+    }
+
+    _live_rate.acked = true;
+    _last_ack = now;
 
     return true;
 }
 
 static bool _proto_mpu(uint8_t argc, char* argv[])
 {
-    HM_10_SERIAL.printf("ok,%d,%d\r\n", mpu_getAccelRange(), mpu_getGyroRange());
+    _reply("ok,%d,%d\r\n", mpu_getAccelRange(), mpu_getGyroRange());
     
     return true;
 }
@@ -226,7 +608,7 @@ static bool _proto_rtc(uint8_t argc, char* argv[])
     {
         uint32_t time = atoi(argv[1]);
         clock_set(time);
-        HM_10_SERIAL.print("ok\r\n");
+        _reply("ok\r\n");
     }
 
     return true;
@@ -239,11 +621,18 @@ static bool _proto_live(uint8_t argc, char* argv[])
       case 'n':
         _last_ack = millis();
         _state = BT_LIVE;
+        _live.len = 0;
+        _liveReset(0);
+        _live_rate.last_change = millis();
+        _live_rate.last_congestion = millis();
+        _live_rate.ack_interval = 0;
+        _live_rate.acked = false;
         Serial.println("lon");
         break;
       case 'f':
         _state = BT_IDLE;
-        //HM_10_SERIAL.print("ok\r\n");
+        _live.len = 0;
+        //_reply("ok\r\n");
         break;
     }
 
@@ -252,7 +641,7 @@ static bool _proto_live(uint8_t argc, char* argv[])
 
 static bool _proto_query(uint8_t argc, char* argv[])
 {
-    uint32_t* data;
+    const log_catalog_entry_t* data;
     uint16_t len = 0;
     uint32_t start = 0, end = 0;
 
@@ -264,50 +653,500 @@ static bool _proto_query(uint8_t argc, char* argv[])
 
     data = storage_getLogFiles(&len, start, end);
 
-    Serial1.printf("ok,%d", len);
+    _reply("ok,%d", len);
     for (int i = 0; i < len; i++)
-        Serial1.printf(",%d", data[i]);
-    Serial1.printf("\r\n");
-
-    free(data);
+        _reply(",%lu", data[i].hour);
+    _reply("\r\n");
 
     return true;
 }
 
 static bool _proto_get(uint8_t argc, char* argv[])
 {
-    Serial.printf("argc: %d\r\n", argc);
     if (argc < 2)
         return false;
 
+    // get <hour> [start] [count], where start is a sample number or a local
+    //   epoch. Samples are sent from bt_tick so logging carries on meanwhile.
+    uint32_t start = (argc > 2) ? strtoul(argv[2], NULL, 10) : 0;
+
+    _xfer.hour = strtoul(argv[1], NULL, 10);
+    _xfer.next_send = micros();
+    _xfer.gap = XFER_GAP_START_US;
+    _xfer.sent = 0;
+    _xfer.count = (argc > 3) ? strtoul(argv[3], NULL, 10) : 0;
+    _xfer.credits = XFER_WINDOW;
+    _xfer.stalled = false;
+    _xfer.mode = XFER_GET;
     _state = BT_XFER;
     _last_ack = millis();
 
-    uint32_t time = atoi(argv[1]);
-    log_entry_t log;
+    bool found = (start >= XFER_START_EPOCH) ? storage_seekSample(_xfer.hour, start, 0)
+                                             : storage_seekSampleIndex(_xfer.hour, start);
 
-    FLUSH_RECV;
+    // Nothing to send, the end frame tells the app where the file ends
+    if (!found)
+        _endXfer();
 
-    while (storage_getNextSample(time, &log))
+    return true;
+}
+
+static void _xferStalled()
+{
+    // Back off once per stall rather than on every tick or frame until the
+    //   link catches up, as recovery is only XFER_GAP_STEP_US per frame
+    if (!_xfer.stalled)
+        _xfer.gap = min(_xfer.gap * 3 / 2, (uint32_t) XFER_GAP_MAX_US);
+
+    _xfer.stalled = true;
+}
+
+static void _serviceXfer()
+{
+    uint32_t start = micros();
+    log_entry_t log;
+
+    while (micros() - start < XFER_BUDGET_US && (int32_t) (micros() - _xfer.next_send) >= 0)
     {
-        
-        if (HM_10_SERIAL.read() == 'a')
+        // Wait for the app to grant more credit, or for the UART to catch up,
+        //   before reading the next sample
+        if (!_xfer.credits || bt_writeSpace() < FRAME_MAX_ENCODED)
         {
-            Serial.print("a");
-            _last_ack = millis();
+            _xferStalled();
+            _xfer.next_send = micros() + _xfer.gap;
+            return;
         }
 
-        if (millis() - _last_ack > ACK_PERIOD)
+        uint32_t index = storage_getSampleIndex();
+
+        if (_xfer.mode == XFER_ROLLUP)
         {
-            Serial.println("Acked out");
-            return false;
+            if (!_sendRollup())
+            {
+                _endXfer();
+                return;
+            }
+        }
+        else if ((_xfer.count && _xfer.sent >= _xfer.count) || !_nextXferSample(&log))
+        {
+            _endXfer();
+            return;
+        }
+        else if (_xfer.mode == XFER_FILTER)
+        {
+            // Samples that don't match cost no credit or gap
+            if (!_filterMatch(&log))
+                continue;
+
+            _sendFiltered(&log, storage_getSampleChannels());
+        }
+        else
+        {
+            // Sequence is the sample number so the app can resume from any
+            //   frame. It wraps at 65536, see FRAME_HIST.
+            _sendSampleFrame(FRAME_HIST, index, &log, storage_getSampleChannels());
+        }
+
+        _xfer.sent++;
+        _xfer.credits--;
+
+        // Back off if the UART is backing up, otherwise creep faster
+        if (_txPending() > TX_BACKLOG)
+            _xferStalled();
+        else
+        {
+            _xfer.stalled = false;
+            if (_xfer.gap > XFER_GAP_MIN_US + XFER_GAP_STEP_US)
+                _xfer.gap -= XFER_GAP_STEP_US;
         }
 
-        bt_sendSample(&log);
-        delay(7); // Need to wait a bit or HM-10 will lock of and reboot
+        _xfer.next_send = micros() + _xfer.gap;
     }
-    
+}
+
+static bool _proto_filter(uint8_t argc, char* argv[])
+{
+    if (argc < 3)
+        return false;
+
+    // flt <start> <end> [mask] [decimate] [adc over] [accel over], with times
+    //   as local epochs, the mask by channel number and thresholds in raw
+    //   sensor units
+    uint32_t start = strtoul(argv[1], NULL, 10);
+    uint32_t accel = (argc > 6) ? strtoul(argv[6], NULL, 10) : 0;
+
+    _xfer.next_send = micros();
+    _xfer.gap = XFER_GAP_START_US;
+    _xfer.sent = 0;
+    _xfer.count = 0;
+    _xfer.credits = XFER_WINDOW;
+    _xfer.stalled = false;
+    _xfer.mode = XFER_FILTER;
+    _xfer.end = strtoul(argv[2], NULL, 10);
+    _xfer.reached = start;
+    _xfer.mask = (argc > 3) ? strtoul(argv[3], NULL, 0) : 0xFFFF;
+    _xfer.decimate = (argc > 4) ? max(strtoul(argv[4], NULL, 10), 1UL) : 1;
+    _xfer.skip = 0;
+    _xfer.adc_over = (argc > 5) ? strtoul(argv[5], NULL, 10) : 0;
+    _xfer.accel_over = min(accel, (uint32_t) INT16_MAX);
+    _xfer.accel_over *= _xfer.accel_over;
+    _state = BT_XFER;
+    _last_ack = millis();
+
+    // Seek to the start in the first hour with samples in the range
+    _xfer.hour = 0;
+    while (_nextXferHour())
+    {
+        if (storage_seekSample(_xfer.hour, start, 0))
+            return true;
+    }
+
+    _endXfer();
+    return true;
+}
+
+static bool _nextXferSample(log_entry_t* log)
+{
+    if (_xfer.mode == XFER_GET)
+        return storage_getNextSample(_xfer.hour, log);
+
+    while (!storage_getNextSample(_xfer.hour, log))
+    {
+        // Only the first hour can start part way through, later ones are
+        //   read from their first sample
+        do
+        {
+            if (!_nextXferHour())
+                return false;
+        } while (!storage_seekSampleIndex(_xfer.hour, 0));
+    }
+
+    _xfer.reached = log->time;
+    return log->time <= _xfer.end;
+}
+
+static bool _nextXferHour()
+{
+    uint16_t count;
+    const log_catalog_entry_t* entry = storage_getLogFiles(&count, _xfer.hour + 1, UINT32_MAX - 1);
+
+    // Catalog hours are in order, so the first one starting after the range
+    //   ends the search
+    for (uint16_t i = 0; i < count && entry[i].first <= _xfer.end; i++)
+    {
+        if (entry[i].samples && entry[i].last >= _xfer.reached)
+        {
+            _xfer.hour = entry[i].hour;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool _filterMatch(const log_entry_t* log)
+{
+    if (_xfer.skip)
+    {
+        _xfer.skip--;
+        return false;
+    }
+
+    _xfer.skip = _xfer.decimate - 1;
+
+    if (_xfer.adc_over)
+    {
+        uint8_t channels = storage_getSampleChannels();
+        uint16_t readings = _filterReadings(channels);
+        bool over = false;
+
+        for (uint8_t i = 0; i < channels && !over; i++)
+            over = (readings & (1 << i)) && log->adc_data[i] > _xfer.adc_over;
+
+        if (!over)
+            return false;
+    }
+
+    if (_xfer.accel_over)
+    {
+        uint32_t mag = 0;
+
+        for (uint8_t i = 0; i < 3; i++)
+            mag += (int32_t) log->mpu_accel[i] * log->mpu_accel[i];
+
+        if (mag <= _xfer.accel_over)
+            return false;
+    }
+
+    return true;
+}
+
+static uint16_t _filterReadings(uint8_t channels)
+{
+    uint16_t held = storage_getSampleMask();
+    uint16_t readings = 0;
+
+    // Readings are lowest channel first
+    for (uint8_t ch = 0, i = 0; ch < 16 && i < channels; ch++)
+    {
+        if (!(held & (1 << ch)))
+            continue;
+
+        if (_xfer.mask & (1 << ch))
+            readings |= 1 << i;
+        i++;
+    }
+
+    return readings;
+}
+
+static void _sendFiltered(const log_entry_t* log, uint8_t channels)
+{
+    uint8_t payload[sizeof(log_entry_t)];
+    uint16_t len = offsetof(log_entry_t, adc_data);
+    uint16_t readings = _filterReadings(channels);
+
+    memcpy(payload, log, len);
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        if (readings & (1 << i))
+        {
+            memcpy(payload + len, &log->adc_data[i], sizeof(log->adc_data[i]));
+            len += sizeof(log->adc_data[i]);
+        }
+    }
+
+    _sendFrame(FRAME_QUERY, _xfer.sent, payload, len);
+}
+
+static bool _proto_rollup(uint8_t argc, char* argv[])
+{
+    if (argc < 3)
+        return false;
+
+    // rol <start> <end>, as local epochs
+    _xfer.next_send = micros();
+    _xfer.gap = XFER_GAP_START_US;
+    _xfer.sent = 0;
+    _xfer.count = 0;
+    _xfer.credits = XFER_WINDOW;
+    _xfer.stalled = false;
+    _xfer.mode = XFER_ROLLUP;
+    _xfer.reached = strtoul(argv[1], NULL, 10);
+    _xfer.end = strtoul(argv[2], NULL, 10);
+    _state = BT_XFER;
+    _last_ack = millis();
+
+    return true;
+}
+
+static bool _sendRollup()
+{
+    log_rollup_t rollup;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint16_t len = offsetof(log_rollup_t, min);
+
+    if (!storage_getNextRollup(_xfer.reached, _xfer.end, &rollup))
+        return false;
+
+    _xfer.reached = rollup.minute + SECS_PER_MIN;
+
+    // Only send the values in use
+    uint16_t values = (7 + rollup.channels) * sizeof(rollup.min[0]);
+
+    memcpy(payload, &rollup, len);
+    memcpy(payload + len, rollup.min, values);
+    len += values;
+    memcpy(payload + len, rollup.max, values);
+    len += values;
+    memcpy(payload + len, rollup.mean, values);
+    len += values;
+
+    _sendFrame(FRAME_ROLLUP, _xfer.sent, payload, len);
+    return true;
+}
+
+static void _endXfer()
+{
+    // Queries and rollups resume by time rather than by sample number
+    uint32_t end[2] = { _xfer.sent, (_xfer.mode == XFER_GET) ? storage_getSampleIndex() : _xfer.reached };
+
+    Serial.printf("Sent %lu samples, next is %lu\r\n", end[0], end[1]);
+    _sendFrame(FRAME_END, _xfer.sent, end, sizeof(end));
     _state = BT_IDLE;
+}
+
+static bool _proto_rate(uint8_t argc, char* argv[])
+{
+    // Decimation factor and the resulting live sample period (ms)
+    uint32_t factor = 1UL << _live_rate.shift;
+    _reply("ok,%lu,%lu\r\n", factor, factor * (uint32_t) storage_configGetNum(CONFIG_POLL_RATE));
 
     return true;
 }
+
+static bool _proto_channels(uint8_t argc, char* argv[])
+{
+    // Mask of the channels in each sample, readings are lowest channel first
+    _reply("ok,%d\r\n", logger_channelMask());
+
+    return true;
+}
+
+static bool _proto_credit(uint8_t argc, char* argv[])
+{
+    if (argc < 2 || _state != BT_XFER)
+        return false;
+
+    // Credit also shows the app is still there
+    _xfer.credits = min(_xfer.credits + atoi(argv[1]), 0xFFFF);
+    _last_ack = millis();
+
+    return true;
+}
+
+static uint16_t _txPending()
+{
+    return _tx_capacity - bt_writeSpace();
+}
+
+static void _reply(const char* format, ...)
+{
+    char buf[REPLY_MAX];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    len = constrain(len, 0, (int) sizeof(buf) - 1);
+
+    // Only wait if the queue is completely backed up
+    if (bt_writeSpace() < len)
+    {
+        uint32_t start = micros();
+
+        while (bt_writeSpace() < len);
+
+        _tx_stall_us += micros() - start;
+    }
+
+    bt_write(buf, len);
+}
+
+static bool _sendFrame(frame_type_t type, uint16_t seq, const void* payload, uint16_t len)
+{
+    uint8_t frame[FRAME_MAX_ENCODED];
+    uint16_t frame_len = frame_encode(frame, type, seq, (const uint8_t*) payload, len);
+
+    return bt_write(frame, frame_len) == frame_len;
+}
+
+static void _sendSampleFrame(frame_type_t type, uint16_t seq, log_entry_t* sample, uint8_t channels)
+{
+    // Sample entries are laid out like binary log records
+    _sendFrame(type, seq, sample, LOG_BIN_RECORD_SIZE(channels));
+}
+
+static void _flushLive()
+{
+    uint8_t frame[FRAME_MAX_ENCODED];
+
+    if (!_live.len)
+        return;
+
+    uint16_t frame_len = frame_encode(frame, FRAME_LIVE, _live_seq++, _live.payload, _live.len);
+    _live.len = 0;
+
+    // Drop rather than block the logger if the UART can't take the frame
+    if (!bt_write(frame, frame_len))
+    {
+        _live_rate.dropped++;
+        _liveCongested();
+        return;
+    }
+
+    // A backlog building up means the HM-10 is not keeping up
+    if (_txPending() > TX_BACKLOG)
+        _liveCongested();
+}
+
+static void _queueLive(const log_entry_t* sample)
+{
+    uint8_t channels = logger_channelCount();
+
+    // Add to the current batch as a delta if it fits
+    if (_live.len && _live.payload[0] < UINT8_MAX && _live.payload[1] == channels)
+    {
+        uint8_t delta[5 + 5 * (7 + LOGGER_MAX_ADC_CHANNELS)];
+        uint16_t len = _encodeDelta(delta, sample, &_live.last, channels);
+
+        if (len && _live.len + len <= LIVE_BATCH_MAX)
+        {
+            memcpy(_live.payload + _live.len, delta, len);
+            _live.len += len;
+            _live.payload[0]++;
+            _live.last = *sample;
+            return;
+        }
+    }
+
+    // Otherwise start a new batch with the full sample
+    _flushLive();
+
+    _live.payload[0] = 1;
+    _live.payload[1] = channels;
+    memcpy(_live.payload + 2, sample, LOG_BIN_RECORD_SIZE(channels));
+    _live.len = 2 + LOG_BIN_RECORD_SIZE(channels);
+    _live.started = millis();
+    _live.last = *sample;
+}
+
+static void _liveCongested()
+{
+    uint32_t now = millis();
+
+    _live_rate.last_congestion = now;
+
+    if (_live_rate.shift < LIVE_DECIM_MAX && now - _live_rate.last_change >= LIVE_RATE_HOLD_MS)
+    {
+        _liveReset(_live_rate.shift + 1);
+        _live_rate.last_change = now;
+        Serial.printf("Live feed decimated 1/%d\r\n", 1 << _live_rate.shift);
+    }
+}
+
+static void _liveReset(uint8_t shift)
+{
+    _live_rate.shift = shift;
+    _live_rate.count = 0;
+    _live_rate.temp = 0;
+    memset(_live_rate.accel, 0, sizeof(_live_rate.accel));
+    memset(_live_rate.gyro, 0, sizeof(_live_rate.gyro));
+    memset(_live_rate.adc, 0, sizeof(_live_rate.adc));
+}
+
+static uint16_t _encodeDelta(uint8_t* out, const log_entry_t* sample, const log_entry_t* prev, uint8_t channels)
+{
+    int32_t dt = (int32_t) (sample->time - prev->time) * 1000 + sample->millis - prev->millis;
+    uint16_t len = 0;
+
+    // Time going backwards (e.g. clock set) needs a full sample
+    if (dt < 0)
+        return 0;
+
+    len += frame_putVarint(out + len, dt);
+
+    for (uint8_t i = 0; i < 3; i++)
+        len += frame_putVarint(out + len, frame_zigzag(sample->mpu_accel[i] - prev->mpu_accel[i]));
+
+    for (uint8_t i = 0; i < 3; i++)
+        len += frame_putVarint(out + len, frame_zigzag(sample->mpu_gyro[i] - prev->mpu_gyro[i]));
+
+    len += frame_putVarint(out + len, frame_zigzag(sample->mpu_temp - prev->mpu_temp));
+
+    for (uint8_t i = 0; i < channels; i++)
+        len += frame_putVarint(out + len, frame_zigzag(sample->adc_data[i] - prev->adc_data[i]));
+
+    return len;
+}
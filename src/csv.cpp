@@ -0,0 +1,226 @@
+/* 
+ * File:    csv.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Fast conversion between log entries and CSV log file rows.
+ */
+
+#include "csv.h"
+
+#include <string.h>
+
+// "00" through "99", for converting two digits at a time
+static const char _digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*
+ * Name:    _writeUint
+ *  out:    where to write the digits
+ *  val:    value to convert
+ *  return: pointer to the character after the last digit written
+ * Desc:    Write the decimal digits of an unsigned value
+ */
+static char* _writeUint(char* out, uint32_t val);
+
+/*
+ * Name:    _writeInt
+ *  out:    where to write the digits
+ *  val:    value to convert
+ *  return: pointer to the character after the last character written
+ * Desc:    Write a signed value in decimal with a leading '-' if negative
+ */
+static inline char* _writeInt(char* out, int32_t val);
+
+/*
+ * Name:    _readInt
+ *  curs:   cursor to read from, advanced past the value
+ *  end:    end of the row
+ *  val:    parsed value
+ *  return: true if at least one digit was read
+ * Desc:    Read an optionally negative decimal value
+ */
+static bool _readInt(const char** curs, const char* end, int32_t* val);
+
+uint16_t csv_formatRow(char* buf, const log_entry_t* entry, uint8_t channels)
+{
+    char* curs = _writeUint(buf, entry->time);
+    *curs++ = '.';
+
+    // Milliseconds are zero-padded to three digits
+    if (entry->millis < 1000)
+    {
+        *curs++ = '0' + entry->millis / 100;
+        memcpy(curs, &_digit_pairs[(entry->millis % 100) * 2], 2);
+        curs += 2;
+    }
+    else
+        curs = _writeUint(curs, entry->millis);
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        *curs++ = ',';
+        curs = _writeInt(curs, entry->mpu_accel[i]);
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        *curs++ = ',';
+        curs = _writeInt(curs, entry->mpu_gyro[i]);
+    }
+
+    *curs++ = ',';
+    curs = _writeInt(curs, entry->mpu_temp);
+
+    if (channels > LOGGER_MAX_ADC_CHANNELS)
+        channels = LOGGER_MAX_ADC_CHANNELS;
+
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        *curs++ = ',';
+        curs = _writeUint(curs, entry->adc_data[i]);
+    }
+
+    *curs++ = '\r';
+    *curs++ = '\n';
+
+    return curs - buf;
+}
+
+uint8_t csv_parseRow(const char* row, uint16_t len, log_entry_t* entry)
+{
+    const char* curs = row;
+    const char* end = row + len;
+    int16_t* mpu[] =
+    {
+        &entry->mpu_accel[0], &entry->mpu_accel[1], &entry->mpu_accel[2],
+        &entry->mpu_gyro[0], &entry->mpu_gyro[1], &entry->mpu_gyro[2],
+        &entry->mpu_temp
+    };
+    int32_t val;
+
+    memset(entry, 0, sizeof(*entry));
+
+    // Timestamp as "seconds.millis"
+    if (!_readInt(&curs, end, &val))
+        return 0;
+    entry->time = val;
+
+    if (curs == end || *curs++ != '.' || !_readInt(&curs, end, &val))
+        return 1;
+    entry->millis = val;
+
+    uint8_t count = 2;
+    for (uint8_t i = 0; i < 7; i++, count++)
+    {
+        if (curs == end || *curs++ != ',' || !_readInt(&curs, end, &val))
+            return count;
+        *mpu[i] = val;
+    }
+
+    for (uint8_t i = 0; i < LOGGER_MAX_ADC_CHANNELS; i++, count++)
+    {
+        if (curs == end || *curs++ != ',' || !_readInt(&curs, end, &val))
+            return count;
+        entry->adc_data[i] = val;
+    }
+
+    return count;
+}
+
+uint16_t csv_formatMask(char* buf, uint16_t mask)
+{
+    uint16_t len = sizeof(CSV_MASK_PREFIX) - 1;
+
+    memcpy(buf, CSV_MASK_PREFIX, len);
+    char* curs = _writeUint(buf + len, mask);
+    *curs++ = '\r';
+    *curs++ = '\n';
+
+    return curs - buf;
+}
+
+bool csv_parseComment(const char* row, uint16_t len, uint16_t* mask)
+{
+    uint16_t prefix = sizeof(CSV_MASK_PREFIX) - 1;
+    const char* curs = row + prefix;
+    int32_t val;
+
+    if (!len || *row != CSV_COMMENT)
+        return false;
+
+    // Other comments are skipped without changing the mask
+    if (len > prefix && !memcmp(row, CSV_MASK_PREFIX, prefix) &&
+        _readInt(&curs, row + len, &val) && curs == row + len && val >= 0 && val <= UINT16_MAX)
+        *mask = val;
+
+    return true;
+}
+
+static char* _writeUint(char* out, uint32_t val)
+{
+    char tmp[10];
+    char* curs = tmp + sizeof(tmp);
+
+    // Fill from the least significant end, two digits per division
+    while (val >= 100)
+    {
+        uint32_t rem = val % 100;
+        val /= 100;
+        curs -= 2;
+        memcpy(curs, &_digit_pairs[rem * 2], 2);
+    }
+
+    if (val >= 10)
+    {
+        curs -= 2;
+        memcpy(curs, &_digit_pairs[val * 2], 2);
+    }
+    else
+        *--curs = '0' + val;
+
+    uint8_t len = tmp + sizeof(tmp) - curs;
+    memcpy(out, curs, len);
+
+    return out + len;
+}
+
+static inline char* _writeInt(char* out, int32_t val)
+{
+    if (val < 0)
+    {
+        *out++ = '-';
+        return _writeUint(out, -(uint32_t) val);
+    }
+
+    return _writeUint(out, val);
+}
+
+static bool _readInt(const char** curs, const char* end, int32_t* val)
+{
+    const char* c = *curs;
+    bool negative = (c != end && *c == '-');
+    uint32_t result = 0;
+
+    if (negative)
+        c++;
+
+    const char* digits = c;
+    while (c != end && (uint8_t) (*c - '0') < 10)
+        result = result * 10 + (*c++ - '0');
+
+    if (c == digits)
+        return false;
+
+    *val = negative ? -(int32_t) result : (int32_t) result;
+    *curs = c;
+    return true;
+}
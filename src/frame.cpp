@@ -0,0 +1,147 @@
+/* 
+ * File:    frame.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Binary framing for data sent to the app over Bluetooth.
+ */
+
+#include "frame.h"
+
+#include <string.h>
+
+// CRC16-CCITT (polynomial 0x1021) lookup, one nibble at a time
+static const uint16_t _crc_table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t frame_crc16(const uint8_t* data, uint16_t len, uint16_t crc)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        crc = (crc << 4) ^ _crc_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ _crc_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+
+    return crc;
+}
+
+uint16_t frame_encode(uint8_t* out, uint8_t type, uint16_t seq, const uint8_t* payload, uint16_t len)
+{
+    uint8_t raw[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+
+    if (len > FRAME_MAX_PAYLOAD)
+        return 0;
+
+    // Little endian header, payload, then CRC of everything before it
+    raw[0] = type;
+    raw[1] = seq & 0xFF;
+    raw[2] = seq >> 8;
+    memcpy(raw + 3, payload, len);
+
+    uint16_t crc = frame_crc16(raw, len + 3, 0xFFFF);
+    raw[len + 3] = crc & 0xFF;
+    raw[len + 4] = crc >> 8;
+
+    // COBS: each block starts with the distance to the next zero
+    uint16_t raw_len = len + FRAME_OVERHEAD;
+    uint8_t* code = out;
+    uint8_t* curs = out + 1;
+    uint8_t run = 1;
+
+    for (uint16_t i = 0; i < raw_len; i++)
+    {
+        if (raw[i])
+        {
+            *curs++ = raw[i];
+            run++;
+        }
+
+        if (!raw[i] || run == 0xFF)
+        {
+            *code = run;
+            code = curs++;
+            run = 1;
+        }
+    }
+
+    *code = run;
+    *curs++ = 0x00;
+
+    return curs - out;
+}
+
+bool frame_decode(const uint8_t* in, uint16_t len, uint8_t* type, uint16_t* seq,
+                  uint8_t* payload, uint16_t* payload_len)
+{
+    uint8_t raw[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+    uint16_t raw_len = 0;
+    uint16_t i = 0;
+
+    while (i < len)
+    {
+        uint8_t run = in[i++];
+
+        if (!run || i + run - 1 > len)
+            return false;
+
+        for (uint8_t j = 1; j < run; j++)
+        {
+            if (!in[i] || raw_len == sizeof(raw))
+                return false;
+            raw[raw_len++] = in[i++];
+        }
+
+        // A zero follows every block except a full one or the last
+        if (run != 0xFF && i < len)
+        {
+            if (raw_len == sizeof(raw))
+                return false;
+            raw[raw_len++] = 0x00;
+        }
+    }
+
+    if (raw_len < FRAME_OVERHEAD)
+        return false;
+
+    uint16_t crc = raw[raw_len - 2] | (raw[raw_len - 1] << 8);
+    if (frame_crc16(raw, raw_len - 2, 0xFFFF) != crc)
+        return false;
+
+    *type = raw[0];
+    *seq = raw[1] | (raw[2] << 8);
+    *payload_len = raw_len - FRAME_OVERHEAD;
+    memcpy(payload, raw + 3, *payload_len);
+
+    return true;
+}
+
+uint8_t frame_putVarint(uint8_t* out, uint32_t val)
+{
+    uint8_t len = 0;
+
+    while (val >= 0x80)
+    {
+        out[len++] = (val & 0x7F) | 0x80;
+        val >>= 7;
+    }
+
+    out[len++] = val;
+    return len;
+}
+
+uint8_t frame_getVarint(const uint8_t* in, uint16_t len, uint32_t* val)
+{
+    *val = 0;
+
+    for (uint8_t i = 0; i < len && i < 5; i++)
+    {
+        *val |= (uint32_t) (in[i] & 0x7F) << (7 * i);
+
+        if (!(in[i] & 0x80))
+            return i + 1;
+    }
+
+    return 0;
+}
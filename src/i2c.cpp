@@ -0,0 +1,209 @@
+/*
+ * File:    i2c.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Interrupt driven register reads on I2C0, so sensors can be read
+ *            without waiting on the bus. Shares the bus with Wire: blocking
+ *            Wire users must hold the bus with i2c_acquire while they use it.
+ */
+
+#include "i2c.h"
+
+typedef enum
+{
+    I2C_IDLE = 0,
+    I2C_ADDR_WRITE,     // Address sent for writing the register number
+    I2C_REG,            // Register number sent
+    I2C_ADDR_READ,      // Address sent again after a repeated start to read
+    I2C_DATA            // Receiving data
+} i2c_state_t;
+
+// Transfer in progress, owned by the I2C interrupt while active
+typedef struct i2c_xfer_t
+{
+    volatile i2c_state_t state;
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t* buf;
+    uint8_t len;
+    uint8_t pos;            // Next byte of buf to receive
+    i2c_done_t done;
+    void* ctx;
+    uint32_t started;       // micros() when the transfer started
+} i2c_xfer_t;
+
+i2c_xfer_t _i2c;
+volatile bool _i2c_held = false;
+
+/*
+ * Name:    _i2cISR
+ * Desc:    Advance the transfer after each byte
+ * !!! CALLED BY I2C0 INTERRUPT !!!
+ */
+static void _i2cISR();
+
+/*
+ * Name:    _i2cFinish
+ *  ok:     true if the transfer completed
+ * Desc:    Stop the bus, release it and call the completion callback
+ */
+static void _i2cFinish(bool ok);
+
+void i2c_init()
+{
+    _i2c.state = I2C_IDLE;
+
+    // Wire only uses the interrupt as a slave, which we never are
+    attachInterruptVector(IRQ_I2C0, _i2cISR);
+    NVIC_SET_PRIORITY(IRQ_I2C0, I2C_IRQ_PRIORITY);
+    NVIC_ENABLE_IRQ(IRQ_I2C0);
+}
+
+bool i2c_readAsync(uint8_t addr, uint8_t reg, uint8_t* buf, uint8_t len, i2c_done_t done, void* ctx)
+{
+    if (!len || i2c_busy() || (I2C0_S & I2C_S_BUSY))
+        return false;
+
+    _i2c.addr = addr;
+    _i2c.reg = reg;
+    _i2c.buf = buf;
+    _i2c.len = len;
+    _i2c.pos = 0;
+    _i2c.done = done;
+    _i2c.ctx = ctx;
+    _i2c.started = micros();
+    _i2c.state = I2C_ADDR_WRITE;
+
+    // Generate a start and send the address, the rest happens in _i2cISR
+    I2C0_S = I2C_S_IICIF | I2C_S_ARBL;
+    I2C0_C1 = I2C_C1_IICEN | I2C_C1_IICIE | I2C_C1_MST | I2C_C1_TX;
+    I2C0_D = addr << 1;
+
+    return true;
+}
+
+bool i2c_busy()
+{
+    if (_i2c.state != I2C_IDLE && micros() - _i2c.started > I2C_TIMEOUT_US)
+    {
+        __disable_irq();
+        if (_i2c.state != I2C_IDLE)
+            _i2cFinish(false);
+        __enable_irq();
+    }
+
+    return _i2c.state != I2C_IDLE || _i2c_held;
+}
+
+bool i2c_acquire(uint32_t timeout_us)
+{
+    uint32_t start = micros();
+
+    while (true)
+    {
+        __disable_irq();
+        bool free = _i2c.state == I2C_IDLE && !_i2c_held;
+        if (free)
+            _i2c_held = true;
+        __enable_irq();
+
+        if (free)
+            return true;
+
+        // Also times out a stuck transfer
+        i2c_busy();
+
+        if (micros() - start >= timeout_us)
+            return false;
+    }
+}
+
+void i2c_release()
+{
+    _i2c_held = false;
+}
+
+static void _i2cISR()
+{
+    uint8_t status = I2C0_S;
+
+    I2C0_S = I2C_S_IICIF;
+
+    if (_i2c.state == I2C_IDLE)
+        return;
+
+    if (status & I2C_S_ARBL)
+    {
+        I2C0_S = I2C_S_ARBL;
+        _i2cFinish(false);
+        return;
+    }
+
+    // Every byte we send must be acknowledged
+    if (_i2c.state != I2C_DATA && (status & I2C_S_RXAK))
+    {
+        _i2cFinish(false);
+        return;
+    }
+
+    switch (_i2c.state)
+    {
+      case I2C_ADDR_WRITE:
+        _i2c.state = I2C_REG;
+        I2C0_D = _i2c.reg;
+        break;
+
+      case I2C_REG:
+      {
+        // Repeated start can't be generated with a frequency multiplier set
+        uint8_t f = I2C0_F;
+        I2C0_F = f & 0x3F;
+        I2C0_C1 |= I2C_C1_RSTA;
+        I2C0_F = f;
+
+        _i2c.state = I2C_ADDR_READ;
+        I2C0_D = (_i2c.addr << 1) | 1;
+        break;
+      }
+
+      case I2C_ADDR_READ:
+        // Switch to receive, NACKing straight away if only one byte is wanted
+        _i2c.state = I2C_DATA;
+        I2C0_C1 = I2C_C1_IICEN | I2C_C1_IICIE | I2C_C1_MST |
+                  ((_i2c.len == 1) ? I2C_C1_TXAK : 0);
+
+        // Dummy read starts receiving the first byte
+        (void) I2C0_D;
+        break;
+
+      case I2C_DATA:
+        if (_i2c.pos == _i2c.len - 1)
+        {
+            // Stop before reading the last byte so no more are clocked in
+            I2C0_C1 = I2C_C1_IICEN;
+            _i2c.buf[_i2c.pos++] = I2C0_D;
+            _i2cFinish(true);
+            return;
+        }
+
+        // NACK the last byte to tell the device the read is over
+        if (_i2c.pos == _i2c.len - 2)
+            I2C0_C1 |= I2C_C1_TXAK;
+
+        _i2c.buf[_i2c.pos++] = I2C0_D;
+        break;
+
+      default:
+        break;
+    }
+}
+
+static void _i2cFinish(bool ok)
+{
+    // Clearing MST generates a stop if we still hold the bus
+    I2C0_C1 = I2C_C1_IICEN;
+    _i2c.state = I2C_IDLE;
+
+    if (_i2c.done)
+        _i2c.done(ok, _i2c.ctx);
+}
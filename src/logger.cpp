@@ -11,11 +11,35 @@
 #include "adc.h"
 #include "bt.h"
 #include "clock.h"
+#include "csv.h"
+#include "i2c.h"
 #include "mpu.h"
+#include "ring.h"
 #include "storage.h"
 
-#define CIRC_BUF_LEN 40
-#define CSV_ROW_BUF_LEN 200
+#include <atomic>
+
+// Everything the sample ISR needs, built from the config by logger_loadConfig.
+//   A plan is never changed once published.
+typedef struct logger_plan_t
+{
+    uint32_t period_us;     // Sample timer period
+    uint16_t channel_mask;  // ADC channels sampled, one bit per channel index
+    uint8_t  channel_count;
+    uint16_t channels[LOGGER_MAX_ADC_CHANNELS]; // Channel index for each slot
+    uint16_t imu_rate;      // IMU FIFO rate (Hz), 0 to read with each sample
+    uint16_t scan_rate;     // ADC scan rate (Hz), 0 to convert with each sample
+    uint16_t record_size;   // Bytes in a binary record
+} logger_plan_t;
+
+// Sample ISR run time, in CPU cycles
+typedef struct logger_isr_stats_t
+{
+    uint32_t count;
+    uint32_t last;
+    uint32_t max;
+    uint64_t total;
+} logger_isr_stats_t;
 
 /*
  * Name:    _sampleISR
@@ -24,28 +48,166 @@
  */
 void _sampleISR();
 
+/*
+ * Name:    _imuDrain
+ * Desc:    Drain the IMU FIFO into the IMU buffer, timestamping each sample
+ *            from its position in the FIFO. Runs from the main loop, as the
+ *            FIFO reads wait on the bus.
+ */
+static void _imuDrain();
+
+/*
+ * Name:    _scanDrain
+ * Desc:    Copy the newest block from the hardware triggered ADC scan to the
+ *            hour's scan file, timestamping it from its block number
+ */
+static void _scanDrain();
+
+/*
+ * Name:    _channelMask
+ *  return: ADC channels to sample, one bit per channel index
+ * Desc:    Read the channel_mask setting, falling back to the range from
+ *            channel_bottom to channel_top if it selects no channels
+ */
+static uint16_t _channelMask();
+
+/*
+ * Name:    _planBuild
+ *  plan:   plan to fill in from the config
+ */
+static void _planBuild(logger_plan_t* plan);
+
+/*
+ * Name:    _planCheck
+ *  plan:   plan to check
+ *  scanning: true if the hardware scan is running
+ *  return: true if every channel can be converted well within the period
+ * Desc:    Unless scanning, every channel is converted in the sample ISR,
+ *            which must finish well before the next sample is due
+ */
+static bool _planCheck(const logger_plan_t* plan, bool scanning);
+
+/*
+ * Name:    _drain
+ * Desc:    Write out the samples left in the ring since sampling stopped, so
+ *            they keep the layout they were taken with. Samples the card
+ *            won't take are dropped.
+ */
+static void _drain();
+
+/*
+ * Name:    _mpuDone
+ *  ok:     true if the IMU sample was read
+ * Desc:    Publish the log entry waiting on an async IMU read
+ * !!! CALLED BY I2C0 INTERRUPT !!!
+ */
+void _mpuDone(bool ok);
+
 IntervalTimer _sample_timer;
 
-log_entry_t _circ_buf[CIRC_BUF_LEN];
-log_entry_t* _head = _circ_buf;
-log_entry_t* _tail = _circ_buf;
-bool _running = false;
+ring_t<log_entry_t, LOGGER_RING_LEN> _ring;
+ring_t<mpu_sample_t, LOGGER_IMU_RING_LEN> _imu_ring;
+volatile bool _running = false;
 
-void logger_startSampling()
+// Newest IMU sample, from the FIFO or the last async read, copied into log
+//   entries until the next one arrives
+mpu_sample_t _imu_latest;
+volatile bool _imu_running = false;
+uint32_t _next_imu_drain = 0;       // millis() of the next FIFO drain
+
+// Block being written to the scan file, and when the scan started (local ms)
+log_scan_block_t _scan_block;
+uint64_t _scan_start_ms = 0;
+
+// Entry reserved in the ring waiting on its IMU read
+log_entry_t* _mpu_entry = NULL;
+volatile bool _mpu_pending = false;
+volatile uint32_t _mpu_late = 0;     // Samples skipped as the last read was still going
+
+// The published plan is in one slot, the next is built in the other. The ISR
+//   never outlives a plan as the main loop can't run while it does.
+logger_plan_t _plans[2];
+std::atomic<const logger_plan_t*> _plan(&_plans[0]);
+
+// The plan in the other slot waits for the samples taken with the published
+//   one to be written
+bool _plan_pending = false;
+
+logger_isr_stats_t _isr_stats;
+
+void logger_loadConfig()
 {
-    static uint16_t last_period = 0;
-    uint16_t this_period = (uint16_t) storage_configGetNum(CONFIG_POLL_RATE);
+    const logger_plan_t* plan = _plan.load(std::memory_order_relaxed);
+    logger_plan_t* next = (plan == &_plans[0]) ? &_plans[1] : &_plans[0];
 
-    if (this_period != last_period)
+    _planBuild(next);
+    _plan_pending = false;
+
+    if (_running)
     {
-        if (!_sample_timer.begin(_sampleISR, this_period * 1000))
+        // Records already written must keep their layout
+        if (next->channel_mask != plan->channel_mask || next->imu_rate != plan->imu_rate ||
+            next->scan_rate != plan->scan_rate)
         {
-            Serial.println("Failed to start sample timer");
-            _running = false;
-            return;
+            Serial.println("Channel, IMU and scan changes apply when sampling restarts");
         }
 
-        last_period = this_period;
+        uint32_t period_us = next->period_us;
+        *next = *plan;
+        next->period_us = period_us;
+
+        if (!_planCheck(next, adc_scanRunning()))
+            return;
+    }
+    else if (_ring.peek() || _mpu_pending)
+    {
+        // Samples left in the ring are written with the published layout,
+        //   then logger_serviceBuffer publishes this plan
+        _plan_pending = true;
+        return;
+    }
+
+    _plan.store(next, std::memory_order_release);
+
+    // Takes effect from the next sample
+    if (_running && next->period_us != plan->period_us)
+        _sample_timer.update(next->period_us);
+}
+
+void logger_startSampling()
+{
+    if (_running)
+        return;
+
+    _drain();
+    logger_loadConfig();
+    const logger_plan_t* plan = _plan.load(std::memory_order_relaxed);
+
+    // Falls back to sampling with each row if the scan can't start, and
+    //   then the period must allow for the conversions
+    bool scanning = plan->scan_rate && adc_scanStart(plan->channels, plan->channel_count, plan->scan_rate);
+    if (scanning)
+        _scan_start_ms = (uint64_t) clock_getLocalNowSeconds() * 1000 + clock_millis();
+
+    if (!_planCheck(plan, scanning))
+        return;
+
+    memset(&_imu_latest, 0, sizeof(_imu_latest));
+    if (plan->imu_rate && mpu_startFifo(plan->imu_rate))
+    {
+        _next_imu_drain = millis() + LOGGER_IMU_DRAIN_MS;
+        _imu_running = true;
+    }
+
+    // Cycle counter for timing the ISR
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+
+    if (!_sample_timer.begin(_sampleISR, plan->period_us))
+    {
+        Serial.println("Failed to start sample timer");
+        logger_stopSampling();
+        return;
     }
 
     _running = true;
@@ -55,6 +217,14 @@ void logger_stopSampling()
 {
     _running = false;
     _sample_timer.end();
+
+    if (_imu_running)
+    {
+        _imu_running = false;
+        mpu_stopFifo();
+    }
+
+    adc_scanStop();
 }
 
 bool logger_getState()
@@ -62,6 +232,16 @@ bool logger_getState()
     return _running;
 }
 
+uint8_t logger_channelCount()
+{
+    return _plan.load(std::memory_order_relaxed)->channel_count;
+}
+
+uint16_t logger_channelMask()
+{
+    return _plan.load(std::memory_order_relaxed)->channel_mask;
+}
+
 void logger_serviceBuffer()
 {
     /* 14 * 1       timestamp
@@ -70,52 +250,347 @@ void logger_serviceBuffer()
        1  * 18      comma separators
      = ~128 bytes per csv row (~4.5 MB/hr @ 10 hz, max 7 MB/hr) */
 
-    if (_tail == _head)
+    if (_imu_running && (int32_t) (millis() - _next_imu_drain) >= 0)
+    {
+        _next_imu_drain = millis() + LOGGER_IMU_DRAIN_MS;
+        _imuDrain();
+    }
+
+    // IMU samples are small, so write out everything that is waiting
+    mpu_sample_t* imu;
+    while ((imu = _imu_ring.peek()) && storage_addToImuFile(imu))
+        _imu_ring.pop();
+
+    if (adc_scanRunning())
+        _scanDrain();
+
+    log_entry_t* entry = _ring.peek();
+    if (!entry)
+    {
+        // The last sample with the old layout is written
+        if (_plan_pending && !_mpu_pending)
+        {
+            const logger_plan_t* plan = _plan.load(std::memory_order_relaxed);
+            _plan.store((plan == &_plans[0]) ? &_plans[1] : &_plans[0], std::memory_order_release);
+            _plan_pending = false;
+        }
+
+        storage_serviceLog();
         return;
+    }
 
-    char row_buf[CSV_ROW_BUF_LEN];
+    char row_buf[CSV_ROW_MAX_LEN];
+    char* data = row_buf;
+    uint16_t len;
 
-    // Add timestamp and MPU data to string
-    uint16_t len = snprintf(row_buf, CSV_ROW_BUF_LEN,
-    "%lu.%03d,%d,%d,%d,%d,%d,%d,%d", _tail->time, _tail->millis,
-    _tail->mpu_accel[0], _tail->mpu_accel[1], _tail->mpu_accel[2],
-    _tail->mpu_gyro[0], _tail->mpu_gyro[1], _tail->mpu_gyro[2],
-    _tail->mpu_temp);
+    log_format_t format = storage_logFormat();
 
-    // Add each of the configured channels
-    uint8_t count = (uint8_t) storage_configGetNum(CONFIG_CHANNEL_TOP) -
-                    (uint8_t) storage_configGetNum(CONFIG_CHANNEL_BOT);
-    for (uint8_t i = 0; i < count; i++)
-        len += snprintf(row_buf + len, CSV_ROW_BUF_LEN - len, ",%d", _tail->adc_data[i]);
-    
-    len += snprintf(row_buf + len, CSV_ROW_BUF_LEN - len, "\r\n");
+    if (format == LOG_FORMAT_BIN)
+    {
+        // Binary records are the front of the entry, up to the last channel
+        data = (char*) entry;
+        len = _plan.load(std::memory_order_relaxed)->record_size;
+    }
+    else
+        len = csv_formatRow(row_buf, entry, logger_channelCount());
 
     if (bt_isLive())
-        bt_sendSample(_tail);
+        bt_sendSample(entry);
+
+    // Write to the SD and release the ring entry if successful
+    if (storage_addToLogFile(data, len, format, entry->time))
+    {
+        storage_addToRollup(entry, logger_channelCount());
+        _ring.pop();
+    }
+}
+
+bool logger_console(uint8_t argc, char* argv[])
+{
+    if (!strcmp("stats", argv[1]))
+    {
+        Serial.printf("Sampling:   %s\r\n", _running ? "running" : "stopped");
+        Serial.printf("Buffered:   %lu / %lu\r\n", _ring.count(), _ring.capacity());
+        Serial.printf("High water: %lu\r\n", _ring.highWater());
+        Serial.printf("Dropped:    %lu\r\n", _ring.drops());
+
+        if (_imu_running)
+        {
+            Serial.printf("IMU rate:   %d Hz\r\n", mpu_fifoRate());
+            Serial.printf("IMU buffer: %lu / %lu (high water %lu)\r\n",
+                          _imu_ring.count(), _imu_ring.capacity(), _imu_ring.highWater());
+            Serial.printf("IMU drops:  %lu\r\n", _imu_ring.drops());
+        }
+        else
+            Serial.printf("IMU late:   %lu\r\n", _mpu_late);
 
-    // Write to the SD and increment circular buffer if successful
-    if (storage_addToLogFile(row_buf, len))
-        _tail = ((_tail - _circ_buf) + 1 < CIRC_BUF_LEN) ? _tail + 1 : _circ_buf;
+        // Copied so the ISR can't change it part way through
+        __disable_irq();
+        logger_isr_stats_t isr = _isr_stats;
+        __enable_irq();
+
+        Serial.printf("ISR cycles: last %lu, mean %lu, max %lu (%lu us)\r\n", isr.last,
+                      isr.count ? (uint32_t) (isr.total / isr.count) : 0, isr.max,
+                      isr.max / (F_CPU / 1000000));
+
+        return true;
+    }
+
+    if (!strcmp("reset", argv[1]))
+    {
+        _ring.resetStats();
+        _imu_ring.resetStats();
+
+        __disable_irq();
+        memset(&_isr_stats, 0, sizeof(_isr_stats));
+        __enable_irq();
+
+        Serial.println("Logger stats cleared.");
+
+        return true;
+    }
+
+    return false;
 }
 
 void _sampleISR()
 {
-    uint8_t bottom = (uint8_t) storage_configGetNum(CONFIG_CHANNEL_BOT);
-    uint8_t top = (uint8_t) storage_configGetNum(CONFIG_CHANNEL_TOP);
-    for (uint8_t i = 0; i < (top - bottom) + 1; i++)
+    uint32_t start = ARM_DWT_CYCCNT;
+    const logger_plan_t* plan = _plan.load(std::memory_order_acquire);
+
+    // The last entry is still waiting on the IMU, give up on this sample.
+    //   i2c_busy() abandons a read that has timed out, which calls _mpuDone
+    //   to publish the entry, so it returns false and sampling carries on.
+    if (_mpu_pending && i2c_busy())
+    {
+        _mpu_late++;
+        return;
+    }
+
+    // Sample is dropped (and counted) if the SD writer has fallen behind
+    log_entry_t* entry = _ring.reserve();
+
+    if (entry)
+    {
+        // Collect data and a timestamp
+        if (adc_scanRunning())
+            adc_scanLatest(entry->adc_data, plan->channel_count);
+        else
+        {
+            memcpy(entry->adc_data, plan->channels, plan->channel_count * sizeof(uint16_t));
+            adc_sample(entry->adc_data, plan->channel_count);
+        }
+        entry->time = clock_getLocalNowSeconds();
+        entry->millis = clock_millis();
+
+        // The last IMU sample, kept if a read fails or can't start. The main
+        //   loop updates it with interrupts off, and _mpuDone only while no
+        //   sample is being taken, so it can't be torn.
+        memcpy(entry->mpu_accel, _imu_latest.accel, sizeof(entry->mpu_accel));
+        memcpy(entry->mpu_gyro, _imu_latest.gyro, sizeof(entry->mpu_gyro));
+        entry->mpu_temp = _imu_latest.temp;
+
+        if (_imu_running)
+            _ring.commit();
+        else
+        {
+            // Published by _mpuDone once the IMU read completes
+            _mpu_entry = entry;
+            _mpu_pending = true;
+            if (!mpu_sampleAsync(entry->mpu_accel, entry->mpu_gyro, &entry->mpu_temp, _mpuDone))
+            {
+                _mpu_pending = false;
+                _ring.commit();
+            }
+        }
+    }
+
+    uint32_t cycles = ARM_DWT_CYCCNT - start;
+    _isr_stats.count++;
+    _isr_stats.last = cycles;
+    _isr_stats.total += cycles;
+    if (cycles > _isr_stats.max)
+        _isr_stats.max = cycles;
+}
+
+void _mpuDone(bool ok)
+{
+    // A failed read keeps the last sample, and the MPU health monitor counts it
+    if (ok)
+    {
+        memcpy(_imu_latest.accel, _mpu_entry->mpu_accel, sizeof(_imu_latest.accel));
+        memcpy(_imu_latest.gyro, _mpu_entry->mpu_gyro, sizeof(_imu_latest.gyro));
+        _imu_latest.temp = _mpu_entry->mpu_temp;
+    }
+
+    _ring.commit();
+    _mpu_pending = false;
+}
+
+static void _drain()
+{
+    uint8_t failed = 0;
+
+    // An IMU read still going publishes its entry when it completes, or when
+    //   i2c_busy() finds it has timed out
+    while (_mpu_pending && i2c_busy())
+        ;
+
+    // A write can fail once when the log format changes, so only give up
+    //   after a few in a row
+    while (_ring.peek() && failed < 3)
+    {
+        uint32_t count = _ring.count();
+
+        logger_serviceBuffer();
+        failed = (_ring.count() < count) ? 0 : failed + 1;
+    }
+
+    if (_ring.peek())
+    {
+        Serial.printf("Dropped %lu samples that could not be written\r\n", _ring.count());
+        while (_ring.peek())
+            _ring.pop();
+    }
+}
+
+static void _imuDrain()
+{
+    mpu_sample_t burst[MPU_FIFO_BURST];
+    uint16_t behind = 0;
+    uint16_t rate = mpu_fifoRate();
+
+    if (!rate)
+        return;
+
+    // Time now, taken as the time of the newest sample in the FIFO
+    uint64_t now_ms = (uint64_t) clock_getLocalNowSeconds() * 1000 + clock_millis();
+
+    do
+    {
+        uint16_t n = mpu_readFifo(burst, MPU_FIFO_BURST, &behind);
+        if (!n)
+            break;
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            // Samples are evenly spaced back from the newest
+            uint32_t age = (uint32_t) (n - 1 - i + behind) * 1000 / rate;
+            uint64_t time_ms = now_ms - age;
+
+            burst[i].time = time_ms / 1000;
+            burst[i].millis = time_ms % 1000;
+            _imu_ring.push(burst[i]);
+        }
+
+        __disable_irq();
+        _imu_latest = burst[n - 1];
+        __enable_irq();
+    } while (behind);
+}
+
+static void _scanDrain()
+{
+    const logger_plan_t* plan = _plan.load(std::memory_order_relaxed);
+    uint32_t seq;
+    uint16_t scans = adc_scanNextBlock(_scan_block.adc_data, &seq);
+
+    if (!scans)
+        return;
+
+    // Scans are evenly spaced from the start of the scan
+    uint64_t time_ms = _scan_start_ms + (uint64_t) seq * scans * 1000 / plan->scan_rate;
+
+    _scan_block.time = time_ms / 1000;
+    _scan_block.millis = time_ms % 1000;
+    _scan_block.rate = plan->scan_rate;
+    _scan_block.seq = seq;
+    _scan_block.channel_mask = plan->channel_mask;
+    _scan_block.channel_count = plan->channel_count;
+    _scan_block.adc_bits = adc_resolution();
+    _scan_block.scans = scans;
+
+    // The DMA won't wait for the card, so a block it can't take is lost
+    storage_addToScanFile(&_scan_block);
+}
+
+static void _planBuild(logger_plan_t* plan)
+{
+    memset(plan, 0, sizeof(*plan));
+
+    plan->period_us = (uint32_t) storage_configGetNum(CONFIG_POLL_RATE) * 1000;
+    plan->imu_rate = (uint16_t) storage_configGetNum(CONFIG_MPU_RATE);
+    plan->scan_rate = (uint16_t) storage_configGetNum(CONFIG_ADC_SCAN_RATE);
+
+    plan->channel_mask = _channelMask();
+    for (uint8_t i = 0; i < LOGGER_MAX_ADC_CHANNELS; i++)
     {
-        _head->adc_data[i] = bottom + i;
+        if (plan->channel_mask & (1 << i))
+            plan->channels[plan->channel_count++] = i;
     }
 
-    // Collect data and a timestamp
-    adc_sample(_head->adc_data, (top - bottom) + 1);
-    mpu_sampleRaw(_head->mpu_accel, _head->mpu_gyro, &_head->mpu_temp);
-    _head->time = clock_getLocalNowSeconds();
-    _head->millis = clock_millis();
+    plan->record_size = LOG_BIN_RECORD_SIZE(plan->channel_count);
+}
+
+static bool _planCheck(const logger_plan_t* plan, bool scanning)
+{
+    uint32_t row_us = (uint32_t) (adc_channelTime() * plan->channel_count);
+
+    if (!scanning && row_us > plan->period_us / 2)
+    {
+        Serial.printf("poll_rate of %lu ms is too fast for the ADC profile (%lu us per sample)\r\n",
+                      plan->period_us / 1000, row_us);
+        return false;
+    }
+
+    return true;
+}
+
+static uint16_t _channelMask()
+{
+    const char* str = storage_configGetString(CONFIG_CHANNEL_MASK);
+    uint16_t mask = 0;
+
+    if (!strncmp(str, "0x", 2))
+        mask = (uint16_t) strtoul(str, NULL, 16);
+    else
+    {
+        // List of channels and ranges, such as "0-3,5,8-12"
+        const char* curs = str;
+        char* end;
+
+        while (true)
+        {
+            long first = strtol(curs, &end, 10);
+            if (end == curs)
+                break;
 
-    // Increment write head
-    _head = ((_head - _circ_buf) + 1 < CIRC_BUF_LEN) ? _head + 1 : _circ_buf;
+            long last = first;
+            if (*end == '-')
+            {
+                curs = end + 1;
+                last = strtol(curs, &end, 10);
+                if (end == curs)
+                    break;
+            }
+
+            for (long i = max(first, 0L); i <= last && i < LOGGER_MAX_ADC_CHANNELS; i++)
+                mask |= 1 << i;
+
+            if (*end != ',')
+                break;
+            curs = end + 1;
+        }
+    }
+
+    if (!mask)
+    {
+        uint8_t bottom = (uint8_t) storage_configGetNum(CONFIG_CHANNEL_BOT);
+        uint8_t top = (uint8_t) storage_configGetNum(CONFIG_CHANNEL_TOP);
+
+        for (uint8_t i = bottom; i <= top && i < LOGGER_MAX_ADC_CHANNELS; i++)
+            mask |= 1 << i;
+    }
 
-    // Update sample timer period if still running
-    if (_running) logger_startSampling();
+    return mask;
 }
@@ -17,11 +17,9 @@
 
 #define LED_PERIOD 100
 #define CONSOLE_PERIOD 50
-#define BT_PERIOD 50
 
 uint32_t next_led = LED_PERIOD;
 uint32_t next_console = CONSOLE_PERIOD;
-uint32_t next_bt = BT_PERIOD;
 
 void setup()
 {
@@ -53,11 +51,10 @@ void loop()
         console_tick(NULL);
     }
 
-    if (millis() >= next_bt)
-    {
-        next_bt += BT_PERIOD;
-        bt_tick();
-    }
+    // Run every loop so historical transfers are paced without blocking
+    bt_tick();
+
+    mpu_tick();
 
     logger_serviceBuffer();
 }
@@ -12,11 +12,20 @@
 #include <I2Cdev.h>
 #include <MPU6050.h>
 
+#include "i2c.h"
 #include "storage.h"
 
 #define G_M_PER_S 9.8066
 #define DEG_PER_RAD 0.0174533
 
+// Accel, temperature and gyro registers, read in one burst. FIFO records
+//   are laid out the same way.
+#define SAMPLE_BYTES 14
+#define FIFO_SIZE 1024
+
+// FIFO bytes per I2Cdev read: as many whole samples as fit in its 32 byte chunk
+#define FIFO_READ_BYTES ((32 / SAMPLE_BYTES) * SAMPLE_BYTES)
+
 static const uint16_t accel_ranges[] = { 2, 4, 8, 16 }; 
 static const uint16_t gyro_ranges[] = { 250, 500, 1000, 2000 }; 
 static const uint16_t filter_ranges[] = { 260, 184, 194, 44, 21, 10, 5 }; 
@@ -27,17 +36,91 @@ mpu_accel_range_t _accel_setting = ACCEL_4_G;
 mpu_gyro_range_t _gyro_setting = GYRO_500_DEG_PER_S;
 mpu_filter_range_t _filter_setting = FILTER_21_HZ;
 
+// Sample read health, updated by the sampling ISR
+volatile uint8_t _fail_run = 0;     // Consecutive failed reads
+volatile uint32_t _reads = 0;
+volatile uint32_t _read_fails = 0;
+volatile uint32_t _read_us = 0;     // Duration of the last read
+volatile uint32_t _read_max_us = 0;
+
+// Async read in progress, unpacked on completion
+uint8_t _async_buf[SAMPLE_BYTES];
+int16_t* _async_accel;
+int16_t* _async_gyro;
+int16_t* _async_temp;
+mpu_done_t _async_done;
+uint32_t _async_start;
+
+uint16_t _fifo_rate = 0;            // Requested FIFO rate, 0 if not running
+uint16_t _fifo_actual = 0;          // Rate given by the sample rate divider
+volatile uint32_t _fifo_overflows = 0;
+
+uint32_t _reinits = 0;
+uint32_t _next_health = 0;          // millis() of the next health check
+
+/*
+ * Name:    _be16
+ *  buf:    two bytes, most significant first
+ *  return: the signed value
+ */
+static inline int16_t _be16(const uint8_t* buf)
+{
+    return (int16_t) ((buf[0] << 8) | buf[1]);
+}
+
+/*
+ * Name:    _unpack
+ *  buf:    accel, temperature and gyro registers as read from the sensor
+ *  accel:  accelerometer data {x, y, z}
+ *  gyro:   gyro data {x, y, z}
+ *  temp:   temperature reading
+ */
+static void _unpack(const uint8_t* buf, int16_t accel[3], int16_t gyro[3], int16_t* temp);
+
+/*
+ * Name:    _fifoSetup
+ * Desc:    Program the sample rate divider and enable the FIFO at _fifo_rate
+ */
+static void _fifoSetup();
+
+/*
+ * Name:    _readDone
+ *  ok:     true if the read completed
+ *  start:  micros() when the read started
+ * Desc:    Track the health of sample reads
+ */
+static void _readDone(bool ok, uint32_t start);
+
+/*
+ * Name:    _asyncDone
+ *  ok:     true if the read completed
+ *  ctx:    unused
+ * Desc:    Unpack an async sample and pass it on
+ * !!! CALLED BY I2C0 INTERRUPT !!!
+ */
+static void _asyncDone(bool ok, void* ctx);
+
 bool mpu_init()
 {
+    bool was_connected = _connected;
+
+    // Keep the sampling ISRs off the bus while it is reset
+    _connected = false;
+    if (!i2c_acquire(I2C_TIMEOUT_US))
+        return false;
+
     Wire.begin();
+    Wire.setClock(MPU_I2C_CLOCK);
+    i2c_init();
 
-    if (_connected) _mpu.reset();
+    if (was_connected) _mpu.reset();
     _mpu.initialize();
 
     if (!_mpu.testConnection())
     {
         Serial.println("MPU connection failed.");
         _connected = false;
+        i2c_release();
         return _connected;
     }
 
@@ -51,10 +134,35 @@ bool mpu_init()
     _mpu.setXGyroOffset(mpu_cal_configs[(int) storage_configGetNum(CONFIG_MPU_ID)].gz);
 
     _connected = mpu_configure(_accel_setting, _gyro_setting, _filter_setting);
+    _fail_run = 0;
+
+    // Reset clears the FIFO settings
+    if (_connected && _fifo_rate)
+        _fifoSetup();
 
+    i2c_release();
     return _connected;
 }
 
+void mpu_tick()
+{
+    if ((int32_t) (millis() - _next_health) < 0)
+        return;
+
+    _next_health = millis() + MPU_HEALTH_MS;
+
+    // Reinitialize once reads keep failing. Done here rather than in the ISR
+    //   as it takes a while.
+    if (_connected && _fail_run < MPU_FAIL_LIMIT)
+        return;
+
+    _reinits++;
+    if (mpu_init())
+        Serial.println("MPU reconnected.");
+    else
+        _next_health = millis() + MPU_RETRY_MS;
+}
+
 bool mpu_configure(mpu_accel_range_t accel, mpu_gyro_range_t gyro, mpu_filter_range_t filter)
 {
     if (!_connected)
@@ -93,16 +201,179 @@ uint16_t mpu_getGyroRange()
 
 bool mpu_sampleRaw(int16_t accel[3], int16_t gyro[3], int16_t* temp)
 {
-    if (!_connected || !_mpu.testConnection())
+    uint8_t buf[SAMPLE_BYTES];
+
+    if (!_connected || !i2c_acquire(I2C_TIMEOUT_US))
+        return false;
+
+    // One transaction for everything; a missing sensor shows up as a failed
+    //   read, so there is no need to check WHO_AM_I every sample
+    uint32_t start = micros();
+    bool ok = I2Cdev::readBytes(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_ACCEL_XOUT_H, SAMPLE_BYTES, buf) == SAMPLE_BYTES;
+
+    i2c_release();
+    _readDone(ok, start);
+
+    if (ok)
+        _unpack(buf, accel, gyro, temp);
+
+    return ok;
+}
+
+bool mpu_sampleAsync(int16_t accel[3], int16_t gyro[3], int16_t* temp, mpu_done_t done)
+{
+    // The outputs of a read still going must not be replaced
+    if (_connected && !i2c_busy())
     {
-        _connected = false;
-        return _connected;
+        _async_accel = accel;
+        _async_gyro = gyro;
+        _async_temp = temp;
+        _async_done = done;
+        _async_start = micros();
+
+        if (i2c_readAsync(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_ACCEL_XOUT_H, _async_buf, SAMPLE_BYTES,
+                          _asyncDone, NULL))
+            return true;
     }
 
-    _mpu.getMotion6(&accel[0], &accel[1], &accel[2], &gyro[0], &gyro[1], &gyro[2]);
-    *temp = _mpu.getTemperature();
+    // A sample lost either way, but the bus may just be held by Wire, so it
+    //   doesn't count towards a reinit
+    _reads++;
+    _read_fails++;
+    return false;
+}
 
-    return _connected;
+bool mpu_startFifo(uint16_t rate)
+{
+    _fifo_rate = rate;
+
+    if (!_connected || !i2c_acquire(I2C_TIMEOUT_US))
+    {
+        _fifo_rate = 0;
+        return false;
+    }
+
+    _fifoSetup();
+    i2c_release();
+
+    Serial.printf("MPU FIFO running at %d Hz\r\n", _fifo_actual);
+    return true;
+}
+
+void mpu_stopFifo()
+{
+    _fifo_rate = 0;
+    _fifo_actual = 0;
+
+    if (!_connected || !i2c_acquire(I2C_TIMEOUT_US))
+        return;
+
+    _mpu.setFIFOEnabled(false);
+    _mpu.setAccelFIFOEnabled(false);
+    _mpu.setTempFIFOEnabled(false);
+    _mpu.setXGyroFIFOEnabled(false);
+    _mpu.setYGyroFIFOEnabled(false);
+    _mpu.setZGyroFIFOEnabled(false);
+    i2c_release();
+}
+
+uint16_t mpu_fifoRate()
+{
+    return _fifo_actual;
+}
+
+uint16_t mpu_readFifo(mpu_sample_t* out, uint16_t max, uint16_t* behind)
+{
+    uint8_t buf[MPU_FIFO_BURST * SAMPLE_BYTES];
+
+    *behind = 0;
+
+    if (!_connected || !_fifo_actual || !i2c_acquire(I2C_TIMEOUT_US))
+        return 0;
+
+    uint16_t count = _mpu.getFIFOCount();
+
+    // A full FIFO has dropped samples, and a partial record means reads are
+    //   out of step, so start again from empty either way
+    if (count >= FIFO_SIZE || count % SAMPLE_BYTES)
+    {
+        _mpu.resetFIFO();
+        _fifo_overflows++;
+        i2c_release();
+        return 0;
+    }
+
+    uint16_t n = min(min(count / SAMPLE_BYTES, max), (uint16_t) MPU_FIFO_BURST);
+    for (uint16_t pos = 0; pos < n * SAMPLE_BYTES; pos += FIFO_READ_BYTES)
+        _mpu.getFIFOBytes(buf + pos, min(n * SAMPLE_BYTES - pos, FIFO_READ_BYTES));
+    if (n)
+        _reads++;
+
+    i2c_release();
+
+    for (uint16_t i = 0; i < n; i++)
+        _unpack(buf + i * SAMPLE_BYTES, out[i].accel, out[i].gyro, &out[i].temp);
+
+    *behind = count / SAMPLE_BYTES - n;
+    return n;
+}
+
+static void _unpack(const uint8_t* buf, int16_t accel[3], int16_t gyro[3], int16_t* temp)
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        accel[i] = _be16(buf + 2 * i);
+        gyro[i] = _be16(buf + 8 + 2 * i);
+    }
+    *temp = _be16(buf + 6);
+}
+
+static void _readDone(bool ok, uint32_t start)
+{
+    _read_us = micros() - start;
+    if (_read_us > _read_max_us)
+        _read_max_us = _read_us;
+    _reads++;
+
+    if (ok)
+    {
+        _fail_run = 0;
+        return;
+    }
+
+    _read_fails++;
+    if (_fail_run < UINT8_MAX)
+        _fail_run++;
+}
+
+static void _asyncDone(bool ok, void* ctx)
+{
+    _readDone(ok, _async_start);
+
+    if (ok)
+        _unpack(_async_buf, _async_accel, _async_gyro, _async_temp);
+
+    if (_async_done)
+        _async_done(ok);
+}
+
+static void _fifoSetup()
+{
+    // Gyro output runs at 8 kHz with the low pass filter off, 1 kHz with it on
+    uint16_t base = (_filter_setting == FILTER_260_HZ) ? 8000 : 1000;
+    uint16_t divider = constrain(base / _fifo_rate, 1, 256);
+
+    _mpu.setFIFOEnabled(false);
+    _mpu.setRate(divider - 1);
+    _mpu.setAccelFIFOEnabled(true);
+    _mpu.setTempFIFOEnabled(true);
+    _mpu.setXGyroFIFOEnabled(true);
+    _mpu.setYGyroFIFOEnabled(true);
+    _mpu.setZGyroFIFOEnabled(true);
+    _mpu.resetFIFO();
+    _mpu.setFIFOEnabled(true);
+
+    _fifo_actual = base / divider;
 }
 
 bool mpu_sampleFloat(float accel[3], float gyro[3], float* temp)
@@ -147,6 +418,17 @@ bool mpu_console(uint8_t argc, char* argv[])
         return true;
     }
 
+    if (!strcmp("status", argv[1]))
+    {
+        Serial.printf("Connected:   %s\r\n", _connected ? "yes" : "no");
+        Serial.printf("Reads:       %lu (%lu failed)\r\n", _reads, _read_fails);
+        Serial.printf("Read time:   %lu us (max %lu us)\r\n", _read_us, _read_max_us);
+        Serial.printf("Reinits:     %lu\r\n", _reinits);
+        Serial.printf("FIFO:        %d Hz, %lu overflows\r\n", _fifo_actual, _fifo_overflows);
+
+        return true;
+    }
+
     if (!strcmp("sample", argv[1]))
     {
         float a[3], g[3], t;
@@ -0,0 +1,32 @@
+/* 
+ * File:    oversample.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Fixed-point averaging and decimation of ADC conversions. A sum of
+ *            2^n conversions scaled back to the converted resolution is
+ *            their average, which lowers noise but adds no resolution. Only
+ *            sums of 4^k conversions can keep k extra bits, and only when
+ *            the input is noisy enough to dither. Only depends on the C
+ *            library so the kernel can be built and timed on a host.
+ */
+
+#include "oversample.h"
+
+void oversample_decimate(const uint32_t* sums, uint16_t* out, uint8_t count,
+                         uint8_t in_bits, uint8_t oversample, uint8_t out_bits)
+{
+    int8_t shift = (int8_t) (in_bits + oversample) - (int8_t) out_bits;
+    uint32_t max = (1UL << out_bits) - 1;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint32_t value = sums[i];
+
+        if (shift > 0)
+            value = (value + (1UL << (shift - 1))) >> shift;
+        else
+            value <<= -shift;
+
+        out[i] = (uint16_t) (value > max ? max : value);
+    }
+}
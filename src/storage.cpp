@@ -12,12 +12,30 @@
 #include <sdios.h>
 #include <TimeLib.h>
 
+#include "adc.h"
 #include "clock.h"
+#include "csv.h"
 #include "logger.h"
+#include "mpu.h"
 
 #define ERASE_SIZE 262144L
 #define CONFIG_NAME "config.txt"
 #define READ_BUF_SIZE 256
+#define SECTOR_SIZE 512
+#define INDEX_BUF_LEN 16
+#define INDEX_EXT "idx"
+#define ROLLUP_EXT "rol"
+#define IMU_EXT "imu"
+#define SCAN_EXT "scn"
+#define LOG_EXT_MAX_LEN 7   // e.g. "csv.idx"
+// Device name, "_YYYY-MM-DD_HH." and the longest extension
+#define LOG_FILENAME_LEN (CONFIG_STRING_LEN - 1 + 15 + LOG_EXT_MAX_LEN + 1)
+#define CATALOG_NAME "catalog.bin"
+#define CATALOG_MAGIC "DSCT"
+#define CATALOG_VERSION 2
+
+static_assert(LOG_WRITE_BUF_LEN % SECTOR_SIZE == 0, "log buffer must be whole sectors");
+static_assert(offsetof(log_scan_block_t, adc_data) == 18, "scan block header must not be padded");
 
 const char* config_keys[] =
 {
@@ -26,7 +44,13 @@ const char* config_keys[] =
     "timezone",
     "mpu_id",
     "channel_bottom",
-    "channel_top"
+    "channel_top",
+    "log_format",
+    "live_flush_ms",
+    "mpu_rate",
+    "adc_scan_hz",
+    "adc_profile",
+    "channel_mask"
 };
 
 const char* config_defaults[] =
@@ -36,7 +60,20 @@ const char* config_defaults[] =
     "-7",
     "0",
     "0",
-    "12"
+    "12",
+    "0",
+    "100",
+    "0",
+    "0",
+    "default",
+    "range"
+};
+
+// File extensions for each log_format_t
+const char* log_extensions[] =
+{
+    "csv",
+    "bin"
 };
 
 typedef struct config_val_t
@@ -50,6 +87,117 @@ config_val_t config_values[CONFIG_COUNT];
 bool _sd_open = false;
 SdFs _sd;
 
+// Open hourly log file, kept open between rows
+typedef struct log_session_t
+{
+    FsFile file;
+    uint32_t start;     // Local epoch of the start of the open file's hour
+    uint32_t rollover;  // Local epoch at which the next hour's file starts
+    bool error;         // Set on an I/O error to force a reconnect and reopen
+    log_format_t requested; // Configured format when the file was opened
+    log_format_t format;    // Format of the open file
+    char filename[LOG_FILENAME_LEN];
+    FsFile index;           // Timestamp index for the open file
+    bool indexed;           // False if the file exists without an index
+    uint32_t index_time;    // Time of the last index entry
+    uint32_t samples;       // Number of samples in the file
+    int16_t catalog;        // Index of the file's catalog entry, or -1
+    bool mask_pending;      // CSV channel mask comment due before the next row
+    bool mask_each_second;  // Mask differs from the one at the top of the CSV file
+} log_session_t;
+
+log_session_t _log;
+uint8_t _log_buf[LOG_WRITE_BUF_LEN];
+uint16_t _log_buf_len = 0;
+uint32_t _log_pending_since = 0;
+bool _log_pending = false;
+log_index_entry_t _index_buf[INDEX_BUF_LEN];
+uint8_t _index_buf_len = 0;
+
+// Header of the catalog file, followed by `count` log_catalog_entry_t
+typedef struct __attribute__((packed)) log_catalog_header_t
+{
+    char     magic[4];
+    uint8_t  version;
+    uint16_t count;
+} log_catalog_header_t;
+
+log_catalog_entry_t _catalog[LOG_CATALOG_LEN];
+uint16_t _catalog_len = 0;
+
+// Hourly log being read back through a block buffer. An hour whose format
+//   was changed part way through has a file in each format, read one after
+//   the other as if they were one file.
+typedef struct log_reader_t
+{
+    FsFile file;
+    uint32_t hour;          // Local epoch of the open file's hour
+    log_format_t format;    // Format of the open file
+    log_format_t formats[2];// The hour's files, earliest samples first
+    uint32_t first[2];      // Local epoch of the first sample in each file
+    uint8_t files;          // Number of files for the hour
+    uint8_t current;        // Position of the open file in `formats`
+    uint32_t base;          // Samples in the hour's files before the open one
+    log_bin_header_t header;
+    char buf[LOG_READ_BUF_LEN];
+    uint16_t pos;           // Next unread byte in buf
+    uint16_t len;           // Number of bytes held in buf
+    uint16_t last;          // Position in buf of the last line or record read
+    uint32_t sample;        // Index of the next sample in the file
+    uint8_t channels;       // ADC channels in the last sample read
+    uint16_t mask;          // ADC channels in the samples being read, or 0
+    uint16_t top_mask;      // `mask` at the top of the file
+} log_reader_t;
+
+log_reader_t _reader;
+
+// IMU sample or ADC scan file for the current hour, written a buffer at a
+//   time
+typedef struct log_side_t
+{
+    uint8_t* buf;
+    uint16_t size;          // Bytes buf can hold
+    const char* ext;
+    FsFile file;
+    uint32_t start;         // Local epoch of the open file's hour
+    uint16_t len;           // Bytes waiting in buf
+    uint32_t pending_since; // millis() when the oldest waiting record was added
+} log_side_t;
+
+uint8_t _imu_buf[LOG_IMU_BUF_LEN];
+uint8_t _scan_buf[LOG_SCAN_BUF_LEN];
+log_side_t _imu = { _imu_buf, sizeof(_imu_buf), IMU_EXT };
+log_side_t _scan = { _scan_buf, sizeof(_scan_buf), SCAN_EXT };
+
+// Minute being summarised, sums are kept until the minute is written
+typedef struct log_rollup_acc_t
+{
+    uint32_t minute;        // Local epoch of the minute, 0 if empty
+    uint32_t count;
+    uint32_t written;       // Count when last written, if the log was closed part way
+                            //   through the minute, otherwise 0
+    uint8_t channels;
+    int32_t min[LOG_ROLLUP_VALUES];
+    int32_t max[LOG_ROLLUP_VALUES];
+    int64_t sum[LOG_ROLLUP_VALUES];
+} log_rollup_acc_t;
+
+log_rollup_acc_t _rollup;
+
+// Rollup file being read back
+FsFile _rollup_file;
+uint32_t _rollup_hour = 0;      // Local epoch of the open rollup file's hour
+uint32_t _rollup_last = 0;      // Minute of the last rollup read
+
+// Log write statistics
+uint32_t _log_writes = 0;
+uint32_t _log_syncs = 0;
+uint32_t _log_bytes = 0;
+uint32_t _log_write_us = 0;
+uint32_t _log_appends = 0;
+uint32_t _log_append_us = 0;
+uint32_t _log_append_max_us = 0;
+
 /*
  * Name:    _sdError
  * Desc:    Print the SD card error message and clean up the connection on error.
@@ -64,6 +212,342 @@ static void _sdError();
  */
 static uint16_t _str2int(const char* str, uint16_t len);
 
+/*
+ * Name:    _logWrite
+ *  all:    write everything buffered rather than just whole sectors
+ *  return: true if the write succeeded
+ * Desc:    Write buffered log data to the open log file. Unless `all` is set,
+ *            only enough data to end on a sector boundary is written and the
+ *            remainder is kept for the next write.
+ */
+static bool _logWrite(bool all);
+
+/*
+ * Name:    _logOpen
+ *  return: true if the log file for the current hour is open
+ * Desc:    Flush and close the current log file and open the file for the
+ *            current hour, reconnecting to the card first after an error.
+ */
+static bool _logOpen();
+
+/*
+ * Name:    _logAppend
+ *  data:   bytes to add to the log buffer
+ *  len:    number of bytes
+ *  return: true if the data was buffered
+ * Desc:    Add data to the log write buffer, writing out whole sectors first
+ *            if there is not enough room.
+ */
+static bool _logAppend(const void* data, uint16_t len);
+
+/*
+ * Name:    _logFileName
+ *  buf:    buffer to write the name to
+ *  len:    size of `buf`
+ *  time:   local epoch within the hour of the file
+ *  ext:    file extension
+ *  return: false if the name doesn't fit, and `buf` is left empty
+ * Desc:    Build the name of an hourly log or index file.
+ */
+static bool _logFileName(char* buf, size_t len, uint32_t time, const char* ext);
+
+/*
+ * Name:    _logHeader
+ *  header: header to populate from the current settings
+ * Desc:    Describe the records the logger currently produces.
+ */
+static void _logHeader(log_bin_header_t* header);
+
+/*
+ * Name:    _logMaskOpen
+ * Desc:    Set up the channel mask comments for a CSV file just opened: one
+ *            before the next row, then one every second if the mask differs
+ *            from the one at the top of the file, or the file has none.
+ */
+static void _logMaskOpen();
+
+/*
+ * Name:    _logMask
+ *  time:   local epoch of the row about to be added
+ *  return: false if a comment was due but could not be buffered
+ * Desc:    Record the channel mask in a CSV file before the first row after
+ *            it is opened. A mask that differs from the one at the top of
+ *            the file is repeated at the start of every second, so a reader
+ *            that seeks by the index always finds it.
+ */
+static bool _logMask(uint32_t time);
+
+/*
+ * Name:    _logClose
+ * Desc:    Flush and close the open log file and its index.
+ */
+static void _logClose();
+
+/*
+ * Name:    _indexOpen
+ *  record_size: size of binary records, or 0 for CSV
+ * Desc:    Open the index for the open log file and recover the number of
+ *            samples already in the file. Files that already contain data but
+ *            have no index are not indexed.
+ */
+static void _indexOpen(uint16_t record_size);
+
+/*
+ * Name:    _indexAdd
+ *  time:   local epoch of the sample being added
+ *  offset: byte offset of the sample in the log file
+ * Desc:    Count a sample and add an index entry if it starts a new second.
+ *            A full entry buffer forces a log flush, since entries are only
+ *            written once the rows they point to are on the card.
+ */
+static void _indexAdd(uint32_t time, uint32_t offset);
+
+/*
+ * Name:    _indexWrite
+ * Desc:    Write buffered index entries to the index file. Only called by
+ *            storage_flushLog, after the data sync.
+ */
+static void _indexWrite();
+
+/*
+ * Name:    _csvCountRows
+ *  file:   CSV file, positioned at the start of a line
+ *  buf:    scratch buffer
+ *  size:   size of `buf`
+ *  return: rows from there to the end of the file, not counting comments
+ */
+static uint32_t _csvCountRows(FsFile* file, char* buf, uint16_t size);
+
+/*
+ * Name:    _indexFileName
+ *  buf:    buffer to write the name to
+ *  len:    size of `buf`
+ *  time:   local epoch within the hour of the file
+ *  format: format of the log file the index is for
+ *  return: false if the name doesn't fit
+ * Desc:    Build the name of a log file's index, e.g. "<hour>.csv.idx". Each
+ *            format has its own index so an hour can have both files.
+ */
+static bool _indexFileName(char* buf, size_t len, uint32_t time, log_format_t format);
+
+/*
+ * Name:    _indexOpenRead
+ *  index:  file to open
+ *  hour:   local epoch of the log file's hour
+ *  format: format of the log file
+ *  return: true if an index was opened
+ * Desc:    Open a log file's index for reading. Cards written before indexes
+ *            were named by format have one "<hour>.idx", which is used if
+ *            the hour has no file in the other format.
+ */
+static bool _indexOpenRead(FsFile* index, uint32_t hour, log_format_t format);
+
+/*
+ * Name:    _indexFind
+ *  hour:   local epoch of the log file's hour
+ *  format: format of the log file
+ *  key:    local epoch, or sample number if `by_sample`, to find
+ *  entry:  last index entry at or before `key`, or the first entry
+ *  by_sample: search by sample number rather than time
+ *  return: true if the file has a non-empty index
+ * Desc:    Binary search a log file's index.
+ */
+static bool _indexFind(uint32_t hour, log_format_t format, uint32_t key,
+                       log_index_entry_t* entry, bool by_sample);
+
+/*
+ * Name:    _catalogLoad
+ *  return: true if the catalog was loaded or rebuilt
+ * Desc:    Load the log catalog from the card, rebuilding it if missing or
+ *            invalid. The newest entry is refreshed in case it was open when
+ *            power was lost.
+ */
+static bool _catalogLoad();
+
+/*
+ * Name:    _catalogSave
+ *  return: true if the catalog was written
+ * Desc:    Write the in-memory log catalog to the card.
+ */
+static bool _catalogSave();
+
+/*
+ * Name:    _catalogFind
+ *  hour:   UTC epoch of the hour
+ *  insert: add an empty entry if not found
+ *  return: index of the entry, or -1 if not found
+ * Desc:    Binary search the catalog for an hour, keeping it sorted on insert.
+ */
+static int16_t _catalogFind(uint32_t hour, bool insert);
+
+/*
+ * Name:    _catalogScan
+ *  entry:  entry to populate, with the hour already set
+ *  return: true if the hour has a log file
+ * Desc:    Fill a catalog entry from the hour's log files and their indexes.
+ */
+static bool _catalogScan(log_catalog_entry_t* entry);
+
+/*
+ * Name:    _catalogScanFile
+ *  entry:  entry to add the file to
+ *  format: format of the file
+ *  return: true if the file was found
+ * Desc:    Add one of the hour's log files to its catalog entry.
+ */
+static bool _catalogScanFile(log_catalog_entry_t* entry, log_format_t format);
+
+/*
+ * Name:    _catalogLowerBound
+ *  hour:   UTC epoch to search for
+ *  return: index of the first entry at or after `hour`
+ */
+static uint16_t _catalogLowerBound(uint32_t hour);
+
+/*
+ * Name:    _catalogAttach
+ * Desc:    Find or add the catalog entry for the open log file. Must be called
+ *            whenever the catalog is reloaded or rebuilt.
+ */
+static void _catalogAttach();
+
+/*
+ * Name:    _localHour
+ *  utc:    UTC epoch
+ *  return: local epoch
+ * Desc:    Convert a UTC epoch to local time, as used in log file names.
+ */
+static uint32_t _localHour(uint32_t utc);
+
+/*
+ * Name:        _sideAdd
+ *  side:       IMU or scan file to add to
+ *  time:       local epoch of the record
+ *  header:     header for a new file
+ *  header_len: bytes in the header
+ *  record:     record to add
+ *  len:        bytes in the record
+ *  return:     true if the record was buffered or written
+ * Desc:        Buffer a record for the hour's file, switching files when the
+ *                hour changes.
+ */
+static bool _sideAdd(log_side_t* side, uint32_t time, const void* header, uint8_t header_len,
+                     const void* record, uint16_t len);
+
+/*
+ * Name:        _sideOpen
+ *  side:       IMU or scan file to open
+ *  hour:       local epoch of the hour
+ *  header:     header for a new file
+ *  header_len: bytes in the header
+ *  return:     true if the file for the hour is open
+ * Desc:        Open the hour's file for appending, writing the header to a new
+ *                file.
+ */
+static bool _sideOpen(log_side_t* side, uint32_t hour, const void* header, uint8_t header_len);
+
+/*
+ * Name:    _sideFlush
+ *  side:   IMU or scan file to flush
+ *  sync:   also flush the file to the card
+ *  return: true if all buffered records were written
+ */
+static bool _sideFlush(log_side_t* side, bool sync);
+
+/*
+ * Name:    _rollupValue
+ *  entry:  sample to get a value from
+ *  i:      value number, in the order of log_rollup_t
+ *  return: the value
+ */
+static int32_t _rollupValue(const log_entry_t* entry, uint8_t i);
+
+/*
+ * Name:    _rollupWrite
+ * Desc:    Write the minute being summarised to its hour's rollup file.
+ */
+static void _rollupWrite();
+
+/*
+ * Name:    _readerOpen
+ *  time:   local epoch within the hour to read
+ *  return: true if a log file for the hour was opened
+ * Desc:    Find an hour's log files and open the one with the earliest
+ *            samples for reading.
+ */
+static bool _readerOpen(uint32_t time);
+
+/*
+ * Name:    _readerOpenFile
+ *  file:   position of the file in the reader's `formats`
+ *  base:   number of samples in the hour's earlier file
+ *  return: true if the file was opened
+ * Desc:    Open one of the hour's files and position it at its first sample.
+ */
+static bool _readerOpenFile(uint8_t file, uint32_t base);
+
+/*
+ * Name:    _readerSample
+ *  log:    where to read the sample to
+ *  return: true if a sample was read from the open file
+ */
+static bool _readerSample(log_entry_t* log);
+
+/*
+ * Name:    _readerCount
+ *  return: number of samples in the open file
+ * Desc:    Count the open file's samples, from its size for binary files and
+ *            from its index for CSV files. Leaves the file at its start.
+ */
+static uint32_t _readerCount();
+
+/*
+ * Name:    _readerSeekIndex
+ *  sample: number of the sample within the hour
+ *  return: true if the open file holds that sample
+ * Desc:    Position the open file at a sample. Binary files are seeked to
+ *            directly and CSV files through their index.
+ */
+static bool _readerSeekIndex(uint32_t sample);
+
+/*
+ * Name:    _readerJump
+ *  entry:  index entry of the open file to jump to
+ * Desc:    Position the open file at the start of an indexed second.
+ */
+static void _readerJump(const log_index_entry_t* entry);
+
+/*
+ * Name:    _readerFill
+ *  return: true if more data was read into the buffer
+ * Desc:    Move unread data to the front of the read buffer and top it up.
+ */
+static bool _readerFill();
+
+/*
+ * Name:    _readerLine
+ *  len:    length of the line, excluding the line ending
+ *  return: pointer to the line in the read buffer, or nullptr at end of file
+ * Desc:    Get the next complete line. A final line without a line ending
+ *            (e.g. cut off by power loss) is not returned.
+ */
+static const char* _readerLine(uint16_t* len);
+
+/*
+ * Name:    _readerRecord
+ *  dst:    where to copy the record
+ *  size:   size of the record
+ *  return: true if a whole record was read
+ * Desc:    Get the next fixed size binary record.
+ */
+static bool _readerRecord(void* dst, uint16_t size);
+
+/*
+ * Name:    _readerUnread
+ * Desc:    Step back over the last line or record read so it is read again.
+ */
+static void _readerUnread();
+
 bool storage_init()
 {
     if (!storage_start())
@@ -77,6 +561,9 @@ bool storage_init()
         FsDateTime::setCallback(clock_fsStampCallback);
         _sd_open = true;
         _sd_open = storage_configLoad();
+
+        if (_sd_open)
+            _catalogLoad();
     }
 
     return _sd_open;
@@ -103,6 +590,8 @@ bool storage_format()
     bool logger = logger_getState();
     if (logger) logger_stopSampling();
 
+    _logClose();
+
     if (_sd_open)
     {
         _sd.end();
@@ -181,8 +670,16 @@ bool storage_format()
 
     _sd.end();
 
+    _catalog_len = 0;
+    _rollup.minute = 0;
+    _rollup_file.close();
+    _imu.len = 0;
+    _imu.file.close();
+    _scan.len = 0;
+    _scan.file.close();
+
     if (storage_start() || storage_start() || storage_start() || storage_start())
-        return storage_configCreate();
+        return storage_configCreate() && _catalogSave();
 
     if (logger) logger_startSampling();
 
@@ -311,6 +808,8 @@ bool storage_configLoad()
     }        
 
     Serial.printf("Loaded %d settings from \"" CONFIG_NAME "\".\r\n", match_cnt);
+
+    logger_loadConfig();
     return match_cnt;
 }
 
@@ -324,61 +823,125 @@ char* storage_configGetString(config_keys_t option)
     return config_values[option].str_value;
 }
 
-bool storage_addToLogFile(char* text, uint16_t len)
+log_format_t storage_logFormat()
 {
-    static FsFile file;
-    static int8_t file_hour = -1;
+    if (_log.file.isOpen())
+        return _log.format;
 
-    if (!storage_start())
+    return (log_format_t) storage_configGetNum(CONFIG_LOG_FORMAT);
+}
+
+bool storage_addToLogFile(char* text, uint16_t len, log_format_t format, uint32_t time)
+{
+    uint32_t start = micros();
+
+    if (len > LOG_WRITE_BUF_LEN)
         return false;
 
+    // Only touch the card and directory on rollover, format change or error
     uint32_t now = clock_getLocalNowSeconds();
-    int8_t this_hour = hour(now);
-
-    static char filename[50];
-    snprintf(filename, 50, "%s_%04d-%02d-%02d_%02d.csv",
-             storage_configGetString(CONFIG_DEV_NAME),
-             year(now), month(now), day(now), hour(now));
-    
-    // Open new file if onto next hour or first run
-    if (this_hour != file_hour || !_sd.exists(filename))
+    if (!_log.file.isOpen() || _log.error || now < _log.start || now >= _log.rollover ||
+        _log.requested != (log_format_t) storage_configGetNum(CONFIG_LOG_FORMAT))
     {
-        if (file.isOpen())
-            file.close();
-
-        Serial.printf("Starting file \"%s\"...\r\n", filename);
-        file_hour = this_hour;
+        if (!_logOpen())
+            return false;
     }
 
-    if (!file.isOpen())
+    // Caller must retry in the format of the newly opened file
+    if (format != _log.format)
+        return false;
+
+    // A row after a mask comment is indexed at the comment
+    uint32_t offset = _log.file.fileSize() + _log_buf_len;
+    if (format == LOG_FORMAT_CSV && !_logMask(time))
+        return false;
+
+    if (!_logAppend(text, len))
+        return false;
+
+    _indexAdd(time, offset);
+
+    // The hour's entry also covers its file in the other format, if any
+    if (_log.catalog >= 0)
     {
-        if (!file.open(filename, O_RDWR | O_CREAT | O_APPEND))
-        {
-            Serial.println("Failed to open file!");
-            return false;
-        }
+        log_catalog_entry_t* entry = &_catalog[_log.catalog];
+
+        if (!entry->samples || time < entry->first)
+            entry->first = time;
+        if (!entry->samples || time > entry->last)
+            entry->last = time;
+        entry->samples++;
+        entry->size += len;
     }
 
-    if (file.write(text, len) != len)
+    uint32_t elapsed = micros() - start;
+    _log_appends++;
+    _log_append_us += elapsed;
+    if (elapsed > _log_append_max_us)
+        _log_append_max_us = elapsed;
+
+    return true;
+}
+
+void storage_serviceLog()
+{
+    if (_log_pending && millis() - _log_pending_since >= LOG_FLUSH_MS)
+        storage_flushLog();
+
+    if (_imu.len && millis() - _imu.pending_since >= LOG_FLUSH_MS)
+        _sideFlush(&_imu, true);
+
+    if (_scan.len && millis() - _scan.pending_since >= LOG_FLUSH_MS)
+        _sideFlush(&_scan, true);
+}
+
+bool storage_flushLog()
+{
+    if (!_log.file.isOpen())
+        return !_log_buf_len;
+
+    if (!_logWrite(true))
+        return false;
+
+    if (!_log.file.flush())
+    {
+        _log.error = true;
         return false;
+    }
 
-    file.flush();
+    // Index is written after the data it points to
+    _indexWrite();
+
+    _log_syncs++;
+    _log_pending = false;
     return true;
 }
 
-uint32_t* storage_getLogFiles(uint16_t* count, uint32_t start, uint32_t end)
+const log_catalog_entry_t* storage_getLogFiles(uint16_t* count, uint32_t start, uint32_t end)
+{
+    if (!start || !end)
+    {
+        *count = _catalog_len;
+        return _catalog;
+    }
+
+    uint16_t first = _catalogLowerBound(start);
+    uint16_t last = _catalogLowerBound(end + 1);
+
+    *count = (last > first) ? last - first : 0;
+    return _catalog + first;
+}
+
+bool storage_catalogRebuild()
 {
-    *count = 0;
-    uint16_t arr_size = 4;
-    uint32_t* data;
     FsFile dir, file;
     uint8_t name_len = strlen(storage_configGetString(CONFIG_DEV_NAME));
 
-    dir.open("/");
-    if (!dir.isDir())
-        return nullptr;
+    _catalog_len = 0;
+
+    if (!dir.open("/") || !dir.isDir())
+        return false;
 
-    data = (uint32_t*) malloc(arr_size * sizeof(uint32_t));
     dir.rewindDirectory();
 
     file = dir.openNextFile(O_RDONLY);
@@ -386,8 +949,19 @@ uint32_t* storage_getLogFiles(uint16_t* count, uint32_t start, uint32_t end)
     {
         char name[128];
         file.getName(name, 128);
+        file.close();
 
-        if (!strncmp(storage_configGetString(CONFIG_DEV_NAME), name, name_len))
+        // Only count log files, not their indexes
+        char* ext = strrchr(name, '.');
+        log_format_t format = LOG_FORMAT_CSV;
+        bool is_log = ext && !strncmp(storage_configGetString(CONFIG_DEV_NAME), name, name_len);
+
+        if (is_log && !strcmp(ext + 1, log_extensions[LOG_FORMAT_BIN]))
+            format = LOG_FORMAT_BIN;
+        else if (is_log && strcmp(ext + 1, log_extensions[LOG_FORMAT_CSV]))
+            is_log = false;
+
+        if (is_log)
         {
             uint8_t hr, day, month;
             uint16_t yr;
@@ -402,132 +976,325 @@ uint32_t* storage_getLogFiles(uint16_t* count, uint32_t start, uint32_t end)
             hr = _str2int(curs, 2);
 
             uint32_t time = clock_localHumanToUtc(hr, 0, 0, day, month, yr);
+            int16_t i = _catalogFind(time, true);
 
-            if (!start || !end || (time >= start && time <= end))
-            {
-                (*count)++;
-                if (*count > arr_size)
-                {
-                    arr_size *= 2;
-                    data = (uint32_t*) realloc(data, arr_size);
-                }
-                data[*count - 1] = time;
-            }
+            // An hour with a file in each format is scanned once
+            if (i >= 0 && !(_catalog[i].formats & (1 << format)))
+                _catalogScan(&_catalog[i]);
         }
 
         file = dir.openNextFile(O_RDONLY);
     }
 
-    return data;
+    Serial.printf("Catalogued %d log files.\r\n", _catalog_len);
+    _catalogAttach();
+    return _catalogSave();
 }
 
 bool storage_getNextSample(uint32_t time, log_entry_t* log)
 {
-    static uint32_t last_time = 0;
-    static FsFile file;
+    time = _localHour(time);
 
-    time -= 25200;
-
-    if (time != last_time || !file.isOpen())
+    if (time != _reader.hour || !_reader.file.isOpen())
     {
-        char filename[50];
-        snprintf(filename, 50, "%s_%04d-%02d-%02d_%02d.csv",
-                storage_configGetString(CONFIG_DEV_NAME),
-                year(time), month(time), day(time), hour(time));
-        
-        if (!file.open(filename, O_RDONLY))
-            Serial.printf("Failed to open %s\r\n", filename);
+        if (!_readerOpen(time))
+            return false;
     }
 
-    last_time = time;
-
-    if (!file.isOpen())
+    do
     {
-        Serial.print("File not open");
-        return false;
-    }
-
-    char line[200];
-    file.setTimeout(100);
-    file.readBytesUntil('\n', line, 200);
+        if (_readerSample(log))
+        {
+            _reader.sample++;
+            return true;
+        }
 
-    uint8_t count = sscanf(line, "%lu.%hu,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hd",
-        &(log->time), &(log->millis), &(log->mpu_accel[0]), &(log->mpu_accel[1]), &(log->mpu_accel[2]),
-        &(log->mpu_gyro[0]), &(log->mpu_gyro[1]), &(log->mpu_gyro[2]), &(log->mpu_temp),
-        &(log->adc_data[0]), &(log->adc_data[1]), &(log->adc_data[2]), &(log->adc_data[3]),
-        &(log->adc_data[4]), &(log->adc_data[5]), &(log->adc_data[6]), &(log->adc_data[7]),
-        &(log->adc_data[8]), &(log->adc_data[9]), &(log->adc_data[10]), &(log->adc_data[11]),
-        &(log->adc_data[12]), &(log->adc_data[13]), &(log->adc_data[14]), &(log->adc_data[15]));
+    // Carry on into the hour's file in the other format, if any
+    } while (_reader.current + 1 < _reader.files && _readerOpenFile(_reader.current + 1, _reader.sample));
 
-    if (count < 9)
-    {
-        Serial.printf("Failed to parse line\r\n");
-        return false;
-    }
+    // End of the hour, the next request for it starts from the beginning
+    _reader.file.close();
+    return false;
+}
 
-    return true;
+uint8_t storage_getSampleChannels()
+{
+    return _reader.channels;
 }
 
-bool storage_console(uint8_t argc, char* argv[])
+uint16_t storage_getSampleMask()
 {
-    if (!strcmp("init", argv[1]))
-    {
-        return storage_init();
-    }
-    
-    if (!strcmp("format", argv[1]))
-    {       
-        return storage_format();
-    }
+    // CSV files from before masks were recorded are taken as the lowest
+    //   channels
+    if (!_reader.mask)
+        return (1UL << _reader.channels) - 1;
 
-    if (!strcmp("ls", argv[1]))
-    {
-        if (!storage_start())
-            return false;
+    return _reader.mask;
+}
 
-        Serial.println("Last Modified    Size (Bytes) Filename");
-        _sd.ls(LS_DATE | LS_SIZE);
+bool storage_seekSample(uint32_t time, uint32_t sample_time, uint16_t millis)
+{
+    uint32_t hour = _localHour(time);
+    log_index_entry_t entry;
+    log_entry_t log;
 
-        return true;
-    }
+    if (!_readerOpen(hour))
+        return false;
 
-    if (!strcmp("cat", argv[1]))
+    // Samples after the second file starts are all in it
+    if (_reader.files > 1 && sample_time >= _reader.first[1])
     {
-        if (!storage_start())
+        uint32_t base = _readerCount();
+        if (!_readerOpenFile(1, base))
             return false;
+    }
 
-        if (argc < 3)
+    // Jump to the start of the indexed second, otherwise walk from the start
+    if (_indexFind(hour, _reader.format, sample_time, &entry, false))
+        _readerJump(&entry);
+
+    while (storage_getNextSample(time, &log))
+    {
+        if (log.time > sample_time || (log.time == sample_time && log.millis >= millis))
         {
-            Serial.println("Must specify a filename");
-            return false;
+            _readerUnread();
+            return true;
         }
+    }
 
-        char fname[128];
-        char* fcurs = fname;
-        for (int i = 0; i < argc - 2; i++)
-        {
-            char* wcurs = argv[i + 2];
+    return false;
+}
 
-            while (*wcurs != '\0') *fcurs++ = *wcurs++;
-            *fcurs++ = ' ';
-        }
-        *(--fcurs) = '\0';
+bool storage_seekSampleIndex(uint32_t time, uint32_t sample)
+{
+    uint32_t hour = _localHour(time);
 
-        if (!_sd.exists(fname))
-        {
-            Serial.printf("File \"%s\" does not exist\r\n", fname);
+    if (!_readerOpen(hour))
+        return false;
+
+    // Samples past the end of the first file are in the second
+    if (_reader.files > 1)
+    {
+        uint32_t count = _readerCount();
+        if (sample >= count && !_readerOpenFile(1, count))
             return false;
-        }
+    }
 
-        FsFile cat_file;
-        cat_file.open(fname, O_RDONLY);
+    return _readerSeekIndex(sample);
+}
 
-        char read_buf[128];
-        while (cat_file.available())
-        {
-            size_t read_size = (cat_file.available() > 127) ? 127 : cat_file.available();
-            cat_file.readBytes(read_buf, read_size);
-            read_buf[read_size] = '\0';
+uint32_t storage_getSampleIndex()
+{
+    return _reader.sample;
+}
+
+bool storage_addToImuFile(const mpu_sample_t* sample)
+{
+    log_imu_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOG_IMU_MAGIC, sizeof(header.magic));
+    header.version = LOG_IMU_VERSION;
+    header.header_size = sizeof(header);
+    header.record_size = sizeof(mpu_sample_t);
+    header.rate = mpu_fifoRate();
+    header.mpu_id = (uint8_t) storage_configGetNum(CONFIG_MPU_ID);
+    header.accel_range = mpu_getAccelRange();
+    header.gyro_range = mpu_getGyroRange();
+
+    return _sideAdd(&_imu, sample->time, &header, sizeof(header), sample, sizeof(*sample));
+}
+
+bool storage_addToScanFile(const log_scan_block_t* block)
+{
+    log_scan_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOG_SCAN_MAGIC, sizeof(header.magic));
+    header.version = LOG_SCAN_VERSION;
+    header.header_size = sizeof(header);
+    header.block_header_size = offsetof(log_scan_block_t, adc_data);
+
+    return _sideAdd(&_scan, block->time, &header, sizeof(header), block, LOG_SCAN_BLOCK_SIZE(block));
+}
+
+uint16_t storage_getImuSamples(uint32_t time, uint32_t first, mpu_sample_t* out, uint16_t max)
+{
+    char filename[LOG_FILENAME_LEN];
+    log_imu_header_t header;
+    FsFile file;
+    uint16_t n = 0;
+
+    if (!_sd_open)
+        return 0;
+
+    _logFileName(filename, sizeof(filename), _localHour(time), IMU_EXT);
+    if (!file.open(filename, O_RDONLY))
+        return 0;
+
+    if (file.read(&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, LOG_IMU_MAGIC, sizeof(header.magic)) ||
+        !header.version || header.version > LOG_IMU_VERSION ||
+        header.header_size < sizeof(header) || header.record_size < sizeof(mpu_sample_t))
+    {
+        Serial.printf("Invalid header in %s\r\n", filename);
+        file.close();
+        return 0;
+    }
+
+    if (file.seekSet(header.header_size + (uint64_t) first * header.record_size))
+    {
+        for (; n < max; n++)
+        {
+            if (file.read(&out[n], sizeof(*out)) != sizeof(*out))
+                break;
+
+            // Skip any fields newer firmware added
+            if (header.record_size > sizeof(*out))
+                file.seekCur(header.record_size - sizeof(*out));
+        }
+    }
+
+    file.close();
+    return n;
+}
+
+void storage_addToRollup(const log_entry_t* entry, uint8_t channels)
+{
+    uint32_t minute = entry->time - entry->time % SECS_PER_MIN;
+
+    if (minute != _rollup.minute || channels != _rollup.channels)
+    {
+        _rollupWrite();
+
+        _rollup.minute = minute;
+        _rollup.channels = channels;
+        _rollup.count = 0;
+        _rollup.written = 0;
+    }
+
+    for (uint8_t i = 0; i < 7 + channels; i++)
+    {
+        int32_t value = _rollupValue(entry, i);
+
+        if (!_rollup.count || value < _rollup.min[i])
+            _rollup.min[i] = value;
+        if (!_rollup.count || value > _rollup.max[i])
+            _rollup.max[i] = value;
+        _rollup.sum[i] = (_rollup.count ? _rollup.sum[i] : 0) + value;
+    }
+
+    _rollup.count++;
+}
+
+bool storage_getNextRollup(uint32_t start, uint32_t end, log_rollup_t* rollup)
+{
+    uint32_t hour = start - start % SECS_PER_HOUR;
+
+    if (!_sd_open)
+        return false;
+
+    // Going backwards within the open file means reading it again
+    if (_rollup_file.isOpen() && (hour != _rollup_hour || start <= _rollup_last))
+        _rollup_file.close();
+
+    while (true)
+    {
+        if (!_rollup_file.isOpen())
+        {
+            char filename[LOG_FILENAME_LEN];
+
+            // Only hours with log files have rollups, so move on to the next
+            //   one in the catalog rather than trying every hour in between.
+            //   _localHour(0) is the timezone offset.
+            uint16_t i = _catalogLowerBound(hour - _localHour(0));
+
+            if (i == _catalog_len || _localHour(_catalog[i].hour) > end)
+                return false;
+
+            hour = _localHour(_catalog[i].hour);
+            _rollup_hour = hour;
+            _rollup_last = 0;
+            _logFileName(filename, sizeof(filename), hour, ROLLUP_EXT);
+            _rollup_file.open(filename, O_RDONLY);
+        }
+
+        while (_rollup_file.isOpen() &&
+               _rollup_file.read(rollup, sizeof(*rollup)) == sizeof(*rollup))
+        {
+            _rollup_last = rollup->minute;
+
+            if (rollup->minute > end)
+                return false;
+            if (rollup->minute >= start)
+                return true;
+        }
+
+        _rollup_file.close();
+        hour = _rollup_hour + SECS_PER_HOUR;
+    }
+}
+
+bool storage_console(uint8_t argc, char* argv[])
+{
+    if (!strcmp("init", argv[1]))
+    {
+        return storage_init();
+    }
+    
+    if (!strcmp("format", argv[1]))
+    {       
+        return storage_format();
+    }
+
+    if (!strcmp("ls", argv[1]))
+    {
+        if (!storage_start())
+            return false;
+
+        Serial.println("Last Modified    Size (Bytes) Filename");
+        _sd.ls(LS_DATE | LS_SIZE);
+
+        return true;
+    }
+
+    if (!strcmp("cat", argv[1]))
+    {
+        if (!storage_start())
+            return false;
+
+        if (argc < 3)
+        {
+            Serial.println("Must specify a filename");
+            return false;
+        }
+
+        char fname[128];
+        char* fcurs = fname;
+        for (int i = 0; i < argc - 2; i++)
+        {
+            char* wcurs = argv[i + 2];
+
+            while (*wcurs != '\0') *fcurs++ = *wcurs++;
+            *fcurs++ = ' ';
+        }
+        *(--fcurs) = '\0';
+
+        if (!_sd.exists(fname))
+        {
+            Serial.printf("File \"%s\" does not exist\r\n", fname);
+            return false;
+        }
+
+        FsFile cat_file;
+        cat_file.open(fname, O_RDONLY);
+
+        char read_buf[128];
+        while (cat_file.available())
+        {
+            size_t read_size = (cat_file.available() > 127) ? 127 : cat_file.available();
+            cat_file.readBytes(read_buf, read_size);
+            read_buf[read_size] = '\0';
 
             Serial.print(read_buf);
         }
@@ -578,22 +1345,55 @@ bool storage_console(uint8_t argc, char* argv[])
             Serial.print("No date range specified - ");
 
         uint16_t len = 0;
-        uint32_t* data = storage_getLogFiles(&len, start, end);
+        const log_catalog_entry_t* data = storage_getLogFiles(&len, start, end);
         
         Serial.printf("Found %d log files\r\n", len);
 
         for (int i = 0; i < len; i++)
-            Serial.printf("%s%d", (i == 0) ? "" : ", ", data[i]);
+            Serial.printf("%s%d", (i == 0) ? "" : ", ", data[i].hour);
 
         Serial.println();
-        free(data);
+
+        return true;
+    }
+
+    if (!strcmp("catalog", argv[1]))
+    {
+        if (argc > 2 && !strcmp("rebuild", argv[2]) && !storage_catalogRebuild())
+            return false;
+
+        Serial.println("Hour (UTC)  First       Last        Samples  Size (Bytes) Format");
+        for (uint16_t i = 0; i < _catalog_len; i++)
+        {
+            uint8_t formats = _catalog[i].formats;
+
+            Serial.printf("%-11lu %-11lu %-11lu %-8lu %-12lu %s%s%s\r\n",
+                          _catalog[i].hour, _catalog[i].first, _catalog[i].last,
+                          _catalog[i].samples, _catalog[i].size,
+                          (formats & (1 << LOG_FORMAT_CSV)) ? log_extensions[LOG_FORMAT_CSV] : "",
+                          (formats == ((1 << LOG_FORMAT_CSV) | (1 << LOG_FORMAT_BIN))) ? "+" : "",
+                          (formats & (1 << LOG_FORMAT_BIN)) ? log_extensions[LOG_FORMAT_BIN] : "");
+        }
+
+        return true;
+    }
+
+    if (!strcmp("stats", argv[1]))
+    {
+        Serial.printf("Buffered:   %d / %d bytes\r\n", _log_buf_len, LOG_WRITE_BUF_LEN);
+        Serial.printf("Writes:     %lu (%lu bytes)\r\n", _log_writes, _log_bytes);
+        Serial.printf("Syncs:      %lu\r\n", _log_syncs);
+        Serial.printf("Append:     %lu us avg, %lu us max\r\n",
+                      _log_appends ? _log_append_us / _log_appends : 0, _log_append_max_us);
+        Serial.printf("Write rate: %.1f KB/s\r\n",
+                      _log_write_us ? (_log_bytes * 1000.0) / (_log_write_us * 1.024) : 0.0);
 
         return true;
     }
 
     if (!strcmp("get", argv[1]))
     {
-        if (argc != 3)
+        if (argc < 3)
             return false;
 
         uint32_t time = atoi(argv[2]);
@@ -601,6 +1401,13 @@ bool storage_console(uint8_t argc, char* argv[])
         log_entry_t e;
         memset(&e, 0, sizeof(log_entry_t));
 
+        // Optionally seek to a sample time and millis first
+        if (argc > 3 && !storage_seekSample(time, atoi(argv[3]), (argc > 4) ? atoi(argv[4]) : 0))
+        {
+            Serial.println("No sample at or after that time");
+            return false;
+        }
+
         storage_getNextSample(time, &e);
     
         for (uint8_t i = 0; i < sizeof(log_entry_t); i++)
@@ -610,6 +1417,36 @@ bool storage_console(uint8_t argc, char* argv[])
         return true;
     }
 
+    if (!strcmp("imu", argv[1]))
+    {
+        if (argc < 3)
+            return false;
+
+        mpu_sample_t samples[16];
+        uint32_t first = (argc > 3) ? atoi(argv[3]) : 0;
+        uint32_t count = (argc > 4) ? atoi(argv[4]) : 10;
+
+        while (count)
+        {
+            uint16_t n = storage_getImuSamples(atoi(argv[2]), first, samples, min(count, (uint32_t) 16));
+            if (!n)
+                break;
+
+            for (uint16_t i = 0; i < n; i++)
+            {
+                mpu_sample_t* s = &samples[i];
+                Serial.printf("%lu.%03u, %d, %d, %d, %d, %d, %d, %d\r\n", s->time, s->millis,
+                              s->accel[0], s->accel[1], s->accel[2],
+                              s->gyro[0], s->gyro[1], s->gyro[2], s->temp);
+            }
+
+            first += n;
+            count -= n;
+        }
+
+        return true;
+    }
+
     return false;
 }
 
@@ -638,3 +1475,1037 @@ static uint16_t _str2int(const char* str, uint16_t len)
 
     return val;
 }
+
+static bool _logWrite(bool all)
+{
+    uint32_t len = _log_buf_len;
+
+    if (!len)
+        return true;
+
+    if (!all)
+    {
+        // Top up any partial sector left by a deadline flush, then whole sectors
+        uint32_t partial = _log.file.fileSize() % SECTOR_SIZE;
+        if (len + partial < SECTOR_SIZE)
+            return true;
+
+        len = ((len + partial) / SECTOR_SIZE) * SECTOR_SIZE - partial;
+    }
+
+    uint32_t start = micros();
+    if (_log.file.write(_log_buf, len) != len)
+    {
+        Serial.println("Failed to write log data!");
+        _log.error = true;
+        return false;
+    }
+
+    _log_write_us += micros() - start;
+    _log_writes++;
+    _log_bytes += len;
+
+    // Keep the unwritten tail at the front of the buffer
+    memmove(_log_buf, _log_buf + len, _log_buf_len - len);
+    _log_buf_len -= len;
+
+    return true;
+}
+
+static bool _logOpen()
+{
+    _logClose();
+
+    if ((_log.error || !_sd_open) && !storage_start())
+        return false;
+
+    uint32_t now = clock_getLocalNowSeconds();
+    _log.start = now - (now % SECS_PER_HOUR);
+    _log.rollover = _log.start + SECS_PER_HOUR;
+    _log.requested = (log_format_t) storage_configGetNum(CONFIG_LOG_FORMAT);
+    _log.format = (_log.requested == LOG_FORMAT_BIN) ? LOG_FORMAT_BIN : LOG_FORMAT_CSV;
+
+    _logFileName(_log.filename, sizeof(_log.filename), now, log_extensions[_log.format]);
+    Serial.printf("Starting file \"%s\"...\r\n", _log.filename);
+
+    if (!_log.file.open(_log.filename, O_RDWR | O_CREAT | O_APPEND))
+    {
+        Serial.println("Failed to open file!");
+        _log.error = true;
+        return false;
+    }
+
+    _log.error = false;
+
+    if (_log.format != LOG_FORMAT_BIN)
+    {
+        _indexOpen(0);
+        _logMaskOpen();
+        return true;
+    }
+
+    log_bin_header_t header;
+    _logHeader(&header);
+
+    if (!_log.file.fileSize())
+    {
+        _indexOpen(header.record_size);
+
+        if (_log.catalog >= 0)
+            _catalog[_log.catalog].size += sizeof(header);
+
+        return _logAppend(&header, sizeof(header));
+    }
+
+    // Records can only be appended if the layout has not changed this hour
+    log_bin_header_t existing;
+    _log.file.seekSet(0);
+    if (_log.file.read(&existing, sizeof(existing)) == sizeof(existing) &&
+        !memcmp(&existing, &header, sizeof(header)))
+    {
+        _indexOpen(header.record_size);
+        return true;
+    }
+
+    Serial.println("Log settings changed, using CSV for the rest of the hour.");
+    _log.file.close();
+    _log.format = LOG_FORMAT_CSV;
+    _logFileName(_log.filename, sizeof(_log.filename), now, log_extensions[_log.format]);
+
+    if (!_log.file.open(_log.filename, O_RDWR | O_CREAT | O_APPEND))
+    {
+        Serial.println("Failed to open file!");
+        _log.error = true;
+        return false;
+    }
+
+    _indexOpen(0);
+    _logMaskOpen();
+    return true;
+}
+
+static bool _logAppend(const void* data, uint16_t len)
+{
+    // Make room by writing out whole sectors
+    if (_log_buf_len + len > LOG_WRITE_BUF_LEN && !_logWrite(false))
+        return false;
+
+    if (_log_buf_len + len > LOG_WRITE_BUF_LEN)
+        return false;
+
+    memcpy(_log_buf + _log_buf_len, data, len);
+    _log_buf_len += len;
+
+    if (!_log_pending)
+    {
+        _log_pending = true;
+        _log_pending_since = millis();
+    }
+
+    return true;
+}
+
+static bool _logFileName(char* buf, size_t len, uint32_t time, const char* ext)
+{
+    int written = snprintf(buf, len, "%.*s_%04d-%02d-%02d_%02d.%s",
+                           CONFIG_STRING_LEN - 1, storage_configGetString(CONFIG_DEV_NAME),
+                           year(time), month(time), day(time), hour(time), ext);
+
+    // An empty name fails to open instead of opening the wrong file
+    if (written < 0 || (size_t) written >= len)
+    {
+        buf[0] = '\0';
+        return false;
+    }
+
+    return true;
+}
+
+static void _logMaskOpen()
+{
+    char buf[CSV_MASK_MAX_LEN];
+    uint16_t mask = logger_channelMask();
+    uint16_t first = mask;
+
+    // Only the first line can hold the mask the whole file starts with
+    if (_log.file.fileSize())
+    {
+        char* end;
+        int read;
+
+        first = 0;
+        _log.file.seekSet(0);
+        if ((read = _log.file.read(buf, sizeof(buf))) > 0 &&
+            (end = (char*) memchr(buf, '\n', read)))
+        {
+            if (end > buf && *(end - 1) == '\r')
+                end--;
+
+            csv_parseComment(buf, end - buf, &first);
+        }
+    }
+
+    _log.mask_pending = true;
+    _log.mask_each_second = (first != mask);
+}
+
+static bool _logMask(uint32_t time)
+{
+    char line[CSV_MASK_MAX_LEN];
+
+    if (!_log.mask_pending && !(_log.mask_each_second && _log.indexed && time != _log.index_time))
+        return true;
+
+    uint16_t len = csv_formatMask(line, logger_channelMask());
+    if (!_logAppend(line, len))
+        return false;
+
+    // The row after the comment is indexed at the comment, even in the same
+    //   second as the last entry
+    _log.mask_pending = false;
+    _log.index_time = 0;
+
+    if (_log.catalog >= 0)
+        _catalog[_log.catalog].size += len;
+
+    return true;
+}
+
+static void _logHeader(log_bin_header_t* header)
+{
+    uint16_t mask = logger_channelMask();
+    const char* name = storage_configGetString(CONFIG_DEV_NAME);
+    size_t name_len = strnlen(name, sizeof(header->device_name) - 1);
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, LOG_BIN_MAGIC, sizeof(header->magic));
+    header->version = LOG_BIN_VERSION;
+    header->header_size = sizeof(*header);
+    header->channel_mask = mask;
+    header->channel_count = logger_channelCount();
+
+    // Older readers only understand a range of channels
+    header->channel_bottom = mask ? __builtin_ctz(mask) : 0;
+    header->channel_top = mask ? 31 - __builtin_clz(mask) : 0;
+    header->record_size = LOG_BIN_RECORD_SIZE(header->channel_count);
+    memcpy(header->device_name, name, name_len);
+    header->device_name[name_len] = '\0';
+    header->poll_rate = (uint16_t) storage_configGetNum(CONFIG_POLL_RATE);
+    header->mpu_id = (uint8_t) storage_configGetNum(CONFIG_MPU_ID);
+    header->accel_range = mpu_getAccelRange();
+    header->gyro_range = mpu_getGyroRange();
+    header->timezone = (int8_t) storage_configGetNum(CONFIG_TIMEZONE);
+    header->adc_bits = adc_resolution();
+}
+
+static bool _sideAdd(log_side_t* side, uint32_t time, const void* header, uint8_t header_len,
+                     const void* record, uint16_t len)
+{
+    uint32_t hour = time - time % SECS_PER_HOUR;
+
+    if (!_sd_open || len > side->size)
+        return false;
+
+    if (!side->file.isOpen() || hour != side->start)
+    {
+        // Buffered records belong to the previous hour's file
+        if (!_sideFlush(side, true) || !_sideOpen(side, hour, header, header_len))
+            return false;
+    }
+
+    if (side->len + len > side->size && !_sideFlush(side, false))
+        return false;
+
+    if (!side->len)
+        side->pending_since = millis();
+
+    memcpy(side->buf + side->len, record, len);
+    side->len += len;
+
+    return true;
+}
+
+static bool _sideOpen(log_side_t* side, uint32_t hour, const void* header, uint8_t header_len)
+{
+    char filename[LOG_FILENAME_LEN];
+
+    if (side->file.isOpen())
+        side->file.close();
+
+    side->start = hour;
+    _logFileName(filename, sizeof(filename), hour, side->ext);
+
+    if (!side->file.open(filename, O_RDWR | O_CREAT | O_APPEND))
+    {
+        Serial.printf("Failed to open %s\r\n", filename);
+        return false;
+    }
+
+    if (side->file.fileSize())
+        return true;
+
+    if (side->file.write(header, header_len) != header_len)
+    {
+        side->file.close();
+        return false;
+    }
+
+    return true;
+}
+
+static bool _sideFlush(log_side_t* side, bool sync)
+{
+    if (!side->file.isOpen())
+        return true;
+
+    if (side->len)
+    {
+        if (side->file.write(side->buf, side->len) != side->len)
+        {
+            // Reopened on the next record
+            side->file.close();
+            return false;
+        }
+
+        side->len = 0;
+    }
+
+    return !sync || side->file.flush();
+}
+
+static int32_t _rollupValue(const log_entry_t* entry, uint8_t i)
+{
+    if (i < 3)
+        return entry->mpu_accel[i];
+    if (i < 6)
+        return entry->mpu_gyro[i - 3];
+    if (i == 6)
+        return entry->mpu_temp;
+
+    return entry->adc_data[i - 7];
+}
+
+static void _rollupWrite()
+{
+    log_rollup_t rollup;
+    char filename[LOG_FILENAME_LEN];
+    FsFile file;
+
+    if (!_rollup.minute || !_rollup.count || _rollup.count == _rollup.written || !_sd_open)
+        return;
+
+    memset(&rollup, 0, sizeof(rollup));
+    rollup.minute = _rollup.minute;
+    rollup.count = min(_rollup.count, (uint32_t) UINT16_MAX);
+    rollup.channels = _rollup.channels;
+
+    for (uint8_t i = 0; i < 7 + _rollup.channels; i++)
+    {
+        rollup.min[i] = (uint16_t) _rollup.min[i];
+        rollup.max[i] = (uint16_t) _rollup.max[i];
+        rollup.mean[i] = (uint16_t) (_rollup.sum[i] / _rollup.count);
+    }
+
+    // Written once a minute, so the file is only opened when needed. A
+    //   minute already written when the log was closed replaces that copy.
+    _logFileName(filename, sizeof(filename), _rollup.minute, ROLLUP_EXT);
+    if (!file.open(filename, O_RDWR | O_CREAT) ||
+        !file.seekSet(file.fileSize() - (_rollup.written ? sizeof(rollup) : 0)) ||
+        file.write(&rollup, sizeof(rollup)) != sizeof(rollup))
+        Serial.printf("Failed to write rollup to %s\r\n", filename);
+    else
+        _rollup.written = _rollup.count;
+
+    file.close();
+}
+
+static bool _readerOpen(uint32_t time)
+{
+    char filename[LOG_FILENAME_LEN];
+
+    if (_reader.file.isOpen())
+        _reader.file.close();
+
+    _reader.hour = time;
+    _reader.files = 0;
+
+    for (uint8_t f = LOG_FORMAT_CSV; f <= LOG_FORMAT_BIN; f++)
+    {
+        _logFileName(filename, sizeof(filename), time, log_extensions[f]);
+        if (_sd.exists(filename))
+            _reader.formats[_reader.files++] = (log_format_t) f;
+    }
+
+    if (!_reader.files)
+    {
+        Serial.printf("No log file for %lu\r\n", time);
+        return false;
+    }
+
+    // With a file in each format, read the one with the earlier samples first
+    for (uint8_t i = 0; i < _reader.files; i++)
+    {
+        log_entry_t log;
+
+        _reader.first[i] = UINT32_MAX;
+        if (_readerOpenFile(i, 0) && _readerSample(&log))
+            _reader.first[i] = log.time;
+    }
+
+    if (_reader.files > 1 && _reader.first[1] < _reader.first[0])
+    {
+        log_format_t format = _reader.formats[0];
+        uint32_t first = _reader.first[0];
+
+        _reader.formats[0] = _reader.formats[1];
+        _reader.first[0] = _reader.first[1];
+        _reader.formats[1] = format;
+        _reader.first[1] = first;
+    }
+
+    return _readerOpenFile(0, 0);
+}
+
+static bool _readerOpenFile(uint8_t file, uint32_t base)
+{
+    char filename[LOG_FILENAME_LEN];
+
+    if (_reader.file.isOpen())
+        _reader.file.close();
+
+    _reader.current = file;
+    _reader.format = _reader.formats[file];
+    _reader.base = base;
+    _reader.pos = 0;
+    _reader.len = 0;
+    _reader.last = 0;
+    _reader.sample = base;
+
+    _logFileName(filename, sizeof(filename), _reader.hour, log_extensions[_reader.format]);
+    if (!_reader.file.open(filename, O_RDONLY))
+    {
+        Serial.printf("Failed to open %s\r\n", filename);
+        return false;
+    }
+
+    if (_reader.format != LOG_FORMAT_BIN)
+    {
+        // The mask comment at the top of the file holds for every row until
+        //   the next comment. Files from before masks have none.
+        const char* line;
+        uint16_t len;
+
+        _reader.mask = 0;
+        if ((line = _readerLine(&len)) && !csv_parseComment(line, len, &_reader.mask))
+            _reader.pos = _reader.last;
+
+        _reader.top_mask = _reader.mask;
+        return true;
+    }
+
+    // Older versions have shorter headers, so read the fields every version
+    //   has first, then however much of the rest this file has
+    log_bin_header_t* header = &_reader.header;
+    uint8_t fixed = offsetof(log_bin_header_t, device_name);
+
+    memset(header, 0, sizeof(*header));
+    if (_reader.file.read(header, fixed) != fixed ||
+        memcmp(header->magic, LOG_BIN_MAGIC, sizeof(header->magic)) ||
+        !header->version || header->version > LOG_BIN_VERSION ||
+        header->header_size < (header->version < 2 ? offsetof(log_bin_header_t, adc_bits) : sizeof(*header)) ||
+        header->record_size < offsetof(log_entry_t, adc_data) ||
+        header->record_size > sizeof(log_entry_t))
+    {
+        Serial.printf("Invalid header in %s\r\n", filename);
+        _reader.file.close();
+        return false;
+    }
+
+    uint8_t rest = min(header->header_size, (uint8_t) sizeof(*header)) - fixed;
+    if (_reader.file.read((uint8_t*) header + fixed, rest) != rest)
+    {
+        Serial.printf("Invalid header in %s\r\n", filename);
+        _reader.file.close();
+        return false;
+    }
+
+    // Version 1 files were always 13-bit and only held a range of channels
+    if (header->version < 2)
+    {
+        header->adc_bits = 13;
+        header->channel_mask = ((1UL << header->channel_count) - 1) << header->channel_bottom;
+    }
+
+    _reader.mask = _reader.top_mask = header->channel_mask;
+    _reader.file.seekSet(header->header_size);
+    return true;
+}
+
+static bool _readerSample(log_entry_t* log)
+{
+    if (_reader.format == LOG_FORMAT_BIN)
+    {
+        memset(log, 0, sizeof(*log));
+        if (!_readerRecord(log, _reader.header.record_size))
+            return false;
+
+        _reader.channels = _reader.header.channel_count;
+        return true;
+    }
+
+    const char* line;
+    uint16_t len;
+
+    while ((line = _readerLine(&len)))
+    {
+        if (csv_parseComment(line, len, &_reader.mask))
+            continue;
+
+        uint8_t count = csv_parseRow(line, len, log);
+        if (count >= 9)
+        {
+            _reader.channels = count - 9;
+            return true;
+        }
+
+        Serial.printf("Failed to parse line\r\n");
+    }
+
+    return false;
+}
+
+static uint32_t _readerCount()
+{
+    uint32_t start = (_reader.format == LOG_FORMAT_BIN) ? _reader.header.header_size : 0;
+    uint32_t count = 0;
+
+    _reader.pos = 0;
+    _reader.len = 0;
+
+    if (_reader.format == LOG_FORMAT_BIN)
+    {
+        count = (_reader.file.fileSize() - start) / _reader.header.record_size;
+    }
+    else
+    {
+        // Rows after the last indexed second are counted by their line endings
+        log_index_entry_t entry = { 0, 0, 0 };
+
+        _indexFind(_reader.hour, _reader.format, UINT32_MAX, &entry, true);
+        count = entry.sample;
+
+        _reader.file.seekSet(entry.offset);
+        count += _csvCountRows(&_reader.file, _reader.buf, LOG_READ_BUF_LEN);
+    }
+
+    _reader.file.seekSet(start);
+    return count;
+}
+
+static bool _readerSeekIndex(uint32_t sample)
+{
+    uint32_t target = sample - _reader.base;
+    log_index_entry_t entry;
+    log_entry_t log;
+
+    // Binary records are all the same size so can be seeked to directly
+    if (_reader.format == LOG_FORMAT_BIN)
+    {
+        uint32_t count = (_reader.file.fileSize() - _reader.header.header_size) / _reader.header.record_size;
+
+        _reader.sample = _reader.base + min(target, count);
+        _reader.file.seekSet(_reader.header.header_size + min(target, count) * _reader.header.record_size);
+        _reader.pos = 0;
+        _reader.len = 0;
+
+        return target < count;
+    }
+
+    // Jump to the start of the second holding the sample, then walk to it
+    if (_indexFind(_reader.hour, _reader.format, target, &entry, true) && entry.sample <= target)
+        _readerJump(&entry);
+
+    while (_reader.sample < sample)
+    {
+        if (!_readerSample(&log))
+            return false;
+
+        _reader.sample++;
+    }
+
+    return true;
+}
+
+static void _readerJump(const log_index_entry_t* entry)
+{
+    _reader.file.seekSet(entry->offset);
+    _reader.pos = 0;
+    _reader.len = 0;
+    _reader.sample = _reader.base + entry->sample;
+
+    // A mask that differs from the one at the top of the file is recorded at
+    //   the start of every indexed second
+    _reader.mask = _reader.top_mask;
+}
+
+static bool _readerFill()
+{
+    if (_reader.pos)
+    {
+        memmove(_reader.buf, _reader.buf + _reader.pos, _reader.len - _reader.pos);
+        _reader.len -= _reader.pos;
+        _reader.pos = 0;
+    }
+
+    if (_reader.len == LOG_READ_BUF_LEN)
+        return false;
+
+    int read = _reader.file.read(_reader.buf + _reader.len, LOG_READ_BUF_LEN - _reader.len);
+    if (read <= 0)
+        return false;
+
+    _reader.len += read;
+    return true;
+}
+
+static const char* _readerLine(uint16_t* len)
+{
+    while (true)
+    {
+        char* start = _reader.buf + _reader.pos;
+        char* end = (char*) memchr(start, '\n', _reader.len - _reader.pos);
+
+        if (end)
+        {
+            _reader.last = _reader.pos;
+            _reader.pos = end - _reader.buf + 1;
+
+            if (end > start && *(end - 1) == '\r')
+                end--;
+
+            *len = end - start;
+            return start;
+        }
+
+        // Discard a line too long to ever fit in the buffer
+        if (!_reader.pos && _reader.len == LOG_READ_BUF_LEN)
+            _reader.pos = _reader.len;
+
+        if (!_readerFill())
+            return nullptr;
+    }
+}
+
+static bool _readerRecord(void* dst, uint16_t size)
+{
+    while (_reader.len - _reader.pos < size)
+    {
+        if (!_readerFill())
+            return false;
+    }
+
+    memcpy(dst, _reader.buf + _reader.pos, size);
+    _reader.last = _reader.pos;
+    _reader.pos += size;
+
+    return true;
+}
+
+static void _readerUnread()
+{
+    _reader.pos = _reader.last;
+    _reader.sample--;
+}
+
+static void _logClose()
+{
+    if (_log.file.isOpen())
+    {
+        // Buffered rows belong to the file being closed, as does the minute
+        //   being summarised. It is rewritten if sampling carries on in
+        //   the same minute.
+        storage_flushLog();
+        _rollupWrite();
+        _log.file.close();
+
+        if (_log.catalog >= 0)
+            _catalogSave();
+    }
+
+    if (_log.index.isOpen())
+        _log.index.close();
+
+    _log.catalog = -1;
+}
+
+static void _indexOpen(uint16_t record_size)
+{
+    char filename[LOG_FILENAME_LEN];
+    uint32_t size = _log.file.fileSize();
+
+    // Every hour gets a catalog entry, kept up to date as samples are added
+    _catalogAttach();
+    if (_log.catalog >= 0)
+        _catalogSave();
+
+    _log.samples = 0;
+    _log.index_time = 0;
+    _log.indexed = false;
+    _index_buf_len = 0;
+
+    _indexFileName(filename, sizeof(filename), _log.start, _log.format);
+    if (!_log.index.open(filename, O_RDWR | O_CREAT | O_APPEND))
+    {
+        Serial.printf("Failed to open %s\r\n", filename);
+        return;
+    }
+
+    // New log file, discard any stale index
+    if (!size)
+    {
+        _log.index.truncate(0);
+        _log.indexed = true;
+        return;
+    }
+
+    log_index_entry_t last;
+    uint32_t entries = _log.index.fileSize() / sizeof(last);
+    if (!entries)
+    {
+        Serial.println("Existing log file has no index, not indexing.");
+        _log.index.close();
+        return;
+    }
+
+    _log.index.seekSet((entries - 1) * sizeof(last));
+    _log.index.read(&last, sizeof(last));
+    _log.index_time = last.time;
+
+    if (record_size)
+    {
+        _log.samples = (size - sizeof(log_bin_header_t)) / record_size;
+    }
+    else
+    {
+        // Count the rows written since the last index entry
+        char buf[SECTOR_SIZE];
+
+        _log.file.seekSet(last.offset);
+        _log.samples = last.sample + _csvCountRows(&_log.file, buf, sizeof(buf));
+    }
+
+    _log.indexed = true;
+}
+
+static void _indexAdd(uint32_t time, uint32_t offset)
+{
+    if (_log.indexed && (time != _log.index_time || !_log.samples))
+    {
+        _index_buf[_index_buf_len++] = { time, offset, _log.samples };
+        _log.index_time = time;
+
+        // The rows may still be in _log_buf, so sync them before the index
+        if (_index_buf_len == INDEX_BUF_LEN && !storage_flushLog())
+        {
+            Serial.println("Failed to flush log, not indexing.");
+            _log.indexed = false;
+            _index_buf_len = 0;
+        }
+    }
+
+    _log.samples++;
+}
+
+static void _indexWrite()
+{
+    if (!_index_buf_len || !_log.indexed)
+        return;
+
+    size_t len = _index_buf_len * sizeof(log_index_entry_t);
+    if (_log.index.write(_index_buf, len) != len || !_log.index.flush())
+    {
+        Serial.println("Failed to write index, not indexing.");
+        _log.indexed = false;
+    }
+
+    _index_buf_len = 0;
+}
+
+static uint32_t _csvCountRows(FsFile* file, char* buf, uint16_t size)
+{
+    uint32_t rows = 0;
+    bool line_start = true;
+    bool comment = false;
+    int read;
+
+    while ((read = file->read(buf, size)) > 0)
+    {
+        for (int i = 0; i < read; i++)
+        {
+            if (line_start)
+                comment = (buf[i] == CSV_COMMENT);
+
+            line_start = (buf[i] == '\n');
+            rows += line_start && !comment;
+        }
+    }
+
+    return rows;
+}
+
+static bool _indexFileName(char* buf, size_t len, uint32_t time, log_format_t format)
+{
+    char ext[LOG_EXT_MAX_LEN + 1];
+
+    snprintf(ext, sizeof(ext), "%s." INDEX_EXT, log_extensions[format]);
+    return _logFileName(buf, len, time, ext);
+}
+
+static bool _indexOpenRead(FsFile* index, uint32_t hour, log_format_t format)
+{
+    char filename[LOG_FILENAME_LEN];
+
+    _indexFileName(filename, sizeof(filename), hour, format);
+    if (index->open(filename, O_RDONLY))
+        return true;
+
+    // An old shared index could belong to either file if there are two
+    _logFileName(filename, sizeof(filename), hour,
+                 log_extensions[format == LOG_FORMAT_BIN ? LOG_FORMAT_CSV : LOG_FORMAT_BIN]);
+    if (_sd.exists(filename))
+        return false;
+
+    _logFileName(filename, sizeof(filename), hour, INDEX_EXT);
+    return index->open(filename, O_RDONLY);
+}
+
+static bool _indexFind(uint32_t hour, log_format_t format, uint32_t key,
+                       log_index_entry_t* entry, bool by_sample)
+{
+    FsFile index;
+
+    if (!_indexOpenRead(&index, hour, format))
+        return false;
+
+    uint32_t count = index.fileSize() / sizeof(*entry);
+    if (!count)
+        return false;
+
+    // Find the last entry at or before the requested time or sample
+    uint32_t low = 0, high = count - 1;
+    while (low < high)
+    {
+        uint32_t mid = (low + high + 1) / 2;
+        log_index_entry_t probe;
+
+        index.seekSet(mid * sizeof(probe));
+        if (index.read(&probe, sizeof(probe)) != sizeof(probe))
+            return false;
+
+        if ((by_sample ? probe.sample : probe.time) <= key)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    index.seekSet(low * sizeof(*entry));
+    return index.read(entry, sizeof(*entry)) == sizeof(*entry);
+}
+
+static bool _catalogLoad()
+{
+    FsFile file;
+    log_catalog_header_t header;
+
+    _catalog_len = 0;
+
+    if (!file.open(CATALOG_NAME, O_RDONLY) ||
+        file.read(&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, CATALOG_MAGIC, sizeof(header.magic)) ||
+        header.version != CATALOG_VERSION || header.count > LOG_CATALOG_LEN ||
+        file.read(_catalog, header.count * sizeof(*_catalog)) != (int) (header.count * sizeof(*_catalog)))
+    {
+        Serial.println("No valid log catalog, rebuilding...");
+        return storage_catalogRebuild();
+    }
+
+    _catalog_len = header.count;
+
+    // The newest file may have been open when power was lost
+    if (_catalog_len)
+        _catalogScan(&_catalog[_catalog_len - 1]);
+
+    _catalogAttach();
+
+    Serial.printf("Loaded %d log catalog entries.\r\n", _catalog_len);
+    return true;
+}
+
+static bool _catalogSave()
+{
+    FsFile file;
+    log_catalog_header_t header;
+
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+    header.version = CATALOG_VERSION;
+    header.count = _catalog_len;
+
+    if (!file.open(CATALOG_NAME, O_RDWR | O_CREAT | O_TRUNC))
+    {
+        Serial.println("Failed to save log catalog!");
+        return false;
+    }
+
+    size_t len = _catalog_len * sizeof(*_catalog);
+    bool ok = file.write(&header, sizeof(header)) == sizeof(header) &&
+              file.write(_catalog, len) == len;
+
+    file.close();
+    return ok;
+}
+
+static int16_t _catalogFind(uint32_t hour, bool insert)
+{
+    uint16_t i = _catalogLowerBound(hour);
+
+    if (i < _catalog_len && _catalog[i].hour == hour)
+        return i;
+
+    if (!insert)
+        return -1;
+
+    // Make room by forgetting the oldest hour
+    if (_catalog_len == LOG_CATALOG_LEN)
+    {
+        if (!i)
+            return -1;
+
+        Serial.println("Log catalog full, dropping oldest entry.");
+        memmove(_catalog, _catalog + 1, (LOG_CATALOG_LEN - 1) * sizeof(*_catalog));
+        _catalog_len--;
+        i--;
+    }
+
+    memmove(_catalog + i + 1, _catalog + i, (_catalog_len - i) * sizeof(*_catalog));
+    memset(&_catalog[i], 0, sizeof(*_catalog));
+    _catalog[i].hour = hour;
+    _catalog_len++;
+
+    return i;
+}
+
+static bool _catalogScan(log_catalog_entry_t* entry)
+{
+    uint32_t hour = entry->hour;
+
+    memset(entry, 0, sizeof(*entry));
+    entry->hour = hour;
+
+    bool found = false;
+    for (uint8_t f = LOG_FORMAT_CSV; f <= LOG_FORMAT_BIN; f++)
+        found |= _catalogScanFile(entry, (log_format_t) f);
+
+    return found;
+}
+
+static bool _catalogScanFile(log_catalog_entry_t* entry, log_format_t format)
+{
+    char filename[LOG_FILENAME_LEN];
+    FsFile file, index;
+    uint32_t local = _localHour(entry->hour);
+    uint32_t samples = 0, first = local, last = local;
+
+    _logFileName(filename, sizeof(filename), local, log_extensions[format]);
+    if (!file.open(filename, O_RDONLY))
+        return false;
+
+    uint32_t size = file.fileSize();
+
+    // Sample times and counts come from the index, if there is one
+    log_index_entry_t first_entry, last_entry;
+    if (_indexOpenRead(&index, local, format) && index.fileSize() >= sizeof(first_entry))
+    {
+        index.read(&first_entry, sizeof(first_entry));
+        index.seekSet(index.fileSize() - (index.fileSize() % sizeof(last_entry)) - sizeof(last_entry));
+        index.read(&last_entry, sizeof(last_entry));
+
+        first = first_entry.time;
+        last = last_entry.time;
+        samples = last_entry.sample;
+
+        if (format == LOG_FORMAT_CSV)
+        {
+            char buf[SECTOR_SIZE];
+
+            file.seekSet(last_entry.offset);
+            samples += _csvCountRows(&file, buf, sizeof(buf));
+        }
+    }
+
+    // Binary files are counted exactly from their size
+    if (format == LOG_FORMAT_BIN)
+    {
+        // Only the sizes are needed, which every version's header starts with
+        log_bin_header_t header;
+        uint8_t fixed = offsetof(log_bin_header_t, device_name);
+
+        file.seekSet(0);
+        if (file.read(&header, fixed) == fixed && header.record_size && size >= header.header_size)
+            samples = (size - header.header_size) / header.record_size;
+    }
+
+    // Merge with the hour's file in the other format
+    if (!entry->formats || first < entry->first)
+        entry->first = first;
+    if (!entry->formats || last > entry->last)
+        entry->last = last;
+    entry->samples += samples;
+    entry->size += size;
+    entry->formats |= 1 << format;
+
+    return true;
+}
+
+static uint16_t _catalogLowerBound(uint32_t hour)
+{
+    uint16_t low = 0, high = _catalog_len;
+
+    while (low < high)
+    {
+        uint16_t mid = (low + high) / 2;
+
+        if (_catalog[mid].hour < hour)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+static void _catalogAttach()
+{
+    _log.catalog = -1;
+
+    if (!_log.file.isOpen())
+        return;
+
+    uint32_t utc = clock_localHumanToUtc(hour(_log.start), 0, 0, day(_log.start),
+                                         month(_log.start), year(_log.start));
+    _log.catalog = _catalogFind(utc, true);
+
+    // Counts are added to as samples are logged, so start from what is on
+    //   the card with nothing left in the buffer
+    if (_log.catalog >= 0)
+    {
+        if (_log_buf_len)
+            storage_flushLog();
+
+        _catalogScan(&_catalog[_log.catalog]);
+    }
+}
+
+static uint32_t _localHour(uint32_t utc)
+{
+    return utc + ((int) storage_configGetNum(CONFIG_TIMEZONE)) * SECS_PER_HOUR;
+}
@@ -0,0 +1,319 @@
+/*
+ * File:    Arduino.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for the parts of the Teensy Arduino core used by the
+ *            modules under test. Serial output goes to stdout unless muted,
+ *            and time comes from the host clock plus an offset tests can
+ *            advance.
+ */
+
+#pragma once
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef bool boolean;
+
+#define F_CPU 120000000
+#define F_BUS 60000000
+
+// As in the Teensy core, these take mixed types. Standard headers must be
+//   included before this one.
+#define min(a, b) ({ typeof(a) _a = (a); typeof(b) _b = (b); (_a < _b) ? _a : _b; })
+#define max(a, b) ({ typeof(a) _a = (a); typeof(b) _b = (b); (_a > _b) ? _a : _b; })
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Added to the host clock by micros() and millis()
+inline uint64_t mock_time_offset_us = 0;
+
+// When set, time only moves through mock_advance (and delay), so simulations
+//   run the same however fast the host is
+inline bool mock_time_frozen = false;
+
+// Time each micros() call takes while frozen, so a loop that waits on it ends
+inline uint32_t mock_micros_cost_us = 0;
+
+// Interrupt raised by a simulated peripheral, run once the frozen clock
+//   reaches `mock_irq_due`
+inline void (*mock_irq)() = NULL;
+inline uint64_t mock_irq_due = UINT64_MAX;
+
+/*
+ * Name:    mock_advance
+ *  us:     microseconds to move the clock forward by
+ * Desc:    Runs the pending interrupt, if due, at its time. Interrupts don't
+ *            nest, as on the Teensy where they share a priority.
+ */
+inline void mock_advance(uint64_t us)
+{
+    static bool in_irq = false;
+    uint64_t end = mock_time_offset_us + us;
+
+    while (!in_irq && mock_irq && mock_irq_due <= end)
+    {
+        if (mock_irq_due > mock_time_offset_us)
+            mock_time_offset_us = mock_irq_due;
+        mock_irq_due = UINT64_MAX;
+
+        in_irq = true;
+        mock_irq();
+        in_irq = false;
+    }
+
+    if (end > mock_time_offset_us)
+        mock_time_offset_us = end;
+}
+
+inline uint64_t _mock_now_us()
+{
+    static const auto start = std::chrono::steady_clock::now();
+
+    if (mock_time_frozen)
+        return mock_time_offset_us;
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + mock_time_offset_us;
+}
+
+inline uint32_t micros()
+{
+    if (mock_time_frozen && mock_micros_cost_us)
+        mock_advance(mock_micros_cost_us);
+    return (uint32_t) _mock_now_us();
+}
+
+inline uint32_t millis() { return (uint32_t) (_mock_now_us() / 1000); }
+inline void delay(uint32_t ms) { mock_advance(ms * 1000ULL); }
+inline void delayMicroseconds(uint32_t us) { mock_advance(us); }
+
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buf, size_t len)
+    {
+        size_t n = 0;
+        while (len-- && write(*buf++))
+            n++;
+        return n;
+    }
+
+    size_t write(const char* str) { return write((const uint8_t*) str, strlen(str)); }
+    size_t write(const char* buf, size_t len) { return write((const uint8_t*) buf, len); }
+
+    virtual int availableForWrite() { return 0; }
+    void flush() {}
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(int n) { return printf("%d", n); }
+    size_t println() { return write("\r\n"); }
+    size_t println(const char* str) { return print(str) + println(); }
+    size_t println(int n) { return print(n) + println(); }
+
+    int printf(const char* format, ...)
+    {
+        char buf[512];
+        va_list args;
+
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+
+        if (len > (int) sizeof(buf) - 1)
+            len = sizeof(buf) - 1;
+
+        return len > 0 ? write((const uint8_t*) buf, len) : len;
+    }
+};
+
+class Stream : public Print
+{
+  public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    void setTimeout(unsigned long) {}
+
+    size_t readBytes(char* buf, size_t len)
+    {
+        size_t n = 0;
+        int c;
+
+        while (n < len && (c = read()) >= 0)
+            buf[n++] = (char) c;
+        return n;
+    }
+
+    size_t readBytesUntil(char end, char* buf, size_t len)
+    {
+        size_t n = 0;
+        int c;
+
+        while (n < len && (c = read()) >= 0 && c != end)
+            buf[n++] = (char) c;
+        return n;
+    }
+};
+
+// Console output, printed to stdout unless `muted`
+class usb_serial_class : public Stream
+{
+  public:
+    bool muted = false;
+
+    void begin(uint32_t) {}
+    operator bool() { return true; }
+
+    size_t write(uint8_t c) override
+    {
+        if (!muted)
+            putchar(c);
+        return 1;
+    }
+
+    using Print::write;
+};
+
+inline usb_serial_class Serial;
+
+// UART that sends queued bytes at its baud rate as the mock clock moves on.
+//   Bytes sent end up in `sent` for the test to take, and the test feeds what
+//   the other end says into `rx`.
+class HardwareSerial : public Stream
+{
+  public:
+    uint32_t baud = 0;
+    size_t tx_capacity = 63;    // Teensy's 64 byte buffer holds 63
+    std::deque<uint8_t> tx;     // Queued, not sent yet
+    std::deque<uint8_t> rx;
+    std::vector<uint8_t> sent;
+    uint32_t blocked = 0;       // Writes that had to wait for room
+
+    void begin(uint32_t rate)
+    {
+        baud = rate;
+        _last_us = _mock_now_us();
+    }
+
+    void addMemoryForWrite(void*, size_t len) { tx_capacity += len; }
+
+    // Move the bytes the UART has had time to send since the last call
+    void drain()
+    {
+        uint64_t now = _mock_now_us();
+        uint64_t byte_us = 10000000ULL / baud;
+
+        while (!tx.empty() && now - _last_us >= byte_us)
+        {
+            sent.push_back(tx.front());
+            tx.pop_front();
+            _last_us += byte_us;
+        }
+
+        if (tx.empty())
+            _last_us = now;
+    }
+
+    // A spinning caller with a frozen clock would never see room, so each
+    //   call takes a microsecond
+    int availableForWrite() override
+    {
+        if (mock_time_frozen)
+            mock_advance(1);
+
+        drain();
+        return tx_capacity - tx.size();
+    }
+
+    // Like the Teensy core, waits for room rather than dropping
+    size_t write(uint8_t c) override
+    {
+        drain();
+
+        if (tx.size() >= tx_capacity)
+        {
+            blocked++;
+            while (tx.size() >= tx_capacity)
+            {
+                mock_advance(10000000ULL / baud);
+                drain();
+            }
+        }
+
+        tx.push_back(c);
+        return 1;
+    }
+
+    using Print::write;
+
+    int available() override { return rx.size(); }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+
+    int read() override
+    {
+        if (rx.empty())
+            return -1;
+
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+
+    void feed(const char* str) { rx.insert(rx.end(), str, str + strlen(str)); }
+
+  private:
+    uint64_t _last_us = 0;
+};
+
+inline HardwareSerial Serial1;
+
+// Periodic timer. Nothing calls the function; tests run it themselves and
+//   check how the timer was set up.
+class IntervalTimer
+{
+  public:
+    void (*func)() = NULL;
+    uint32_t period_us = 0;
+    uint32_t begins = 0;        // Times the timer was started
+
+    bool begin(void (*f)(), uint32_t us)
+    {
+        func = f;
+        period_us = us;
+        begins++;
+        return true;
+    }
+
+    void update(uint32_t us) { period_us = us; }
+    void end() { func = NULL; }
+};
+
+#include "kinetis.h"
@@ -0,0 +1,87 @@
+/*
+ * File:    I2Cdev.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for I2Cdev, making the same Wire calls as its Arduino
+ *            Wire build. In particular reads longer than BUFFER_LENGTH are
+ *            split into one register write and read per 32 bytes.
+ */
+
+#pragma once
+
+#include <Wire.h>
+
+class I2Cdev
+{
+  public:
+    static int8_t readBytes(uint8_t dev, uint8_t reg, uint8_t len, uint8_t* data, uint16_t timeout = 0)
+    {
+        int8_t count = 0;
+
+        for (uint8_t k = 0; k < len; k += min(len, (uint8_t) BUFFER_LENGTH))
+        {
+            Wire.beginTransmission(dev);
+            Wire.write(reg);
+            Wire.endTransmission();
+            Wire.requestFrom(dev, (uint8_t) min(len - k, BUFFER_LENGTH));
+
+            for (; Wire.available(); count++)
+                data[count] = Wire.read();
+        }
+
+        return count;
+    }
+
+    static int8_t readByte(uint8_t dev, uint8_t reg, uint8_t* data, uint16_t timeout = 0)
+    {
+        return readBytes(dev, reg, 1, data, timeout);
+    }
+
+    static int8_t readBits(uint8_t dev, uint8_t reg, uint8_t start, uint8_t len, uint8_t* data)
+    {
+        uint8_t byte;
+        int8_t count = readByte(dev, reg, &byte);
+
+        if (count)
+            *data = (byte >> (start - len + 1)) & ((1 << len) - 1);
+        return count;
+    }
+
+    static bool writeBytes(uint8_t dev, uint8_t reg, uint8_t len, const uint8_t* data)
+    {
+        Wire.beginTransmission(dev);
+        Wire.write(reg);
+        for (uint8_t i = 0; i < len; i++)
+            Wire.write(data[i]);
+        return Wire.endTransmission() == 0;
+    }
+
+    static bool writeByte(uint8_t dev, uint8_t reg, uint8_t data)
+    {
+        return writeBytes(dev, reg, 1, &data);
+    }
+
+    static bool writeWord(uint8_t dev, uint8_t reg, uint16_t data)
+    {
+        uint8_t buf[2] = { (uint8_t) (data >> 8), (uint8_t) data };
+        return writeBytes(dev, reg, 2, buf);
+    }
+
+    // Read, modify, write, as the library does
+    static bool writeBits(uint8_t dev, uint8_t reg, uint8_t start, uint8_t len, uint8_t data)
+    {
+        uint8_t byte;
+
+        if (!readByte(dev, reg, &byte))
+            return false;
+
+        uint8_t mask = ((1 << len) - 1) << (start - len + 1);
+        byte = (byte & ~mask) | ((data << (start - len + 1)) & mask);
+        return writeByte(dev, reg, byte);
+    }
+
+    static bool writeBit(uint8_t dev, uint8_t reg, uint8_t bit, uint8_t data)
+    {
+        return writeBits(dev, reg, bit, 1, data ? 1 : 0);
+    }
+};
@@ -0,0 +1,106 @@
+/*
+ * File:    MPU6050.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for the MPU6050 library's calls that the firmware
+ *            uses, each making the same I2Cdev reads and writes as the real
+ *            one.
+ */
+
+#pragma once
+
+#include <I2Cdev.h>
+
+#include "mock_i2c.h"
+
+class MPU6050
+{
+  public:
+    void initialize()
+    {
+        I2Cdev::writeBits(_addr, MPU6050_RA_PWR_MGMT_1, 2, 3, 1);   // Clock from the X gyro
+        setFullScaleGyroRange(0);
+        setFullScaleAccelRange(0);
+        I2Cdev::writeBit(_addr, MPU6050_RA_PWR_MGMT_1, 6, false);  // Wake
+    }
+
+    void reset() { I2Cdev::writeBit(_addr, MPU6050_RA_PWR_MGMT_1, 7, true); }
+
+    bool testConnection()
+    {
+        uint8_t id = 0;
+        I2Cdev::readBits(_addr, MPU6050_RA_WHO_AM_I, 6, 6, &id);
+        return id == 0x34;
+    }
+
+    void setXAccelOffset(int16_t offset) { I2Cdev::writeWord(_addr, MPU6050_RA_XA_OFFS_H, offset); }
+    void setYAccelOffset(int16_t offset) { I2Cdev::writeWord(_addr, MPU6050_RA_YA_OFFS_H, offset); }
+    void setZAccelOffset(int16_t offset) { I2Cdev::writeWord(_addr, MPU6050_RA_ZA_OFFS_H, offset); }
+    void setXGyroOffset(int16_t offset) { I2Cdev::writeWord(_addr, MPU6050_RA_XG_OFFS_USRH, offset); }
+    void setYGyroOffset(int16_t offset) { I2Cdev::writeWord(_addr, MPU6050_RA_YG_OFFS_USRH, offset); }
+    void setZGyroOffset(int16_t offset) { I2Cdev::writeWord(_addr, MPU6050_RA_ZG_OFFS_USRH, offset); }
+
+    void setFullScaleGyroRange(uint8_t range) { I2Cdev::writeBits(_addr, MPU6050_RA_GYRO_CONFIG, 4, 2, range); }
+    void setFullScaleAccelRange(uint8_t range) { I2Cdev::writeBits(_addr, MPU6050_RA_ACCEL_CONFIG, 4, 2, range); }
+    void setDLPFMode(uint8_t mode) { I2Cdev::writeBits(_addr, MPU6050_RA_CONFIG, 2, 3, mode); }
+    uint8_t getFullScaleGyroRange() { return _readBits(MPU6050_RA_GYRO_CONFIG, 4, 2); }
+    uint8_t getFullScaleAccelRange() { return _readBits(MPU6050_RA_ACCEL_CONFIG, 4, 2); }
+    uint8_t getDLPFMode() { return _readBits(MPU6050_RA_CONFIG, 2, 3); }
+
+    void getMotion6(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int16_t* gy, int16_t* gz)
+    {
+        uint8_t buf[14];
+
+        I2Cdev::readBytes(_addr, MPU6050_RA_ACCEL_XOUT_H, 14, buf);
+        *ax = (buf[0] << 8) | buf[1];
+        *ay = (buf[2] << 8) | buf[3];
+        *az = (buf[4] << 8) | buf[5];
+        *gx = (buf[8] << 8) | buf[9];
+        *gy = (buf[10] << 8) | buf[11];
+        *gz = (buf[12] << 8) | buf[13];
+    }
+
+    int16_t getTemperature()
+    {
+        uint8_t buf[2];
+
+        I2Cdev::readBytes(_addr, MPU6050_RA_TEMP_OUT_H, 2, buf);
+        return (buf[0] << 8) | buf[1];
+    }
+
+    void setRate(uint8_t rate) { I2Cdev::writeByte(_addr, MPU6050_RA_SMPLRT_DIV, rate); }
+
+    void setFIFOEnabled(bool enabled) { I2Cdev::writeBit(_addr, MPU6050_RA_USER_CTRL, 6, enabled); }
+    void resetFIFO() { I2Cdev::writeBit(_addr, MPU6050_RA_USER_CTRL, 2, true); }
+    void setTempFIFOEnabled(bool enabled) { I2Cdev::writeBit(_addr, MPU6050_RA_FIFO_EN, 7, enabled); }
+    void setXGyroFIFOEnabled(bool enabled) { I2Cdev::writeBit(_addr, MPU6050_RA_FIFO_EN, 6, enabled); }
+    void setYGyroFIFOEnabled(bool enabled) { I2Cdev::writeBit(_addr, MPU6050_RA_FIFO_EN, 5, enabled); }
+    void setZGyroFIFOEnabled(bool enabled) { I2Cdev::writeBit(_addr, MPU6050_RA_FIFO_EN, 4, enabled); }
+    void setAccelFIFOEnabled(bool enabled) { I2Cdev::writeBit(_addr, MPU6050_RA_FIFO_EN, 3, enabled); }
+
+    uint16_t getFIFOCount()
+    {
+        uint8_t buf[2];
+
+        I2Cdev::readBytes(_addr, MPU6050_RA_FIFO_COUNTH, 2, buf);
+        return (buf[0] << 8) | buf[1];
+    }
+
+    void getFIFOBytes(uint8_t* data, uint8_t len)
+    {
+        if (len)
+            I2Cdev::readBytes(_addr, MPU6050_RA_FIFO_R_W, len, data);
+        else
+            *data = 0;
+    }
+
+  private:
+    uint8_t _addr = MPU6050_DEFAULT_ADDRESS;
+
+    uint8_t _readBits(uint8_t reg, uint8_t start, uint8_t len)
+    {
+        uint8_t val = 0;
+        I2Cdev::readBits(_addr, reg, start, len, &val);
+        return val;
+    }
+};
@@ -0,0 +1,298 @@
+/*
+ * File:    SdFat.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for SdFat. Files live in memory on a fake card that
+ *            counts writes the way a block device sees them: every write
+ *            that does not start and end on a sector boundary costs a
+ *            read-modify-write of the sectors it touches.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define O_RDONLY 0x00
+#define O_WRONLY 0x01
+#define O_RDWR   0x02
+#define O_CREAT  0x40
+#define O_EXCL   0x80
+#define O_TRUNC  0x200
+#define O_APPEND 0x400
+
+#define FIFO_SDIO 0
+#define LS_DATE 1
+#define LS_SIZE 2
+#define SD_CARD_ERROR_CMD0 1
+
+#define MOCK_SECTOR_SIZE 512
+
+// Block device statistics for one file, reset with mock_sd_reset()
+typedef struct mock_sd_stats_t
+{
+    uint32_t writes;        // Calls to FsFile::write
+    uint64_t bytes;         // Bytes written
+    uint32_t partial;       // Writes not starting and ending on a sector
+    uint32_t rmw_sectors;   // Sectors read back to complete partial writes
+    uint32_t flushes;       // Calls to FsFile::flush
+    uint32_t opens;         // Times the file was opened
+} mock_sd_stats_t;
+
+inline std::map<std::string, std::vector<uint8_t>> mock_sd_files;
+inline std::map<std::string, mock_sd_stats_t> mock_sd_stats;
+inline uint32_t mock_sd_begins = 0;     // Card initialisations
+inline uint32_t mock_sd_misses = 0;     // Lookups and opens of missing files
+inline bool mock_sd_present = true;
+
+/*
+ * Name:    mock_sd_reset
+ * Desc:    Remove every file and clear the statistics.
+ */
+inline void mock_sd_reset()
+{
+    mock_sd_files.clear();
+    mock_sd_stats.clear();
+    mock_sd_begins = 0;
+    mock_sd_misses = 0;
+    mock_sd_present = true;
+}
+
+struct SdioConfig
+{
+    SdioConfig(int) {}
+};
+
+struct SdCard
+{
+    uint8_t errorCode() { return mock_sd_present ? 0 : SD_CARD_ERROR_CMD0; }
+    uint32_t errorData() { return 0; }
+    uint32_t sectorCount() { return 0; }
+};
+
+class FsFile : public Stream
+{
+  public:
+    bool open(const char* path, int flags = O_RDONLY)
+    {
+        close();
+
+        if (!mock_sd_present)
+            return false;
+
+        if (!strcmp(path, "/"))
+        {
+            _dir = true;
+            _next = 0;
+            _open = true;
+            return true;
+        }
+
+        bool exists = mock_sd_files.count(path);
+        if (!exists && !(flags & O_CREAT))
+        {
+            mock_sd_misses++;
+            return false;
+        }
+
+        if (exists && (flags & O_CREAT) && (flags & O_EXCL))
+            return false;
+
+        std::vector<uint8_t>& data = mock_sd_files[path];
+        if (flags & O_TRUNC)
+            data.clear();
+
+        _name = path;
+        _append = flags & O_APPEND;
+        _writable = flags & (O_WRONLY | O_RDWR);
+        _pos = 0;
+        _open = true;
+        mock_sd_stats[_name].opens++;
+
+        return true;
+    }
+
+    bool close()
+    {
+        _open = false;
+        _dir = false;
+        return true;
+    }
+
+    bool isOpen() { return _open; }
+    bool isDir() { return _open && _dir; }
+    operator bool() { return _open; }
+
+    uint64_t fileSize() { return _open && !_dir ? _data().size() : 0; }
+    uint64_t curPosition() { return _pos; }
+
+    bool seekSet(uint64_t pos)
+    {
+        if (!_open || pos > fileSize())
+            return false;
+
+        _pos = pos;
+        return true;
+    }
+
+    bool seekCur(int64_t offset) { return seekSet(_pos + offset); }
+
+    bool truncate(uint64_t len)
+    {
+        if (!_open || !_writable)
+            return false;
+
+        _data().resize(len);
+        _pos = min(_pos, len);
+        return true;
+    }
+
+    size_t write(const void* buf, size_t len)
+    {
+        if (!_open || !_writable)
+            return 0;
+
+        std::vector<uint8_t>& data = _data();
+        if (_append)
+            _pos = data.size();
+
+        uint64_t start = _pos, end = _pos + len;
+        mock_sd_stats_t* stats = &mock_sd_stats[_name];
+        stats->writes++;
+        stats->bytes += len;
+
+        // A sector only partly covered has to be read, merged and rewritten
+        bool head = start % MOCK_SECTOR_SIZE;
+        bool tail = end % MOCK_SECTOR_SIZE;
+        if (head || tail)
+        {
+            bool same = start / MOCK_SECTOR_SIZE == end / MOCK_SECTOR_SIZE;
+
+            stats->partial++;
+            stats->rmw_sectors += head + (tail && !(head && same));
+        }
+
+        if (end > data.size())
+            data.resize(end);
+
+        memcpy(data.data() + start, buf, len);
+        _pos = end;
+
+        return len;
+    }
+
+    size_t write(const char* str) { return write((const void*) str, strlen(str)); }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    int read(void* buf, size_t len)
+    {
+        if (!_open || _dir)
+            return -1;
+
+        std::vector<uint8_t>& data = _data();
+        size_t n = _pos < data.size() ? min(len, (size_t) (data.size() - _pos)) : 0;
+
+        memcpy(buf, data.data() + _pos, n);
+        _pos += n;
+
+        return (int) n;
+    }
+
+    int read() override
+    {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    int available() override
+    {
+        return _open && !_dir ? (int) (_data().size() - _pos) : 0;
+    }
+
+    bool flush()
+    {
+        if (_open)
+            mock_sd_stats[_name].flushes++;
+        return _open;
+    }
+
+    bool rewindDirectory()
+    {
+        _next = 0;
+        return _dir;
+    }
+
+    FsFile openNextFile(int flags = O_RDONLY)
+    {
+        FsFile file;
+
+        if (!_dir)
+            return file;
+
+        auto it = mock_sd_files.begin();
+        std::advance(it, min(_next, (size_t) mock_sd_files.size()));
+        if (it != mock_sd_files.end())
+        {
+            _next++;
+            file.open(it->first.c_str(), flags);
+        }
+
+        return file;
+    }
+
+    size_t getName(char* buf, size_t len)
+    {
+        snprintf(buf, len, "%s", _name.c_str());
+        return strlen(buf);
+    }
+
+  private:
+    std::vector<uint8_t>& _data() { return mock_sd_files[_name]; }
+
+    std::string _name;
+    bool _open = false;
+    bool _dir = false;
+    bool _append = false;
+    bool _writable = false;
+    uint64_t _pos = 0;
+    size_t _next = 0;
+};
+
+class SdFs
+{
+  public:
+    bool begin(SdioConfig)
+    {
+        mock_sd_begins++;
+        return mock_sd_present;
+    }
+
+    void end() {}
+    SdCard* card() { return &_card; }
+    void ls(int) {}
+
+    bool exists(const char* path)
+    {
+        bool found = mock_sd_present && mock_sd_files.count(path);
+
+        mock_sd_misses += !found;
+        return found;
+    }
+    bool remove(const char* path) { return mock_sd_files.erase(path); }
+
+  private:
+    SdCard _card;
+};
+
+struct ExFatFormatter
+{
+    bool format(SdCard*, uint8_t*, Print*)
+    {
+        mock_sd_files.clear();
+        return true;
+    }
+};
+
+struct FsDateTime
+{
+    static void setCallback(void (*)(uint16_t*, uint16_t*)) {}
+};
@@ -0,0 +1,28 @@
+/*
+ * File:    TimeLib.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for the calendar functions of the Time library.
+ */
+
+#pragma once
+
+#include <time.h>
+
+#define SECS_PER_MIN  60UL
+#define SECS_PER_HOUR 3600UL
+#define SECS_PER_DAY  86400UL
+
+inline struct tm _mock_tm(time_t t)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return tm;
+}
+
+inline int year(time_t t)   { return _mock_tm(t).tm_year + 1900; }
+inline int month(time_t t)  { return _mock_tm(t).tm_mon + 1; }
+inline int day(time_t t)    { return _mock_tm(t).tm_mday; }
+inline int hour(time_t t)   { return _mock_tm(t).tm_hour; }
+inline int minute(time_t t) { return _mock_tm(t).tm_min; }
+inline int second(time_t t) { return _mock_tm(t).tm_sec; }
@@ -0,0 +1,106 @@
+/*
+ * File:    Wire.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for the Teensy Wire library, on the simulated bus in
+ *            mock_i2c.h. Like the real one it waits for the bus, so each
+ *            call moves the mock clock on by the time the bus took.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "mock_i2c.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire
+{
+  public:
+    void begin() {}
+    void setClock(uint32_t freq) { mock_i2c.clock = freq; }
+
+    void beginTransmission(uint8_t addr)
+    {
+        _addr = addr;
+        _tx_len = 0;
+    }
+
+    size_t write(uint8_t byte)
+    {
+        if (_tx_len >= BUFFER_LENGTH)
+            return 0;
+
+        _tx[_tx_len++] = byte;
+        return 1;
+    }
+
+    // 0 on success, 2 if the address was NACKed, 3 if data was
+    uint8_t endTransmission(bool stop = true)
+    {
+        uint32_t ns;
+        uint8_t status = 0;
+
+        if (!mock_i2c_start(_addr, false, &ns))
+            status = 2;
+        _wait(ns);
+
+        for (uint8_t i = 0; !status && i < _tx_len; i++)
+        {
+            if (!mock_i2c_write(_tx[i], &ns))
+                status = 3;
+            _wait(ns);
+        }
+
+        if (stop || status)
+        {
+            mock_i2c_stop(&ns);
+            _wait(ns);
+        }
+
+        return status;
+    }
+
+    uint8_t requestFrom(uint8_t addr, uint8_t len, bool stop = true)
+    {
+        uint32_t ns;
+
+        _rx_len = _rx_pos = 0;
+
+        bool ack = mock_i2c_start(addr, true, &ns);
+        _wait(ns);
+
+        for (uint8_t i = 0; ack && i < min(len, (uint8_t) BUFFER_LENGTH); i++)
+        {
+            _rx[_rx_len++] = mock_i2c_read(&ns);
+            _wait(ns);
+        }
+
+        mock_i2c_stop(&ns);
+        _wait(ns);
+
+        return _rx_len;
+    }
+
+    int available() { return _rx_len - _rx_pos; }
+    int read() { return (_rx_pos < _rx_len) ? _rx[_rx_pos++] : -1; }
+
+  private:
+    uint8_t _addr = 0;
+    uint8_t _tx[BUFFER_LENGTH];
+    uint8_t _tx_len = 0;
+    uint8_t _rx[BUFFER_LENGTH];
+    uint8_t _rx_len = 0;
+    uint8_t _rx_pos = 0;
+    uint32_t _ns = 0;       // Bus time not yet added to the clock
+
+    void _wait(uint32_t ns)
+    {
+        _ns += ns;
+        mock_advance(_ns / 1000);
+        _ns %= 1000;
+    }
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,64 @@
+/*
+ * File:    fakes.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Stand-ins for the clock, logger, MPU and ADC functions the storage
+ *            module calls, for tests that build storage.cpp on a host.
+ *            Include from exactly one file per test.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <TimeLib.h>
+
+#include "clock.h"
+#include "logger.h"
+#include "mpu.h"
+
+// Local epoch returned by clock_getLocalNowSeconds
+uint32_t fake_local_now = 1767225600;   // 2026-01-01 00:00:00
+
+// Offset of local time from UTC (hours), as configured with `timezone`
+int8_t fake_timezone = -7;
+
+uint16_t fake_channel_mask = 0x1FFF;
+bool fake_sampling = false;
+
+uint32_t clock_getLocalNowSeconds()
+{
+    return fake_local_now;
+}
+
+time_t clock_localHumanToUtc(uint8_t hr, uint8_t min, uint8_t sec, uint8_t day, uint8_t month, uint16_t yr)
+{
+    tm time = {};
+
+    time.tm_hour = hr;
+    time.tm_min = min;
+    time.tm_sec = sec;
+    time.tm_mday = day;
+    time.tm_mon = month - 1;
+    time.tm_year = yr - 1900;
+
+    return timegm(&time) - fake_timezone * (int32_t) SECS_PER_HOUR;
+}
+
+void clock_fsStampCallback(uint16_t* date, uint16_t* time)
+{
+    *date = 0;
+    *time = 0;
+}
+
+void logger_loadConfig() {}
+void logger_startSampling() { fake_sampling = true; }
+void logger_stopSampling() { fake_sampling = false; }
+bool logger_getState() { return fake_sampling; }
+uint16_t logger_channelMask() { return fake_channel_mask; }
+uint8_t logger_channelCount() { return __builtin_popcount(fake_channel_mask); }
+
+uint8_t mpu_getAccelRange() { return 2; }
+uint16_t mpu_getGyroRange() { return 250; }
+uint16_t mpu_fifoRate() { return 0; }
+
+uint8_t adc_resolution() { return 13; }
@@ -0,0 +1,242 @@
+/*
+ * File:    kinetis.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for the Kinetis registers used by the modules under
+ *            test. I2C0 is modelled as a master on the simulated bus in
+ *            mock_i2c.h: each byte written to or read from I2C0_D takes its
+ *            time on the mock clock, then raises the I2C0 interrupt. The
+ *            DWT cycle counter is a plain variable.
+ */
+
+#pragma once
+
+#include "mock_i2c.h"
+
+#define I2C_C1_IICEN    0x80
+#define I2C_C1_IICIE    0x40
+#define I2C_C1_MST      0x20
+#define I2C_C1_TX       0x10
+#define I2C_C1_TXAK     0x08
+#define I2C_C1_RSTA     0x04
+
+#define I2C_S_TCF       0x80
+#define I2C_S_BUSY      0x20
+#define I2C_S_ARBL      0x10
+#define I2C_S_IICIF     0x02
+#define I2C_S_RXAK      0x01
+
+// Cycle counter, which only moves when a test moves it
+inline volatile uint32_t ARM_DEMCR = 0;
+inline volatile uint32_t ARM_DWT_CTRL = 0;
+inline volatile uint32_t ARM_DWT_CYCCNT = 0;
+
+#define ARM_DEMCR_TRCENA        (1 << 24)
+#define ARM_DWT_CTRL_CYCCNTENA  (1 << 0)
+
+#define IRQ_I2C0        24
+#define NVIC_NUM_IRQS   86
+
+#define NVIC_ENABLE_IRQ(n)      (mock_nvic_enabled[n] = true)
+#define NVIC_DISABLE_IRQ(n)     (mock_nvic_enabled[n] = false)
+#define NVIC_SET_PRIORITY(n, p) ((void) (n), (void) (p))
+
+inline void (*mock_vectors[NVIC_NUM_IRQS])() = {};
+inline bool mock_nvic_enabled[NVIC_NUM_IRQS] = {};
+
+inline void attachInterruptVector(int irq, void (*fn)())
+{
+    mock_vectors[irq] = fn;
+}
+
+typedef enum
+{
+    MOCK_I2C0_C1,
+    MOCK_I2C0_S,
+    MOCK_I2C0_D,
+    MOCK_I2C0_F
+} mock_i2c0_reg_t;
+
+// I2C0 peripheral state
+typedef struct mock_i2c0_t
+{
+    uint8_t c1;
+    uint8_t s;
+    uint8_t f;
+    uint8_t rx;             // Last byte received
+    bool addr_next;         // Next byte written is an address
+    bool rx_pending;        // Byte being received when the interrupt runs
+    uint32_t irqs;          // Interrupts raised
+} mock_i2c0_t;
+
+inline mock_i2c0_t mock_i2c0;
+
+/*
+ * Name:    _mock_i2c0Done
+ * Desc:    The byte in flight has finished: flag it and interrupt
+ */
+inline void _mock_i2c0Done()
+{
+    if (mock_i2c0.rx_pending)
+    {
+        mock_i2c0.rx_pending = false;
+
+        uint32_t ns;
+        mock_i2c0.rx = mock_i2c_read(&ns);
+    }
+
+    mock_i2c0.s |= I2C_S_TCF | I2C_S_IICIF;
+    mock_i2c0.irqs++;
+
+    if ((mock_i2c0.c1 & I2C_C1_IICIE) && mock_nvic_enabled[IRQ_I2C0] && mock_vectors[IRQ_I2C0])
+        mock_vectors[IRQ_I2C0]();
+}
+
+/*
+ * Name:    _mock_i2c0Start
+ *  ns:     time until the byte finishes
+ */
+inline void _mock_i2c0Start(uint32_t ns)
+{
+    mock_i2c0.s &= ~I2C_S_TCF;
+    mock_irq = _mock_i2c0Done;
+    mock_irq_due = _mock_now_us() + (ns + 999) / 1000;
+}
+
+inline uint8_t mock_i2c0_read(mock_i2c0_reg_t reg)
+{
+    switch (reg)
+    {
+      case MOCK_I2C0_C1:
+        return mock_i2c0.c1;
+
+      case MOCK_I2C0_S:
+        return mock_i2c0.s;
+
+      case MOCK_I2C0_F:
+        return mock_i2c0.f;
+
+      case MOCK_I2C0_D:
+        // Reading in receive mode clocks in the next byte, ACKed unless TXAK
+        if ((mock_i2c0.c1 & I2C_C1_MST) && !(mock_i2c0.c1 & I2C_C1_TX))
+        {
+            mock_i2c0.rx_pending = true;
+            _mock_i2c0Start(9 * 1000000000ULL / mock_i2c.clock);
+        }
+        return mock_i2c0.rx;
+    }
+
+    return 0;
+}
+
+inline void mock_i2c0_write(mock_i2c0_reg_t reg, uint8_t val)
+{
+    switch (reg)
+    {
+      case MOCK_I2C0_C1:
+      {
+        uint8_t was = mock_i2c0.c1;
+        mock_i2c0.c1 = val & ~I2C_C1_RSTA;
+
+        if (!(was & I2C_C1_MST) && (val & I2C_C1_MST))
+        {
+            mock_i2c0.s |= I2C_S_BUSY;
+            mock_i2c0.addr_next = true;
+        }
+        else if ((was & I2C_C1_MST) && !(val & I2C_C1_MST))
+        {
+            uint32_t ns;
+            mock_i2c_stop(&ns);
+            mock_i2c0.s &= ~I2C_S_BUSY;
+        }
+        else if (val & I2C_C1_RSTA)
+            mock_i2c0.addr_next = true;
+        break;
+      }
+
+      case MOCK_I2C0_S:
+        // Flags are cleared by writing ones
+        mock_i2c0.s &= ~(val & (I2C_S_IICIF | I2C_S_ARBL));
+        break;
+
+      case MOCK_I2C0_F:
+        mock_i2c0.f = val;
+        break;
+
+      case MOCK_I2C0_D:
+      {
+        if (!(mock_i2c0.c1 & I2C_C1_MST) || !(mock_i2c0.c1 & I2C_C1_TX))
+            break;
+
+        uint32_t ns;
+        bool ack;
+
+        if (mock_i2c0.addr_next)
+        {
+            mock_i2c0.addr_next = false;
+            ack = mock_i2c_start(val >> 1, val & 1, &ns);
+        }
+        else
+            ack = mock_i2c_write(val, &ns);
+
+        mock_i2c0.s = ack ? (mock_i2c0.s & ~I2C_S_RXAK) : (mock_i2c0.s | I2C_S_RXAK);
+        _mock_i2c0Start(ns);
+        break;
+      }
+    }
+}
+
+/*
+ * Name:    mock_i2c0_reset
+ * Desc:    Peripheral back to its reset state, nothing in flight
+ */
+inline void mock_i2c0_reset()
+{
+    mock_i2c0 = mock_i2c0_t();
+    mock_irq = NULL;
+    mock_irq_due = UINT64_MAX;
+}
+
+// Register access. Reading is done when the value is used, or when the
+//   access is thrown away as in `(void) I2C0_D`, so reads can have side
+//   effects like the hardware's.
+class mock_i2c0_access_t
+{
+  public:
+    explicit mock_i2c0_access_t(mock_i2c0_reg_t reg) : _reg(reg) {}
+
+    ~mock_i2c0_access_t()
+    {
+        if (!_used)
+            mock_i2c0_read(_reg);
+    }
+
+    operator uint8_t()
+    {
+        _used = true;
+        return mock_i2c0_read(_reg);
+    }
+
+    mock_i2c0_access_t& operator=(uint8_t val)
+    {
+        _used = true;
+        mock_i2c0_write(_reg, val);
+        return *this;
+    }
+
+    mock_i2c0_access_t& operator|=(uint8_t val)
+    {
+        _used = true;
+        mock_i2c0_write(_reg, mock_i2c0_read(_reg) | val);
+        return *this;
+    }
+
+  private:
+    mock_i2c0_reg_t _reg;
+    bool _used = false;
+};
+
+#define I2C0_C1 (mock_i2c0_access_t(MOCK_I2C0_C1))
+#define I2C0_S  (mock_i2c0_access_t(MOCK_I2C0_S))
+#define I2C0_D  (mock_i2c0_access_t(MOCK_I2C0_D))
+#define I2C0_F  (mock_i2c0_access_t(MOCK_I2C0_F))
@@ -0,0 +1,324 @@
+/*
+ * File:    mock_i2c.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for the I2C bus and the MPU 6050 on it. Wire and the
+ *            I2C0 registers both drive the bus through here, which counts the
+ *            transactions and bytes clocked and how long they took. The
+ *            sensor samples on the mock clock into its registers and FIFO.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define MPU6050_DEFAULT_ADDRESS     0x68
+
+#define MPU6050_RA_XA_OFFS_H        0x06
+#define MPU6050_RA_YA_OFFS_H        0x08
+#define MPU6050_RA_ZA_OFFS_H        0x0A
+#define MPU6050_RA_XG_OFFS_USRH     0x13
+#define MPU6050_RA_YG_OFFS_USRH     0x15
+#define MPU6050_RA_ZG_OFFS_USRH     0x17
+#define MPU6050_RA_SMPLRT_DIV       0x19
+#define MPU6050_RA_CONFIG           0x1A
+#define MPU6050_RA_GYRO_CONFIG      0x1B
+#define MPU6050_RA_ACCEL_CONFIG     0x1C
+#define MPU6050_RA_FIFO_EN          0x23
+#define MPU6050_RA_INT_STATUS       0x3A
+#define MPU6050_RA_ACCEL_XOUT_H     0x3B
+#define MPU6050_RA_TEMP_OUT_H       0x41
+#define MPU6050_RA_USER_CTRL        0x6A
+#define MPU6050_RA_PWR_MGMT_1       0x6B
+#define MPU6050_RA_FIFO_COUNTH      0x72
+#define MPU6050_RA_FIFO_COUNTL      0x73
+#define MPU6050_RA_FIFO_R_W         0x74
+#define MPU6050_RA_WHO_AM_I         0x75
+
+#define MOCK_MPU_FIFO_SIZE          1024
+
+// Bus activity since the last mock_i2c_reset
+typedef struct mock_i2c_stats_t
+{
+    uint32_t transactions;      // Starts, repeated starts included
+    uint32_t bytes;             // Bytes clocked, addresses included
+    uint64_t bus_ns;            // Time spent clocking them
+} mock_i2c_stats_t;
+
+typedef struct mock_i2c_t
+{
+    uint32_t clock = 100000;    // SCL (Hz), as Wire.setClock left it
+    mock_i2c_stats_t stats;
+    bool addressed = false;     // The sensor answered the last start
+    bool reg_set = false;       // Register number written since the start
+} mock_i2c_t;
+
+typedef struct mock_mpu_t
+{
+    bool present = true;        // ACKs its address
+    uint8_t regs[128];
+    uint8_t ptr;                // Register the next access is to
+    std::deque<uint8_t> fifo;
+    uint32_t overflows;         // Times the FIFO dropped its oldest byte
+    uint32_t samples;           // Samples taken since reset
+    uint64_t next_us;           // Mock time the next sample is due
+} mock_mpu_t;
+
+inline mock_i2c_t mock_i2c;
+inline mock_mpu_t mock_mpu;
+
+/*
+ * Name:    mock_mpu_sample
+ *  n:      sample number
+ *  accel:  accelerometer counts for that sample
+ *  gyro:   gyro counts
+ *  temp:   temperature counts
+ * Desc:    What the sensor reads on its nth sample, so tests can tell which
+ *            sample they were handed
+ */
+inline void mock_mpu_sample(uint32_t n, int16_t accel[3], int16_t gyro[3], int16_t* temp)
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        accel[i] = (int16_t) (n + i * 1000);
+        gyro[i] = (int16_t) (-(int32_t) n - i * 1000);
+    }
+    *temp = (int16_t) (n * 7);
+}
+
+/*
+ * Name:    mock_mpu_period
+ *  return: time between samples (us), as set by the divider and filter
+ */
+inline uint32_t mock_mpu_period()
+{
+    uint8_t dlpf = mock_mpu.regs[MPU6050_RA_CONFIG] & 0x07;
+    uint32_t base = (dlpf == 0 || dlpf == 7) ? 8000 : 1000;
+
+    return 1000000 * (1 + mock_mpu.regs[MPU6050_RA_SMPLRT_DIV]) / base;
+}
+
+/*
+ * Name:    _mock_mpuPut
+ *  byte:   byte to add to the FIFO, dropping the oldest if full
+ */
+inline void _mock_mpuPut(uint8_t byte)
+{
+    if (mock_mpu.fifo.size() >= MOCK_MPU_FIFO_SIZE)
+    {
+        mock_mpu.fifo.pop_front();
+        mock_mpu.overflows++;
+        mock_mpu.regs[MPU6050_RA_INT_STATUS] |= 0x10;
+    }
+
+    mock_mpu.fifo.push_back(byte);
+}
+
+/*
+ * Name:    mock_mpu_update
+ * Desc:    Take the samples due by now, into the data registers and the FIFO
+ */
+inline void mock_mpu_update()
+{
+    uint64_t now = _mock_now_us();
+
+    // Asleep after a reset until initialized
+    if (mock_mpu.regs[MPU6050_RA_PWR_MGMT_1] & 0x40)
+    {
+        mock_mpu.next_us = now + mock_mpu_period();
+        return;
+    }
+
+    while (mock_mpu.next_us <= now)
+    {
+        int16_t accel[3], gyro[3], temp;
+        uint8_t* out = &mock_mpu.regs[MPU6050_RA_ACCEL_XOUT_H];
+
+        mock_mpu_sample(mock_mpu.samples++, accel, gyro, &temp);
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            out[2 * i] = accel[i] >> 8;
+            out[2 * i + 1] = accel[i];
+            out[8 + 2 * i] = gyro[i] >> 8;
+            out[8 + 2 * i + 1] = gyro[i];
+        }
+        out[6] = temp >> 8;
+        out[7] = temp;
+
+        // Records are in register order, for whichever sensors are enabled
+        uint8_t en = mock_mpu.regs[MPU6050_RA_FIFO_EN];
+        if (mock_mpu.regs[MPU6050_RA_USER_CTRL] & 0x40)
+        {
+            for (uint8_t i = 0; i < 14; i++)
+            {
+                bool on = (i < 6) ? (en & 0x08) :
+                          (i < 8) ? (en & 0x80) :
+                          (en & (0x40 >> ((i - 8) / 2)));
+                if (on)
+                    _mock_mpuPut(out[i]);
+            }
+        }
+
+        mock_mpu.next_us += mock_mpu_period();
+    }
+}
+
+/*
+ * Name:    mock_mpu_reset
+ * Desc:    Power on reset: asleep, FIFO off and empty
+ */
+inline void mock_mpu_reset()
+{
+    memset(mock_mpu.regs, 0, sizeof(mock_mpu.regs));
+    mock_mpu.regs[MPU6050_RA_PWR_MGMT_1] = 0x40;
+    mock_mpu.fifo.clear();
+    mock_mpu.next_us = _mock_now_us() + mock_mpu_period();
+}
+
+/*
+ * Name:    mock_i2c_reset
+ * Desc:    Clear the bus counters and power cycle the sensor
+ */
+inline void mock_i2c_reset()
+{
+    mock_i2c = mock_i2c_t();
+    mock_mpu = mock_mpu_t();
+    mock_mpu_reset();
+}
+
+/*
+ * Name:    _mock_i2cClock
+ *  bits:   SCL periods taken
+ *  return: time taken (ns)
+ */
+inline uint32_t _mock_i2cClock(uint8_t bits)
+{
+    uint32_t ns = bits * 1000000000ULL / mock_i2c.clock;
+
+    mock_i2c.stats.bus_ns += ns;
+    return ns;
+}
+
+/*
+ * Name:    mock_i2c_start
+ *  addr:   7-bit address
+ *  read:   direction bit
+ *  ns:     time the start and address took
+ *  return: true if the address was ACKed
+ * Desc:    Start, or repeated start, and send the address
+ */
+inline bool mock_i2c_start(uint8_t addr, bool read, uint32_t* ns)
+{
+    mock_i2c.stats.transactions++;
+    mock_i2c.stats.bytes++;
+    *ns = _mock_i2cClock(10);
+
+    mock_mpu_update();
+    mock_i2c.addressed = mock_mpu.present && addr == MPU6050_DEFAULT_ADDRESS;
+    mock_i2c.reg_set = read;
+
+    return mock_i2c.addressed;
+}
+
+/*
+ * Name:    mock_i2c_write
+ *  byte:   byte to send
+ *  ns:     time it took
+ *  return: true if ACKed
+ * Desc:    The first byte after the address selects a register, the rest are
+ *            written from there up
+ */
+inline bool mock_i2c_write(uint8_t byte, uint32_t* ns)
+{
+    mock_i2c.stats.bytes++;
+    *ns = _mock_i2cClock(9);
+
+    if (!mock_i2c.addressed)
+        return false;
+
+    if (!mock_i2c.reg_set)
+    {
+        mock_mpu.ptr = byte & 0x7F;
+        mock_i2c.reg_set = true;
+        return true;
+    }
+
+    uint8_t reg = mock_mpu.ptr;
+    mock_mpu.regs[reg] = byte;
+
+    if (reg == MPU6050_RA_PWR_MGMT_1 && (byte & 0x80))
+        mock_mpu_reset();
+
+    if (reg == MPU6050_RA_USER_CTRL && (byte & 0x04))
+    {
+        mock_mpu.fifo.clear();
+        mock_mpu.regs[reg] &= ~0x04;
+    }
+
+    if (reg == MPU6050_RA_SMPLRT_DIV || reg == MPU6050_RA_CONFIG)
+        mock_mpu.next_us = _mock_now_us() + mock_mpu_period();
+
+    if (reg != MPU6050_RA_FIFO_R_W)
+        mock_mpu.ptr = (reg + 1) & 0x7F;
+
+    return true;
+}
+
+/*
+ * Name:    mock_i2c_read
+ *  ns:     time it took
+ *  return: byte the sensor sent, 0xFF (the idle bus) if it isn't listening
+ */
+inline uint8_t mock_i2c_read(uint32_t* ns)
+{
+    mock_i2c.stats.bytes++;
+    *ns = _mock_i2cClock(9);
+
+    if (!mock_i2c.addressed)
+        return 0xFF;
+
+    uint8_t reg = mock_mpu.ptr;
+    uint8_t byte = mock_mpu.regs[reg];
+
+    switch (reg)
+    {
+      case MPU6050_RA_FIFO_COUNTH:
+        byte = mock_mpu.fifo.size() >> 8;
+        break;
+
+      case MPU6050_RA_FIFO_COUNTL:
+        byte = mock_mpu.fifo.size() & 0xFF;
+        break;
+
+      case MPU6050_RA_FIFO_R_W:
+        byte = 0;
+        if (!mock_mpu.fifo.empty())
+        {
+            byte = mock_mpu.fifo.front();
+            mock_mpu.fifo.pop_front();
+        }
+        break;
+
+      case MPU6050_RA_WHO_AM_I:
+        byte = MPU6050_DEFAULT_ADDRESS;
+        break;
+
+      default:
+        break;
+    }
+
+    if (reg != MPU6050_RA_FIFO_R_W)
+        mock_mpu.ptr = (reg + 1) & 0x7F;
+
+    return byte;
+}
+
+/*
+ * Name:    mock_i2c_stop
+ *  ns:     time it took
+ */
+inline void mock_i2c_stop(uint32_t* ns)
+{
+    *ns = _mock_i2cClock(1);
+    mock_i2c.addressed = false;
+}
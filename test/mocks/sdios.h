@@ -0,0 +1,8 @@
+/*
+ * File:    sdios.h
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host stand-in for SdFat's stream header, unused by the tests.
+ */
+
+#pragma once
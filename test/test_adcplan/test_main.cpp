@@ -0,0 +1,192 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for pairing ADC channels between the two ADCs: every
+ *            channel is converted once, by an ADC that can reach it, in as
+ *            few conversions as the reachable pins allow.
+ */
+
+#include <unity.h>
+
+#include <stdlib.h>
+
+#include "../../src/adcplan.cpp"
+
+#define BOTH    (ADCPLAN_ON_ADC0 | ADCPLAN_ON_ADC1)
+
+static uint16_t _index[ADCPLAN_MAX_CHANNELS + 4];
+static uint8_t _pin[ADCPLAN_MAX_CHANNELS + 4];
+static uint8_t _reach[ADCPLAN_MAX_CHANNELS + 4];
+
+void setUp()
+{
+    // Distinct indices and pins so every slot can be told apart
+    for (uint8_t i = 0; i < ADCPLAN_MAX_CHANNELS + 4; i++)
+    {
+        _index[i] = 15 - (i % 16);
+        _pin[i] = 100 + i;
+        _reach[i] = BOTH;
+    }
+}
+
+void tearDown() {}
+
+/*
+ * Name:    _check
+ *  plan:   plan built from _index, _pin and _reach
+ *  count:  channels it was built for
+ * Desc:    Check every channel is converted exactly once, by an ADC that can
+ *            reach it, and in the fewest conversions possible
+ */
+static void _check(const adc_plan_t* plan, uint8_t count)
+{
+    uint8_t seen[ADCPLAN_MAX_CHANNELS] = { 0 };
+    uint8_t n0 = 0, n1 = 0;
+
+    TEST_ASSERT_EQUAL_UINT8(count, plan->count);
+    TEST_ASSERT_TRUE(plan->pairs <= count);
+
+    for (uint8_t i = 0; i < plan->pairs; i++)
+    {
+        const adc_pair_t* pair = &plan->pair[i];
+
+        TEST_ASSERT_FALSE(pair->pin[0] == ADCPLAN_NO_PIN && pair->pin[1] == ADCPLAN_NO_PIN);
+
+        for (uint8_t a = 0; a < 2; a++)
+        {
+            if (pair->pin[a] == ADCPLAN_NO_PIN)
+                continue;
+
+            uint8_t slot = pair->slot[a];
+            TEST_ASSERT_TRUE(slot < count);
+            TEST_ASSERT_EQUAL_UINT8(_pin[slot], pair->pin[a]);
+            seen[slot]++;
+
+            // Pins neither ADC reaches are left to ADC0
+            uint8_t want = a ? ADCPLAN_ON_ADC1 : ADCPLAN_ON_ADC0;
+            TEST_ASSERT_TRUE((_reach[slot] & want) || (!a && !_reach[slot]));
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(1, seen[i]);
+        TEST_ASSERT_EQUAL_UINT8(_index[i], plan->index[i]);
+
+        if (_reach[i] == ADCPLAN_ON_ADC1)
+            n1++;
+        else if (_reach[i] != BOTH)
+            n0++;
+    }
+
+    // Each ADC converts once per pair, so the busier ADC sets the count
+    uint8_t fewest = (count + 1) / 2;
+    fewest = n0 > fewest ? n0 : fewest;
+    fewest = n1 > fewest ? n1 : fewest;
+    TEST_ASSERT_EQUAL_UINT8(fewest, plan->pairs);
+}
+
+void test_either_adc_halves_conversions()
+{
+    adc_plan_t plan;
+
+    for (uint8_t count = 1; count <= ADCPLAN_MAX_CHANNELS; count++)
+    {
+        adcplan_build(&plan, _index, _pin, _reach, count);
+        _check(&plan, count);
+    }
+
+    // Output order is kept in the slots, not the pairing
+    adcplan_build(&plan, _index, _pin, _reach, 4);
+    TEST_ASSERT_EQUAL_UINT8(2, plan.pairs);
+    TEST_ASSERT_EQUAL_UINT8(0, plan.pair[0].slot[0]);
+    TEST_ASSERT_EQUAL_UINT8(1, plan.pair[0].slot[1]);
+    TEST_ASSERT_EQUAL_UINT8(2, plan.pair[1].slot[0]);
+    TEST_ASSERT_EQUAL_UINT8(3, plan.pair[1].slot[1]);
+}
+
+void test_single_adc_channels_pair_first()
+{
+    adc_plan_t plan;
+
+    // Channel 0 only on ADC1 and 3 only on ADC0 go together, so the two
+    //   either channels can share the second conversion
+    _reach[0] = ADCPLAN_ON_ADC1;
+    _reach[3] = ADCPLAN_ON_ADC0;
+
+    adcplan_build(&plan, _index, _pin, _reach, 4);
+    _check(&plan, 4);
+
+    TEST_ASSERT_EQUAL_UINT8(3, plan.pair[0].slot[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, plan.pair[0].slot[1]);
+}
+
+void test_one_adc_only()
+{
+    adc_plan_t plan;
+
+    // Nothing for ADC1 to do, and no more pairs than channels
+    for (uint8_t i = 0; i < ADCPLAN_MAX_CHANNELS; i++)
+        _reach[i] = ADCPLAN_ON_ADC0;
+
+    adcplan_build(&plan, _index, _pin, _reach, ADCPLAN_MAX_CHANNELS);
+    _check(&plan, ADCPLAN_MAX_CHANNELS);
+
+    for (uint8_t i = 0; i < plan.pairs; i++)
+        TEST_ASSERT_EQUAL_HEX8(ADCPLAN_NO_PIN, plan.pair[i].pin[1]);
+
+    // Unreachable pins go to ADC0 as well
+    _reach[5] = 0;
+    adcplan_build(&plan, _index, _pin, _reach, ADCPLAN_MAX_CHANNELS);
+    _check(&plan, ADCPLAN_MAX_CHANNELS);
+}
+
+void test_too_many_channels()
+{
+    adc_plan_t plan;
+
+    adcplan_build(&plan, _index, _pin, _reach, ADCPLAN_MAX_CHANNELS + 4);
+    _check(&plan, ADCPLAN_MAX_CHANNELS);
+}
+
+void test_random_reach()
+{
+    adc_plan_t plan;
+    const uint8_t reaches[] = { ADCPLAN_ON_ADC0, ADCPLAN_ON_ADC1, BOTH, BOTH };
+
+    srand(1);
+    for (uint16_t run = 0; run < 2000; run++)
+    {
+        uint8_t count = 1 + rand() % ADCPLAN_MAX_CHANNELS;
+
+        for (uint8_t i = 0; i < count; i++)
+            _reach[i] = reaches[rand() % 4];
+
+        adcplan_build(&plan, _index, _pin, _reach, count);
+        _check(&plan, count);
+    }
+}
+
+void test_matches()
+{
+    adc_plan_t plan;
+
+    adcplan_build(&plan, _index, _pin, _reach, 6);
+
+    TEST_ASSERT_TRUE(adcplan_matches(&plan, _index, 6));
+    TEST_ASSERT_FALSE(adcplan_matches(&plan, _index, 5));
+    TEST_ASSERT_FALSE(adcplan_matches(&plan, _index + 1, 6));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_either_adc_halves_conversions);
+    RUN_TEST(test_single_adc_channels_pair_first);
+    RUN_TEST(test_one_adc_only);
+    RUN_TEST(test_too_many_channels);
+    RUN_TEST(test_random_reach);
+    RUN_TEST(test_matches);
+    return UNITY_END();
+}
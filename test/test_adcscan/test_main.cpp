@@ -0,0 +1,249 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the hardware triggered scan's block hand-off. A
+ *            simulated DMA fills both ADCs' buffers a result at a time and
+ *            interrupts at each half, as the DMA channels do, while the
+ *            reader takes blocks early, late and part way through a refill.
+ */
+
+#include <unity.h>
+
+#include "../../src/adcplan.cpp"
+#include "../../src/adcscan.cpp"
+
+#define BLOCK   16
+#define PAIRS   3
+
+// Two ADCs' DMA result buffers and where the DMA is in them
+typedef struct dma_t
+{
+    uint16_t buf[2][2 * BLOCK * PAIRS];
+    uint16_t pos;           // Next result written, the same on both ADCs
+    uint32_t scans;         // Scans written
+} dma_t;
+
+static dma_t _dma;
+static adcscan_handoff_t _handoff;
+static adc_plan_t _plan;
+
+/*
+ * Name:    _result
+ *  scan:   scan number since the start
+ *  slot:   channel position in the output
+ *  return: the reading the simulated ADC gives for it
+ */
+static uint16_t _result(uint32_t scan, uint8_t slot)
+{
+    return (uint16_t) (scan * 16 + slot);
+}
+
+/*
+ * Name:    _dmaRun
+ *  scans:  scans to convert
+ * Desc:    Move results in as the DMA does, interrupting at each half
+ */
+static void _dmaRun(uint32_t scans)
+{
+    for (uint32_t s = 0; s < scans; s++, _dma.scans++)
+    {
+        for (uint8_t i = 0; i < _plan.pairs; i++, _dma.pos++)
+        {
+            for (uint8_t a = 0; a < 2; a++)
+            {
+                // A spare conversion in the pair is of another pin
+                const adc_pair_t* pair = &_plan.pair[i];
+                _dma.buf[a][_dma.pos] = (pair->pin[a] == ADCPLAN_NO_PIN) ? 0xFFFF
+                                                                         : _result(_dma.scans, pair->slot[a]);
+            }
+        }
+
+        if (_dma.pos == BLOCK * _plan.pairs)
+            adcscan_complete(&_handoff, 1);
+        else if (_dma.pos == 2 * BLOCK * _plan.pairs)
+        {
+            _dma.pos = 0;
+            adcscan_complete(&_handoff, 0);
+        }
+    }
+}
+
+/*
+ * Name:    _copy
+ *  half:   half of the buffer holding the block
+ *  out:    set to the block's scans in channel order
+ */
+static void _copy(uint8_t half, uint32_t* out)
+{
+    for (uint16_t s = 0; s < BLOCK; s++)
+    {
+        uint16_t offset = adcscan_offset(BLOCK, _plan.pairs, half, s);
+        adcscan_unpack(&_plan, _dma.buf[0] + offset, _dma.buf[1] + offset, out + s * _plan.count);
+    }
+}
+
+/*
+ * Name:    _checkBlock
+ *  seq:    number of the block
+ *  out:    the block as copied out
+ */
+static void _checkBlock(uint32_t seq, const uint32_t* out)
+{
+    for (uint16_t s = 0; s < BLOCK; s++)
+    {
+        for (uint8_t c = 0; c < _plan.count; c++)
+            TEST_ASSERT_EQUAL_UINT32(_result(seq * BLOCK + s, c), out[s * _plan.count + c]);
+    }
+}
+
+/*
+ * Name:    _planFor
+ *  count:  channels
+ *  reach:  ADCs that can reach every channel
+ */
+static void _planFor(uint8_t count, uint8_t reach)
+{
+    uint16_t index[ADCPLAN_MAX_CHANNELS];
+    uint8_t pin[ADCPLAN_MAX_CHANNELS], reaches[ADCPLAN_MAX_CHANNELS];
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        index[i] = i;
+        pin[i] = 20 + i;
+        reaches[i] = reach;
+    }
+
+    adcplan_build(&_plan, index, pin, reaches, count);
+}
+
+void setUp()
+{
+    _dma = dma_t();
+    _handoff = adcscan_handoff_t();
+
+    // Five channels on two ADCs, so one pair has a spare conversion
+    _planFor(5, ADCPLAN_ON_ADC0 | ADCPLAN_ON_ADC1);
+    TEST_ASSERT_EQUAL_UINT8(PAIRS, _plan.pairs);
+}
+
+void tearDown() {}
+
+void test_nothing_until_a_block_completes()
+{
+    uint32_t seq = 0;
+
+    TEST_ASSERT_EQUAL_INT8(-1, adcscan_take(&_handoff, &seq));
+
+    _dmaRun(BLOCK - 1);
+    TEST_ASSERT_EQUAL_INT8(-1, adcscan_take(&_handoff, &seq));
+
+    _dmaRun(1);
+    TEST_ASSERT_EQUAL_INT8(0, adcscan_take(&_handoff, &seq));
+    TEST_ASSERT_EQUAL_UINT32(0, seq);
+
+    // Taken once only
+    TEST_ASSERT_EQUAL_INT8(-1, adcscan_take(&_handoff, &seq));
+}
+
+void test_every_block_read_in_time()
+{
+    uint32_t out[BLOCK * ADCPLAN_MAX_CHANNELS];
+
+    for (uint32_t n = 0; n < 100; n++)
+    {
+        uint32_t seq = 0;
+
+        _dmaRun(BLOCK);
+
+        int8_t half = adcscan_take(&_handoff, &seq);
+        TEST_ASSERT_EQUAL_INT8(n % 2, half);
+        TEST_ASSERT_EQUAL_UINT32(n, seq);
+
+        _copy(half, out);
+        TEST_ASSERT_TRUE(adcscan_release(&_handoff, seq));
+        _checkBlock(seq, out);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, _handoff.overruns);
+}
+
+void test_late_reader_gets_the_newest()
+{
+    uint32_t out[BLOCK * ADCPLAN_MAX_CHANNELS];
+    uint32_t seq = 0;
+
+    // Three blocks done and the DMA half way through the fourth: only the
+    //   third is left whole
+    _dmaRun(3 * BLOCK + BLOCK / 2);
+
+    int8_t half = adcscan_take(&_handoff, &seq);
+    TEST_ASSERT_EQUAL_INT8(0, half);
+    TEST_ASSERT_EQUAL_UINT32(2, seq);
+    TEST_ASSERT_EQUAL_UINT32(2, _handoff.overruns);
+
+    _copy(half, out);
+    TEST_ASSERT_TRUE(adcscan_release(&_handoff, seq));
+    _checkBlock(seq, out);
+}
+
+void test_refill_during_copy()
+{
+    uint32_t out[BLOCK * ADCPLAN_MAX_CHANNELS];
+    uint32_t seq = 0;
+
+    _dmaRun(BLOCK);
+    int8_t half = adcscan_take(&_handoff, &seq);
+
+    // The next block completes and the DMA starts writing over this one
+    //   while it is being copied
+    _dmaRun(BLOCK + 1);
+    _copy(half, out);
+    TEST_ASSERT_FALSE(adcscan_release(&_handoff, seq));
+    TEST_ASSERT_EQUAL_UINT32(1, _handoff.overruns);
+
+    // The block that interrupted the copy is still whole
+    half = adcscan_take(&_handoff, &seq);
+    TEST_ASSERT_EQUAL_UINT32(1, seq);
+    _copy(half, out);
+    TEST_ASSERT_TRUE(adcscan_release(&_handoff, seq));
+    _checkBlock(seq, out);
+    TEST_ASSERT_EQUAL_UINT32(1, _handoff.overruns);
+}
+
+void test_one_adc()
+{
+    uint32_t out[BLOCK * ADCPLAN_MAX_CHANNELS];
+    uint32_t seq = 0;
+
+    // Pins only ADC1 reaches, so ADC0's results are all spare
+    _planFor(3, ADCPLAN_ON_ADC1);
+    TEST_ASSERT_EQUAL_UINT8(3, _plan.pairs);
+
+    _dmaRun(2 * BLOCK);
+    int8_t half = adcscan_take(&_handoff, &seq);
+    _copy(half, out);
+    TEST_ASSERT_TRUE(adcscan_release(&_handoff, seq));
+    _checkBlock(seq, out);
+}
+
+void test_rate_fits()
+{
+    // 8 conversions of 10 us take 80 us, so up to 12.5 kHz
+    TEST_ASSERT_TRUE(adcscan_rateFits(8, 12500, 10));
+    TEST_ASSERT_FALSE(adcscan_rateFits(8, 12600, 10));
+    TEST_ASSERT_TRUE(adcscan_rateFits(1, 50000, 20));
+    TEST_ASSERT_FALSE(adcscan_rateFits(16, 65535, 1));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_until_a_block_completes);
+    RUN_TEST(test_every_block_read_in_time);
+    RUN_TEST(test_late_reader_gets_the_newest);
+    RUN_TEST(test_refill_during_copy);
+    RUN_TEST(test_one_adc);
+    RUN_TEST(test_rate_fits);
+    return UNITY_END();
+}
@@ -0,0 +1,232 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host simulation of the live feed's rate controller. Samples are
+ *            handed to bt_sendSample as logger_serviceBuffer does, on a
+ *            frozen clock, and the app decodes the live frames and acks on
+ *            its own schedule. Checks when the feed is and isn't decimated
+ *            and that a slow link never holds up the logger.
+ */
+
+#include <unity.h>
+
+#include <math.h>
+
+#include "fakes.h"
+#include "../../src/csv.cpp"
+#include "../../src/frame.cpp"
+#include "../../src/storage.cpp"
+#include "../../src/bt.cpp"
+
+#define CHANNELS     13
+#define LOOP_US      1000               // Time one pass of loop() takes
+
+// The app end of the link
+typedef struct app_t
+{
+    std::vector<uint8_t> frame;         // Bytes since the last delimiter
+    uint32_t frames;                    // Live frames received
+    uint32_t samples;                   // Samples in those frames
+    uint32_t bad;                       // Frames that failed to decode
+    uint32_t ack_ms;                    // Time between acks, 0 for none
+    uint64_t last_ack;
+} app_t;
+
+// Stand-ins for the modules bt.cpp calls that aren't under test
+void clock_set(uint32_t time) {}
+
+static app_t _app;
+static uint32_t _produced;
+static uint64_t _next_poll;
+
+void setUp()
+{
+    Serial.muted = true;
+    mock_time_frozen = true;
+    mock_sd_reset();
+    fake_channel_mask = (1 << CHANNELS) - 1;
+    storage_init();
+
+    Serial1 = HardwareSerial();
+    _tx_capacity = 0;
+    _tx_rejected = 0;
+    _live_rate = bt_live_rate_t();
+    _state = BT_IDLE;
+    bt_init();
+
+    _app = app_t();
+    _app.ack_ms = 1000;
+    _app.last_ack = _mock_now_us();
+    _produced = 0;
+    _next_poll = _mock_now_us();
+
+    Serial1.feed("lon\n");
+    bt_tick();
+}
+
+void tearDown()
+{
+    mock_time_frozen = false;
+}
+
+/*
+ * Name:    _appService
+ * Desc:    Decode what the UART sent and ack when due
+ */
+static void _appService()
+{
+    Serial1.drain();
+    for (uint8_t byte : Serial1.sent)
+    {
+        if (byte)
+        {
+            _app.frame.push_back(byte);
+            continue;
+        }
+
+        uint8_t payload[FRAME_MAX_PAYLOAD];
+        uint8_t type;
+        uint16_t seq, len;
+
+        if (frame_decode(_app.frame.data(), _app.frame.size(), &type, &seq, payload, &len) && type == FRAME_LIVE)
+        {
+            _app.frames++;
+            _app.samples += payload[0];
+        }
+        else
+            _app.bad++;
+
+        _app.frame.clear();
+    }
+    Serial1.sent.clear();
+
+    if (_app.ack_ms && _mock_now_us() - _app.last_ack >= _app.ack_ms * 1000ULL)
+    {
+        Serial1.feed("ack\n");
+        _app.last_ack = _mock_now_us();
+    }
+}
+
+/*
+ * Name:    _run
+ *  ms:     time to run for
+ *  poll_us: time between samples
+ */
+static void _run(uint32_t ms, uint32_t poll_us)
+{
+    uint64_t end = _mock_now_us() + ms * 1000ULL;
+
+    while (_mock_now_us() < end)
+    {
+        if (_mock_now_us() >= _next_poll)
+        {
+            log_entry_t entry = {};
+            double t = _produced * poll_us / 1e6;
+
+            entry.time = fake_local_now + (uint32_t) t;
+            entry.millis = (uint32_t) (t * 1000) % 1000;
+            for (uint8_t i = 0; i < 3; i++)
+                entry.mpu_accel[i] = (int16_t) (2000 * sin(t + i));
+            for (uint8_t i = 0; i < CHANNELS; i++)
+                entry.adc_data[i] = (uint16_t) (4096 + 1000 * sin(t * 3 + i));
+
+            bt_sendSample(&entry);
+            _produced++;
+            _next_poll += poll_us;
+        }
+
+        bt_tick();
+        _appService();
+        mock_advance(LOOP_US);
+    }
+}
+
+void test_slow_app_acks_are_not_congestion()
+{
+    // Acks further apart than the old fixed ACK_PERIOD / 2 threshold
+    _app.ack_ms = 3000;
+    _run(30000, 100000);
+
+    TEST_ASSERT_TRUE(bt_isLive());
+    TEST_ASSERT_EQUAL_UINT8(0, _live_rate.shift);
+    TEST_ASSERT_UINT32_WITHIN(3000 + 2 * LIVE_ACK_MARGIN_MS, 3000, _live_rate.ack_interval);
+    TEST_ASSERT_EQUAL_UINT32(0, _app.bad);
+    TEST_ASSERT_UINT32_WITHIN(2, _produced, _app.samples);
+}
+
+void test_late_ack_decimates_then_recovers()
+{
+    _run(5000, 100000);
+    TEST_ASSERT_EQUAL_UINT8(0, _live_rate.shift);
+
+    // Miss acks, then carry on as before
+    _app.ack_ms = 0;
+    _run(2000, 100000);
+    TEST_ASSERT_TRUE(_live_rate.shift > 0);
+
+    uint8_t shift = _live_rate.shift;
+
+    _app.ack_ms = 1000;
+    _app.last_ack = _mock_now_us() - 1000000;
+    _run(shift * LIVE_RATE_RAISE_MS + 2000, 100000);
+
+    TEST_ASSERT_TRUE(bt_isLive());
+    TEST_ASSERT_EQUAL_UINT8(0, _live_rate.shift);
+}
+
+void test_slow_link_decimates_without_blocking()
+{
+    // 240 bytes/s, far short of 100 Hz with every channel
+    Serial1.baud = 2400;
+    _run(30000, 10000);
+
+    double rate = _app.samples / 30.0;
+
+    printf("bench live at 100 Hz over 2400 baud: decimated 1/%d, %.1f samples/s received, "
+           "%lu frames dropped, %lu bytes rejected\n",
+           1 << _live_rate.shift, rate, (unsigned long) _live_rate.dropped, (unsigned long) _tx_rejected);
+
+    TEST_ASSERT_TRUE(_live_rate.shift >= 3);
+    TEST_ASSERT_EQUAL_UINT32(0, _app.bad);
+    TEST_ASSERT_EQUAL_UINT32(0, Serial1.blocked);
+    TEST_ASSERT_TRUE(_app.samples > 0);
+}
+
+void test_fast_link_keeps_full_rate()
+{
+    _run(30000, 10000);
+
+    TEST_ASSERT_EQUAL_UINT8(0, _live_rate.shift);
+    TEST_ASSERT_EQUAL_UINT32(0, _live_rate.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, _app.bad);
+    TEST_ASSERT_UINT32_WITHIN(20, _produced, _app.samples);
+}
+
+void test_rate_reply_long_poll()
+{
+    // A poll_rate that doesn't fit in 16 bits, decimated by 2
+    config_values[CONFIG_POLL_RATE].num_value = 70000;
+    _live_rate.shift = 1;
+    mock_advance(100000);
+    _appService();
+
+    Serial1.feed("lrt\n");
+    bt_tick();
+    mock_advance(100000);
+    Serial1.drain();
+
+    std::string reply(Serial1.sent.begin(), Serial1.sent.end());
+    TEST_ASSERT_EQUAL_STRING("ok,2,140000\r\n", reply.c_str());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_app_acks_are_not_congestion);
+    RUN_TEST(test_late_ack_decimates_then_recovers);
+    RUN_TEST(test_slow_link_decimates_without_blocking);
+    RUN_TEST(test_fast_link_keeps_full_rate);
+    RUN_TEST(test_rate_reply_long_poll);
+    return UNITY_END();
+}
@@ -0,0 +1,463 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host simulation of a historical `get` transfer running alongside
+ *            logging. The main loop is modelled on a frozen clock: samples
+ *            arrive in the logger ring every 10 ms, bt_tick runs, the ring
+ *            is written to the card, and the app on the other end of the
+ *            link decodes frames, grants credit and acks. A transfer that
+ *            holds up the loop shows as dropped samples.
+ *
+ *          Between the UART and the app sits a model of the HM-10: a
+ *            buffer that fills from the UART and empties one notification
+ *            at a time. The real module locks up when that buffer overflows.
+ */
+
+#include <unity.h>
+
+#include <string>
+
+#include "fakes.h"
+#include "ring.h"
+#include "../../src/csv.cpp"
+#include "../../src/frame.cpp"
+#include "../../src/storage.cpp"
+#include "../../src/bt.cpp"
+
+#define HOUR         1767225600UL       // Local epoch, 2026-01-01 00:00
+#define HOUR_ARG     (HOUR + 25200)     // UTC hour the app asks for
+#define CHANNELS     13
+#define HOUR_ROWS    (3600 * 10)        // An hour at a 100 ms poll rate
+#define LOOP_US      250                // Time one pass of loop() takes
+#define POLL_US      10000              // Logging rate during the transfer
+#define APP_DELAY_US 15000              // App reply latency over BLE
+#define APP_CREDIT   (XFER_WINDOW / 2)  // Frames the app grants at a time
+
+// Assumed HM-10 limits. The old fixed pacing (53 bytes every 7 ms) worked,
+//   so the module forwards at least that fast; the buffer size is a guess
+//   on the small side.
+#define HM10_BUF         1024           // Bytes the module can hold
+#define HM10_SLOW_US     2500           // Time per 20 byte notification, 8 kB/s
+#define HM10_FAST_US     1250           // Better connection interval, 16 kB/s
+
+// The old `get` sent the raw log_entry_t and a '#' then waited 7 ms
+#define OLD_SAMPLE_US    7000
+
+// The app end of the link
+typedef struct app_t
+{
+    std::vector<uint8_t> frame;         // Bytes since the last delimiter
+    uint32_t bytes;                     // Bytes received
+    uint32_t hist;                      // FRAME_HIST frames received
+    uint32_t query;                     // FRAME_QUERY frames received
+    std::vector<uint8_t> last_query;    // Payload of the last FRAME_QUERY
+    uint32_t bad;                       // Frames that failed to decode
+    uint32_t out_of_order;              // Sequence numbers that skipped
+    uint16_t next_seq;
+    uint32_t end_sent;                  // Count in the FRAME_END, once ended
+    bool ended;
+    uint32_t since_credit;              // Frames received since granting credit
+    uint64_t last_ack;
+    std::deque<std::pair<uint64_t, std::string>> replies;   // Due time, text
+} app_t;
+
+// The HM-10 between the UART and the app
+typedef struct hm10_t
+{
+    std::deque<uint8_t> buf;
+    size_t peak;                        // Most bytes held at once
+    uint32_t overflow;                  // Bytes that arrived with the buffer full
+    uint64_t next_notify;               // Time the next notification goes out
+    uint32_t notify_us;                 // Time per notification
+} hm10_t;
+
+// Stand-ins for the modules bt.cpp calls that aren't under test
+void clock_set(uint32_t time) {}
+
+static app_t _app;
+static hm10_t _hm10;
+static ring_t<log_entry_t, LOGGER_RING_LEN> _sim_ring;
+static uint64_t _next_poll;
+
+void setUp()
+{
+    Serial.muted = true;
+    mock_time_frozen = true;
+    mock_sd_reset();
+    _log = log_session_t();
+    _log.catalog = -1;
+    _log_buf_len = 0;
+    _log_pending = false;
+    _index_buf_len = 0;
+    _reader.file.close();
+    fake_local_now = HOUR;
+    fake_channel_mask = (1 << CHANNELS) - 1;
+    storage_init();
+
+    Serial1 = HardwareSerial();
+    _tx_capacity = 0;
+    _state = BT_IDLE;
+    bt_init();
+
+    _app = app_t();
+    _hm10 = hm10_t();
+    _hm10.notify_us = HM10_SLOW_US;
+    _sim_ring.resetStats();
+    while (_sim_ring.peek())
+        _sim_ring.pop();
+}
+
+void tearDown()
+{
+    _logClose();
+    mock_time_frozen = false;
+}
+
+/*
+ * Name:    _logHour
+ *  count:  samples to log at 10 per second, in binary
+ *  start:  local epoch of the first sample
+ */
+static void _logHour(uint32_t count, uint32_t start = HOUR)
+{
+    config_values[CONFIG_LOG_FORMAT].num_value = LOG_FORMAT_BIN;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        log_entry_t entry = {};
+
+        entry.time = start + n / 10;
+        entry.millis = (n % 10) * 100;
+        entry.mpu_accel[0] = (int16_t) n;
+        for (uint8_t i = 0; i < CHANNELS; i++)
+            entry.adc_data[i] = (uint16_t) ((n + i) % 8192);
+
+        TEST_ASSERT_TRUE(storage_addToLogFile((char*) &entry, LOG_BIN_RECORD_SIZE(CHANNELS), LOG_FORMAT_BIN, entry.time));
+    }
+
+    _logClose();
+}
+
+/*
+ * Name:    _appSend
+ *  text:   command to send to the device, after the BLE latency
+ */
+static void _appSend(const char* text)
+{
+    _app.replies.emplace_back(_mock_now_us() + APP_DELAY_US, text);
+}
+
+/*
+ * Name:    _appReceive
+ *  byte:   next byte the app received
+ * Desc:    Decode a frame at each delimiter and grant credit as frames arrive
+ */
+static void _appReceive(uint8_t byte)
+{
+    _app.bytes++;
+
+    if (byte)
+    {
+        _app.frame.push_back(byte);
+        return;
+    }
+
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint8_t type;
+    uint16_t seq, len;
+
+    if (!frame_decode(_app.frame.data(), _app.frame.size(), &type, &seq, payload, &len))
+    {
+        _app.bad++;
+        _app.frame.clear();
+        return;
+    }
+
+    _app.frame.clear();
+
+    if (type == FRAME_END)
+    {
+        _app.ended = true;
+        memcpy(&_app.end_sent, payload, sizeof(_app.end_sent));
+        return;
+    }
+
+    if (type == FRAME_QUERY)
+    {
+        _app.query++;
+        _app.last_query.assign(payload, payload + len);
+    }
+    else if (type == FRAME_HIST)
+    {
+        if (seq != _app.next_seq)
+            _app.out_of_order++;
+
+        _app.next_seq = seq + 1;
+        _app.hist++;
+    }
+    else
+        return;
+
+    if (++_app.since_credit == APP_CREDIT)
+    {
+        char text[16];
+
+        snprintf(text, sizeof(text), "crd %d\n", APP_CREDIT);
+        _appSend(text);
+        _app.since_credit = 0;
+    }
+}
+
+/*
+ * Name:    _appService
+ * Desc:    Pass what the UART sent through the HM-10, ack once a second and
+ *            deliver replies that are due
+ */
+static void _appService()
+{
+    Serial1.drain();
+    for (uint8_t byte : Serial1.sent)
+    {
+        if (_hm10.buf.size() < HM10_BUF)
+            _hm10.buf.push_back(byte);
+        else
+            _hm10.overflow++;
+    }
+    Serial1.sent.clear();
+    _hm10.peak = max(_hm10.peak, _hm10.buf.size());
+
+    if (_hm10.buf.empty())
+        _hm10.next_notify = _mock_now_us();
+
+    while (!_hm10.buf.empty() && _mock_now_us() >= _hm10.next_notify)
+    {
+        for (uint8_t i = 0; i < HM_10_MTU && !_hm10.buf.empty(); i++)
+        {
+            _appReceive(_hm10.buf.front());
+            _hm10.buf.pop_front();
+        }
+
+        _hm10.next_notify += _hm10.notify_us;
+    }
+
+    if (_mock_now_us() - _app.last_ack >= 1000000)
+    {
+        _appSend("a");
+        _app.last_ack = _mock_now_us();
+    }
+
+    while (!_app.replies.empty() && _app.replies.front().first <= _mock_now_us())
+    {
+        Serial1.feed(_app.replies.front().second.c_str());
+        _app.replies.pop_front();
+    }
+}
+
+/*
+ * Name:    _loop
+ * Desc:    One pass of loop(): new samples arrive in the ring, bt_tick runs,
+ *            then the ring is written out as logger_serviceBuffer does
+ */
+static void _loop()
+{
+    while (_mock_now_us() >= _next_poll)
+    {
+        log_entry_t entry = {};
+
+        entry.time = fake_local_now + (uint32_t) (_next_poll / 1000000);
+        entry.millis = (_next_poll / 1000) % 1000;
+        _sim_ring.push(entry);
+        _next_poll += POLL_US;
+    }
+
+    bt_tick();
+
+    log_entry_t* entry;
+    while ((entry = _sim_ring.peek()) &&
+           storage_addToLogFile((char*) entry, LOG_BIN_RECORD_SIZE(CHANNELS), LOG_FORMAT_BIN, entry->time))
+        _sim_ring.pop();
+
+    _appService();
+    mock_advance(LOOP_US);
+}
+
+/*
+ * Name:    _transferHour
+ *  return: simulated seconds taken to send a logged hour while logging the
+ *            next one
+ */
+static double _transferHour()
+{
+    _logHour(HOUR_ROWS);
+
+    // Log the following hour while the first is sent
+    fake_local_now = HOUR + SECS_PER_HOUR;
+    _next_poll = _mock_now_us();
+
+    char get[32];
+    snprintf(get, sizeof(get), "get %lu\n", HOUR_ARG);
+    Serial1.feed(get);
+
+    uint64_t start = _mock_now_us();
+
+    while (!_app.ended && _mock_now_us() - start < 3600000000ULL)
+        _loop();
+
+    double secs = (_mock_now_us() - start) / 1e6;
+    double old_secs = HOUR_ROWS * (OLD_SAMPLE_US / 1e6);
+
+    // Whichever of the UART and the BLE side is slower sets the best time
+    double byte_us = max(10e6 / HM_10_BAUDRATE, (double) _hm10.notify_us / HM_10_MTU);
+    double best_secs = _app.bytes * byte_us / 1e6;
+
+    printf("bench hour transfer at %.0f kB/s over BLE: %u samples in %.1f s simulated, "
+           "link allows %.1f s, old pacing %.0f s (%.2fx), ring high water %u / %u, "
+           "HM-10 peak %zu / %d\n",
+           HM_10_MTU * 1000.0 / _hm10.notify_us, _app.hist, secs, best_secs, old_secs, old_secs / secs,
+           _sim_ring.highWater(), _sim_ring.capacity(), _hm10.peak, HM10_BUF);
+
+    TEST_ASSERT_TRUE(_app.ended);
+    TEST_ASSERT_EQUAL_UINT32(HOUR_ROWS, _app.hist);
+    TEST_ASSERT_EQUAL_UINT32(HOUR_ROWS, _app.end_sent);
+    TEST_ASSERT_EQUAL_UINT32(0, _app.bad);
+    TEST_ASSERT_EQUAL_UINT32(0, _app.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(0, _sim_ring.drops());
+    TEST_ASSERT_EQUAL_UINT32(0, Serial1.blocked);
+    TEST_ASSERT_EQUAL_UINT32(0, _hm10.overflow);
+    TEST_ASSERT_TRUE(secs < best_secs * 1.1);
+
+    return secs;
+}
+
+void test_hour_transfer_while_logging()
+{
+    _transferHour();
+}
+
+void test_hour_transfer_fast_link()
+{
+    // The UART is then what limits a transfer, at about 1.5x the old pacing
+    _hm10.notify_us = HM10_FAST_US;
+    TEST_ASSERT_TRUE(_transferHour() < HOUR_ROWS * (OLD_SAMPLE_US / 1e6) / 1.4);
+}
+
+void test_backs_off_once_per_stall()
+{
+    _logHour(600);
+
+    char get[32];
+    snprintf(get, sizeof(get), "get %lu\n", HOUR_ARG);
+    Serial1.feed(get);
+
+    // Hold back credit so the transfer stalls after its first window
+    for (int i = 0; i < 4000; i++)
+    {
+        _loop();
+        _app.replies.erase(std::remove_if(_app.replies.begin(), _app.replies.end(),
+                                          [](const std::pair<uint64_t, std::string>& r)
+                                          { return r.second[0] == 'c'; }),
+                           _app.replies.end());
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(XFER_WINDOW, _app.hist);
+    TEST_ASSERT_TRUE(_xfer.stalled);
+
+    // One back off from wherever the window left the gap, not the maximum
+    uint32_t gap = XFER_GAP_START_US - XFER_WINDOW * XFER_GAP_STEP_US;
+    TEST_ASSERT_EQUAL_UINT32(gap * 3 / 2, _xfer.gap);
+
+    // Credit gets it going again
+    Serial1.feed("crd 8\n");
+    for (int i = 0; i < 400; i++)
+        _loop();
+
+    TEST_ASSERT_FALSE(_xfer.stalled);
+    TEST_ASSERT_TRUE(_app.hist > XFER_WINDOW);
+}
+
+void test_transfer_of_missing_hour_ends()
+{
+    char get[32];
+    snprintf(get, sizeof(get), "get %lu\n", HOUR_ARG);
+    Serial1.feed(get);
+
+    for (int i = 0; i < 1000 && !_app.ended; i++)
+        _loop();
+
+    TEST_ASSERT_TRUE(_app.ended);
+    TEST_ASSERT_EQUAL_UINT32(0, _app.end_sent);
+    TEST_ASSERT_FALSE(bt_active());
+}
+
+void test_filter_steps_through_catalog()
+{
+    _logHour(100);
+    _logHour(100, HOUR + 5 * SECS_PER_HOUR);
+
+    // A year either side of the two hours logged
+    char flt[48];
+    snprintf(flt, sizeof(flt), "flt %lu %lu\n", HOUR - 365 * SECS_PER_DAY, HOUR + 365 * SECS_PER_DAY);
+    Serial1.feed(flt);
+
+    uint32_t misses = mock_sd_misses;
+
+    for (int i = 0; i < 100000 && !_app.ended; i++)
+        _loop();
+
+    TEST_ASSERT_TRUE(_app.ended);
+    TEST_ASSERT_EQUAL_UINT32(200, _app.query);
+    TEST_ASSERT_EQUAL_UINT32(200, _app.end_sent);
+
+    // Only the logged hours are looked at, not the 17000 or so in between
+    TEST_ASSERT_TRUE(mock_sd_misses - misses < 10);
+}
+
+void test_filter_mask_by_channel()
+{
+    // Logged on channels 2 to 14, so the first reading is channel 2
+    fake_channel_mask = ((1 << CHANNELS) - 1) << 2;
+    _logHour(10);
+
+    char flt[64];
+    snprintf(flt, sizeof(flt), "flt %lu %lu 0x18\n", HOUR, HOUR + SECS_PER_HOUR);
+    Serial1.feed(flt);
+
+    for (int i = 0; i < 10000 && !_app.ended; i++)
+        _loop();
+
+    TEST_ASSERT_TRUE(_app.ended);
+    TEST_ASSERT_EQUAL_UINT32(10, _app.query);
+
+    // Channels 3 and 4 are the second and third readings of sample 9
+    uint16_t readings[2];
+    uint16_t header = offsetof(log_entry_t, adc_data);
+
+    TEST_ASSERT_EQUAL(header + sizeof(readings), _app.last_query.size());
+    memcpy(readings, _app.last_query.data() + header, sizeof(readings));
+    TEST_ASSERT_EQUAL_UINT16(10, readings[0]);
+    TEST_ASSERT_EQUAL_UINT16(11, readings[1]);
+
+    // Channels the file doesn't hold send nothing
+    _app = app_t();
+    snprintf(flt, sizeof(flt), "flt %lu %lu 0x8003\n", HOUR, HOUR + SECS_PER_HOUR);
+    Serial1.feed(flt);
+
+    for (int i = 0; i < 10000 && !_app.ended; i++)
+        _loop();
+
+    TEST_ASSERT_EQUAL_UINT32(10, _app.query);
+    TEST_ASSERT_EQUAL(header, _app.last_query.size());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_hour_transfer_while_logging);
+    RUN_TEST(test_hour_transfer_fast_link);
+    RUN_TEST(test_backs_off_once_per_stall);
+    RUN_TEST(test_transfer_of_missing_hour_ends);
+    RUN_TEST(test_filter_steps_through_catalog);
+    RUN_TEST(test_filter_mask_by_channel);
+    return UNITY_END();
+}
@@ -0,0 +1,216 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the CSV row formatter and parser. Rows must match
+ *            what the snprintf formatter they replaced produced, byte for
+ *            byte, and both are timed.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <random>
+
+#include "../../src/csv.cpp"
+
+#define RANDOM_ROWS 100000
+
+std::mt19937 _rng(1234);
+
+void setUp() {}
+void tearDown() {}
+
+/*
+ * Name:    _snprintfRow
+ *  buf:    where to write the row
+ *  entry:  sample to format
+ *  channels: number of ADC channels
+ *  return: length of the row
+ * Desc:    The row format as written with snprintf before csv_formatRow
+ */
+static uint16_t _snprintfRow(char* buf, const log_entry_t* entry, uint8_t channels)
+{
+    uint16_t len = snprintf(buf, CSV_ROW_MAX_LEN, "%lu.%03d,%d,%d,%d,%d,%d,%d,%d",
+                            (unsigned long) entry->time, entry->millis,
+                            entry->mpu_accel[0], entry->mpu_accel[1], entry->mpu_accel[2],
+                            entry->mpu_gyro[0], entry->mpu_gyro[1], entry->mpu_gyro[2],
+                            entry->mpu_temp);
+
+    for (uint8_t i = 0; i < channels; i++)
+        len += snprintf(buf + len, CSV_ROW_MAX_LEN - len, ",%d", entry->adc_data[i]);
+
+    len += snprintf(buf + len, CSV_ROW_MAX_LEN - len, "\r\n");
+    return len;
+}
+
+/*
+ * Name:    _randomEntry
+ *  entry:  set to a sample with random values, favouring edge cases
+ */
+static void _randomEntry(log_entry_t* entry)
+{
+    static const int32_t edges[] = { 0, 1, -1, 9, 10, 99, 100, -100, 999, 1000, 9999, 10000,
+                                     INT16_MAX, INT16_MIN, UINT16_MAX };
+    auto value = [](int32_t lo, int32_t hi)
+    {
+        if (_rng() % 4 == 0)
+        {
+            int32_t edge = edges[_rng() % (sizeof(edges) / sizeof(edges[0]))];
+            if (edge >= lo && edge <= hi)
+                return edge;
+        }
+        return (int32_t) (lo + _rng() % ((uint32_t) (hi - lo) + 1));
+    };
+
+    memset(entry, 0, sizeof(*entry));
+    entry->time = (_rng() % 8 == 0) ? UINT32_MAX - _rng() % 2 : 1700000000 + _rng() % 100000000;
+    entry->millis = value(0, 999);
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        entry->mpu_accel[i] = value(INT16_MIN, INT16_MAX);
+        entry->mpu_gyro[i] = value(INT16_MIN, INT16_MAX);
+    }
+    entry->mpu_temp = value(INT16_MIN, INT16_MAX);
+
+    for (uint8_t i = 0; i < LOGGER_MAX_ADC_CHANNELS; i++)
+        entry->adc_data[i] = value(0, UINT16_MAX);
+}
+
+void test_matches_snprintf()
+{
+    char fast[CSV_ROW_MAX_LEN], slow[CSV_ROW_MAX_LEN];
+    log_entry_t entry;
+
+    for (uint32_t n = 0; n < RANDOM_ROWS; n++)
+    {
+        uint8_t channels = n % (LOGGER_MAX_ADC_CHANNELS + 1);
+        _randomEntry(&entry);
+
+        uint16_t len = csv_formatRow(fast, &entry, channels);
+        TEST_ASSERT_EQUAL(_snprintfRow(slow, &entry, channels), len);
+        TEST_ASSERT_EQUAL_MEMORY(slow, fast, len);
+    }
+}
+
+void test_longest_row_fits()
+{
+    char buf[CSV_ROW_MAX_LEN];
+    log_entry_t entry;
+
+    memset(&entry, 0, sizeof(entry));
+    entry.time = UINT32_MAX;
+    entry.millis = 999;
+    for (uint8_t i = 0; i < 3; i++)
+        entry.mpu_accel[i] = entry.mpu_gyro[i] = INT16_MIN;
+    entry.mpu_temp = INT16_MIN;
+    for (uint8_t i = 0; i < LOGGER_MAX_ADC_CHANNELS; i++)
+        entry.adc_data[i] = UINT16_MAX;
+
+    TEST_ASSERT_LESS_OR_EQUAL(CSV_ROW_MAX_LEN, csv_formatRow(buf, &entry, LOGGER_MAX_ADC_CHANNELS));
+}
+
+void test_round_trip()
+{
+    char buf[CSV_ROW_MAX_LEN];
+    log_entry_t entry, parsed;
+
+    for (uint32_t n = 0; n < RANDOM_ROWS; n++)
+    {
+        uint8_t channels = n % (LOGGER_MAX_ADC_CHANNELS + 1);
+        _randomEntry(&entry);
+        memset(entry.adc_data + channels, 0, (LOGGER_MAX_ADC_CHANNELS - channels) * sizeof(uint16_t));
+
+        // The parser is given the row without its line ending
+        uint16_t len = csv_formatRow(buf, &entry, channels) - 2;
+        TEST_ASSERT_EQUAL(9 + channels, csv_parseRow(buf, len, &parsed));
+        TEST_ASSERT_EQUAL_MEMORY(&entry, &parsed, sizeof(entry));
+    }
+}
+
+void test_parse_malformed()
+{
+    log_entry_t entry;
+    const char* cut = "1767225600.250,1,2";
+
+    // Fields are counted up to the first one that is missing or bad
+    TEST_ASSERT_EQUAL(0, csv_parseRow("", 0, &entry));
+    TEST_ASSERT_EQUAL(0, csv_parseRow("x", 1, &entry));
+    TEST_ASSERT_EQUAL(1, csv_parseRow("1767225600", 10, &entry));
+    TEST_ASSERT_EQUAL(4, csv_parseRow(cut, strlen(cut), &entry));
+    TEST_ASSERT_EQUAL(3, csv_parseRow(cut, 16, &entry));
+    TEST_ASSERT_EQUAL(3, csv_parseRow("1.2,3,,4", 8, &entry));
+}
+
+void test_mask_comment()
+{
+    char buf[CSV_MASK_MAX_LEN];
+    uint16_t mask = 0;
+    log_entry_t entry;
+
+    // Round trip at the longest, and the parser is given the line without
+    //   its line ending
+    uint16_t len = csv_formatMask(buf, 0xFFFF);
+    TEST_ASSERT_EQUAL(CSV_MASK_MAX_LEN, len);
+    TEST_ASSERT_TRUE(csv_parseComment(buf, len - 2, &mask));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, mask);
+
+    len = csv_formatMask(buf, 0x1F0);
+    TEST_ASSERT_EQUAL_STRING_LEN("#channel_mask,496\r\n", buf, len);
+    TEST_ASSERT_TRUE(csv_parseComment(buf, len - 2, &mask));
+    TEST_ASSERT_EQUAL_HEX16(0x1F0, mask);
+
+    // Other and malformed comments are still comments, but leave the mask
+    TEST_ASSERT_TRUE(csv_parseComment("#note", 5, &mask));
+    TEST_ASSERT_TRUE(csv_parseComment("#channel_mask,", 14, &mask));
+    TEST_ASSERT_TRUE(csv_parseComment("#channel_mask,65536", 19, &mask));
+    TEST_ASSERT_TRUE(csv_parseComment("#channel_mask,12x", 17, &mask));
+    TEST_ASSERT_EQUAL_HEX16(0x1F0, mask);
+
+    // Rows are not comments, and the comment is not a row
+    TEST_ASSERT_FALSE(csv_parseComment("1.000,1", 7, &mask));
+    TEST_ASSERT_FALSE(csv_parseComment("", 0, &mask));
+    TEST_ASSERT_EQUAL(0, csv_parseRow(buf, len - 2, &entry));
+}
+
+void test_format_speed()
+{
+    const uint32_t rows = 200000;
+    static log_entry_t entries[1024];
+    char buf[CSV_ROW_MAX_LEN];
+    uint32_t check = 0;
+
+    for (uint16_t i = 0; i < 1024; i++)
+        _randomEntry(&entries[i]);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rows; n++)
+        check += csv_formatRow(buf, &entries[n % 1024], 13);
+    double fast = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rows; n++)
+        check -= _snprintfRow(buf, &entries[n % 1024], 13);
+    double slow = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "format: csv_formatRow %.2f M rows/s, snprintf %.2f M rows/s (%.1fx)",
+             rows / fast / 1e6, rows / slow / 1e6, slow / fast);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL(0, check);
+    TEST_ASSERT_LESS_THAN(slow, fast);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_snprintf);
+    RUN_TEST(test_longest_row_fits);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_parse_malformed);
+    RUN_TEST(test_mask_comment);
+    RUN_TEST(test_format_speed);
+    return UNITY_END();
+}
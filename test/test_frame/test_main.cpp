@@ -0,0 +1,239 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the Bluetooth frame encoder and decoder, including
+ *            a stream sent over a simulated UART that drops, flips and
+ *            inserts bytes. Also times encoding and decoding.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "../../src/frame.cpp"
+
+#define STREAM_FRAMES   20000
+#define LOSS_RATE       0.0005      // Chance each byte is dropped, flipped or doubled
+
+void setUp() {}
+void tearDown() {}
+
+/*
+ * Name:    _payload
+ *  seq:    sequence number
+ *  out:    buffer of FRAME_MAX_PAYLOAD bytes
+ *  return: payload length
+ * Desc:    Payload that can be recreated from the sequence number alone, with
+ *            plenty of zeros so COBS has work to do
+ */
+static uint16_t _payload(uint16_t seq, uint8_t* out)
+{
+    std::mt19937 gen(seq);
+    uint16_t len = seq % (FRAME_MAX_PAYLOAD + 1);
+
+    for (uint16_t i = 0; i < len; i++)
+        out[i] = (gen() % 3) ? gen() : 0;
+
+    return len;
+}
+
+void test_round_trip_every_length()
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD], decoded[FRAME_MAX_PAYLOAD];
+    uint8_t frame[FRAME_MAX_ENCODED];
+
+    for (uint16_t seq = 0; seq <= FRAME_MAX_PAYLOAD; seq++)
+    {
+        uint16_t len = _payload(seq, payload);
+        uint16_t frame_len = frame_encode(frame, FRAME_HIST, seq, payload, len);
+
+        TEST_ASSERT_TRUE(frame_len > 0 && frame_len <= FRAME_MAX_ENCODED);
+        TEST_ASSERT_EQUAL_UINT8(0, frame[frame_len - 1]);
+        for (uint16_t i = 0; i < frame_len - 1; i++)
+            TEST_ASSERT_NOT_EQUAL(0, frame[i]);
+
+        uint8_t type;
+        uint16_t got_seq, got_len;
+
+        TEST_ASSERT_TRUE(frame_decode(frame, frame_len - 1, &type, &got_seq, decoded, &got_len));
+        TEST_ASSERT_EQUAL_UINT8(FRAME_HIST, type);
+        TEST_ASSERT_EQUAL_UINT16(seq, got_seq);
+        TEST_ASSERT_EQUAL_UINT16(len, got_len);
+        TEST_ASSERT_EQUAL_MEMORY(payload, decoded, len);
+    }
+}
+
+void test_worst_case_size()
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD + 1];
+    uint8_t frame[FRAME_MAX_ENCODED];
+
+    // No zeros at all is the longest COBS output
+    memset(payload, 0xFF, sizeof(payload));
+
+    TEST_ASSERT_EQUAL_UINT16(FRAME_MAX_ENCODED,
+                             frame_encode(frame, 0xFF, 0xFFFF, payload, FRAME_MAX_PAYLOAD));
+    TEST_ASSERT_EQUAL_UINT16(0, frame_encode(frame, FRAME_HIST, 0, payload, FRAME_MAX_PAYLOAD + 1));
+}
+
+void test_rejects_every_single_flip()
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD], decoded[FRAME_MAX_PAYLOAD];
+    uint8_t frame[FRAME_MAX_ENCODED];
+    uint16_t len = _payload(100, payload);
+    uint16_t frame_len = frame_encode(frame, FRAME_HIST, 100, payload, len);
+
+    for (uint16_t i = 0; i < frame_len - 1; i++)
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            uint8_t type;
+            uint16_t seq, got_len;
+
+            frame[i] ^= 1 << bit;
+            TEST_ASSERT_FALSE(frame_decode(frame, frame_len - 1, &type, &seq, decoded, &got_len));
+            frame[i] ^= 1 << bit;
+        }
+    }
+}
+
+void test_lossy_uart()
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::vector<uint8_t> wire;
+    uint32_t damaged = 0;
+
+    // Send a stream through a UART that sometimes loses or mangles a byte
+    for (uint32_t n = 0; n < STREAM_FRAMES; n++)
+    {
+        uint8_t payload[FRAME_MAX_PAYLOAD];
+        uint8_t frame[FRAME_MAX_ENCODED];
+        uint16_t len = _payload(n, payload);
+        uint16_t frame_len = frame_encode(frame, FRAME_HIST, n, payload, len);
+        bool hit = false;
+
+        for (uint16_t i = 0; i < frame_len; i++)
+        {
+            double p = chance(gen);
+
+            if (p < LOSS_RATE / 3)
+                hit = true;                         // Dropped
+            else if (p < 2 * LOSS_RATE / 3)
+            {
+                wire.push_back(frame[i] ^ (1 << (gen() % 8)));
+                hit = true;
+            }
+            else if (p < LOSS_RATE)
+            {
+                wire.push_back(frame[i]);
+                wire.push_back(frame[i]);
+                hit = true;
+            }
+            else
+                wire.push_back(frame[i]);
+        }
+
+        damaged += hit;
+    }
+
+    // Receive, splitting at each delimiter as the app does
+    uint32_t good = 0, rejected = 0, wrong = 0;
+    size_t start = 0;
+
+    for (size_t i = 0; i < wire.size(); i++)
+    {
+        if (wire[i])
+            continue;
+
+        uint8_t decoded[FRAME_MAX_PAYLOAD], expect[FRAME_MAX_PAYLOAD];
+        uint8_t type;
+        uint16_t seq, len;
+
+        if (frame_decode(&wire[start], i - start, &type, &seq, decoded, &len))
+        {
+            // Anything accepted must be exactly what was sent
+            if (type != FRAME_HIST || len != _payload(seq, expect) || memcmp(decoded, expect, len))
+                wrong++;
+            else
+                good++;
+        }
+        else
+            rejected++;
+
+        start = i + 1;
+    }
+
+    printf("bench lossy uart: %u frames, %u damaged, %u decoded, %u rejected\n",
+           STREAM_FRAMES, damaged, good, rejected);
+
+    TEST_ASSERT_TRUE(damaged > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, wrong);
+
+    // A damaged frame costs at most itself and the frame after it (when its
+    //   delimiter is the byte lost)
+    TEST_ASSERT_TRUE(good >= STREAM_FRAMES - 2 * damaged);
+    TEST_ASSERT_TRUE(good <= STREAM_FRAMES - damaged);
+}
+
+void test_varint_round_trip()
+{
+    const int32_t values[] = { 0, 1, -1, 63, -64, 64, 127, 128, -129, 16383, 16384,
+                               INT16_MAX, INT16_MIN, INT32_MAX, INT32_MIN };
+
+    for (int32_t val : values)
+    {
+        uint8_t buf[5];
+        uint32_t got;
+        uint8_t len = frame_putVarint(buf, frame_zigzag(val));
+
+        TEST_ASSERT_EQUAL_UINT8(len, frame_getVarint(buf, len, &got));
+        TEST_ASSERT_EQUAL_INT32(val, frame_unzigzag(got));
+        TEST_ASSERT_EQUAL_UINT8(0, frame_getVarint(buf, len - 1, &got));
+    }
+}
+
+void test_speed()
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD], decoded[FRAME_MAX_PAYLOAD];
+    uint8_t frame[FRAME_MAX_ENCODED];
+    uint16_t len = 42;      // A historical sample with 13 channels
+    uint64_t bytes = 0;
+    uint32_t sum = 0;
+    const uint32_t rounds = 200000;
+
+    _payload(len, payload);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t n = 0; n < rounds; n++)
+    {
+        uint8_t type;
+        uint16_t seq, got_len;
+        uint16_t frame_len = frame_encode(frame, FRAME_HIST, n, payload, len);
+
+        sum += frame_decode(frame, frame_len - 1, &type, &seq, decoded, &got_len);
+        bytes += frame_len;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("bench frame encode+decode: %.0f frames/s, %.1f MB/s on the wire\n",
+           rounds / secs, bytes / secs / 1e6);
+    TEST_ASSERT_EQUAL_UINT32(rounds, sum);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_every_length);
+    RUN_TEST(test_worst_case_size);
+    RUN_TEST(test_rejects_every_single_flip);
+    RUN_TEST(test_lossy_uart);
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_speed);
+    return UNITY_END();
+}
@@ -0,0 +1,297 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the interrupt driven I2C engine, run against the
+ *            simulated I2C0 peripheral and MPU 6050. Checks the order of bus
+ *            events, when completions are called and what state the bus is
+ *            in when they are, sharing the bus with blocking Wire users,
+ *            NACKs and timeouts. Also shows what an async sample read costs
+ *            the sample ISR.
+ */
+
+#include <unity.h>
+
+#include "../../src/i2c.cpp"
+#include "../../src/mpu.cpp"
+
+#define MPU     MPU6050_DEFAULT_ADDRESS
+
+// Stand-ins for the modules mpu.cpp calls that aren't under test
+float storage_configGetNum(config_keys_t option) { return 0; }
+
+// What a completion saw when it was called
+typedef struct completion_t
+{
+    uint32_t calls;
+    bool ok;
+    void* ctx;
+    bool busy;              // i2c_busy() from inside the completion
+    bool bus_busy;          // I2C0 still saw the bus in use
+    uint8_t buf[32];        // Buffer contents at the time
+} completion_t;
+
+static completion_t _done;
+static uint8_t _buf[32];
+
+void setUp()
+{
+    Serial.muted = true;
+    mock_time_frozen = true;
+    mock_micros_cost_us = 0;
+    mock_i2c_reset();
+    mock_i2c0_reset();
+    mock_i2c.clock = 400000;
+
+    // Registers the tests read back. Asleep, so the sensor leaves them be.
+    for (uint8_t i = 0; i < 32; i++)
+        mock_mpu.regs[MPU6050_RA_ACCEL_XOUT_H + i] = 0xA0 + i;
+
+    _i2c_held = false;
+    _i2c = i2c_xfer_t();
+    i2c_init();
+
+    _done = completion_t();
+    memset(_buf, 0, sizeof(_buf));
+}
+
+void tearDown()
+{
+    mock_time_frozen = false;
+    mock_micros_cost_us = 0;
+}
+
+static void _onDone(bool ok, void* ctx)
+{
+    _done.calls++;
+    _done.ok = ok;
+    _done.ctx = ctx;
+    _done.busy = i2c_busy();
+    _done.bus_busy = I2C0_S & I2C_S_BUSY;
+    memcpy(_done.buf, _buf, sizeof(_buf));
+}
+
+/*
+ * Name:    _bitsUs
+ *  bits:   SCL periods
+ *  return: time they take at the bus clock (us), as I2C0 takes it
+ */
+static uint32_t _bitsUs(uint8_t bits)
+{
+    return (bits * 1000000 + mock_i2c.clock - 1) / mock_i2c.clock;
+}
+
+/*
+ * Name:    _byteUs
+ *  return: time to clock a byte and its ACK (us)
+ */
+static uint32_t _byteUs()
+{
+    return _bitsUs(9);
+}
+
+void test_read_completes_once()
+{
+    int ctx;
+
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, &ctx));
+
+    // Returns straight away, with nothing read yet
+    TEST_ASSERT_EQUAL_UINT32(0, _done.calls);
+    TEST_ASSERT_TRUE(i2c_busy());
+    TEST_ASSERT_EQUAL_UINT32(1, mock_i2c.stats.transactions);
+
+    // Start and address, register, repeated start and address, then 14 bytes
+    mock_advance(2 * _bitsUs(10) + 15 * _byteUs() - 1);
+    TEST_ASSERT_EQUAL_UINT32(0, _done.calls);
+
+    mock_advance(1);
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_TRUE(_done.ok);
+    TEST_ASSERT_EQUAL_PTR(&ctx, _done.ctx);
+
+    // A start then a repeated start, and exactly the bytes asked for
+    TEST_ASSERT_EQUAL_UINT32(2, mock_i2c.stats.transactions);
+    TEST_ASSERT_EQUAL_UINT32(2 + 1 + 14, mock_i2c.stats.bytes);
+    TEST_ASSERT_EQUAL_UINT32(17, mock_i2c0.irqs);
+
+    // The whole buffer was in place, and the bus free, by the completion
+    for (uint8_t i = 0; i < 14; i++)
+        TEST_ASSERT_EQUAL_HEX8(0xA0 + i, _done.buf[i]);
+    TEST_ASSERT_EQUAL_HEX8(0, _done.buf[14]);
+    TEST_ASSERT_FALSE(_done.busy);
+    TEST_ASSERT_FALSE(_done.bus_busy);
+
+    // Nothing more happens
+    mock_advance(10000);
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_EQUAL_UINT32(17, mock_i2c0.irqs);
+}
+
+void test_single_byte()
+{
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_WHO_AM_I, _buf, 1, _onDone, NULL));
+    mock_advance(1000);
+
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_TRUE(_done.ok);
+    TEST_ASSERT_EQUAL_HEX8(MPU, _done.buf[0]);
+    TEST_ASSERT_EQUAL_UINT32(2 + 1 + 1, mock_i2c.stats.bytes);
+}
+
+void test_back_to_back_reads_in_order()
+{
+    // The second read is refused until the first completes
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 4, _onDone, (void*) 1));
+    TEST_ASSERT_FALSE(i2c_readAsync(MPU, MPU6050_RA_TEMP_OUT_H, _buf + 4, 2, _onDone, (void*) 2));
+
+    mock_advance(1000);
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_EQUAL_PTR((void*) 1, _done.ctx);
+
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_TEMP_OUT_H, _buf + 4, 2, _onDone, (void*) 2));
+    mock_advance(1000);
+    TEST_ASSERT_EQUAL_UINT32(2, _done.calls);
+    TEST_ASSERT_EQUAL_PTR((void*) 2, _done.ctx);
+
+    uint8_t want[] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA6, 0xA7 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(want, _done.buf, sizeof(want));
+}
+
+void test_shares_bus_with_wire()
+{
+    // Held for blocking Wire use, so no transfer can start
+    TEST_ASSERT_TRUE(i2c_acquire(0));
+    TEST_ASSERT_TRUE(i2c_busy());
+    TEST_ASSERT_FALSE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, NULL));
+    TEST_ASSERT_FALSE(i2c_acquire(0));
+    i2c_release();
+
+    // And a transfer in flight keeps Wire off until it completes
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, NULL));
+    TEST_ASSERT_FALSE(i2c_acquire(0));
+
+    mock_micros_cost_us = 1;
+    uint32_t start = micros();
+
+    TEST_ASSERT_TRUE(i2c_acquire(I2C_TIMEOUT_US));
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_TRUE(_done.ok);
+    TEST_ASSERT_TRUE(micros() - start < 17 * _byteUs() + 10);
+
+    uint8_t id = 0;
+    TEST_ASSERT_EQUAL_INT8(1, I2Cdev::readByte(MPU, MPU6050_RA_WHO_AM_I, &id));
+    TEST_ASSERT_EQUAL_HEX8(MPU, id);
+    i2c_release();
+
+    TEST_ASSERT_FALSE(i2c_busy());
+}
+
+void test_nack_completes_with_failure()
+{
+    mock_mpu.present = false;
+
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, NULL));
+    mock_advance(_bitsUs(10));
+
+    // Gives up after the address, with a stop
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_FALSE(_done.ok);
+    TEST_ASSERT_FALSE(_done.busy);
+    TEST_ASSERT_FALSE(_done.bus_busy);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_i2c.stats.bytes);
+
+    mock_mpu.present = true;
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, NULL));
+    mock_advance(1000);
+    TEST_ASSERT_EQUAL_UINT32(2, _done.calls);
+    TEST_ASSERT_TRUE(_done.ok);
+}
+
+void test_lost_interrupt_times_out()
+{
+    // Bytes are clocked but the interrupt never arrives
+    NVIC_DISABLE_IRQ(IRQ_I2C0);
+
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, NULL));
+    mock_advance(I2C_TIMEOUT_US);
+    TEST_ASSERT_TRUE(i2c_busy());
+    TEST_ASSERT_EQUAL_UINT32(0, _done.calls);
+
+    // Checking the bus after the timeout abandons the transfer, once
+    mock_advance(1);
+    TEST_ASSERT_FALSE(i2c_busy());
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+    TEST_ASSERT_FALSE(_done.ok);
+    TEST_ASSERT_FALSE(I2C0_S & I2C_S_BUSY);
+
+    // A late interrupt is ignored
+    NVIC_ENABLE_IRQ(IRQ_I2C0);
+    mock_vectors[IRQ_I2C0]();
+    TEST_ASSERT_EQUAL_UINT32(1, _done.calls);
+
+    TEST_ASSERT_TRUE(i2c_readAsync(MPU, MPU6050_RA_ACCEL_XOUT_H, _buf, 14, _onDone, NULL));
+    mock_advance(1000);
+    TEST_ASSERT_EQUAL_UINT32(2, _done.calls);
+    TEST_ASSERT_TRUE(_done.ok);
+}
+
+static uint32_t _sample_done;
+static bool _sample_ok;
+
+static void _onSample(bool ok)
+{
+    _sample_done++;
+    _sample_ok = ok;
+}
+
+void test_async_sample_frees_the_isr()
+{
+    int16_t accel[3], gyro[3], temp;
+
+    TEST_ASSERT_TRUE(mpu_init());
+    mock_advance(2000);
+
+    // The blocking read holds the caller for the whole transfer
+    uint64_t start = _mock_now_us();
+    TEST_ASSERT_TRUE(mpu_sampleRaw(accel, gyro, &temp));
+    uint64_t blocking_us = _mock_now_us() - start;
+
+    // The async read only starts it; the rest happens in I2C interrupts
+    uint32_t irqs = mock_i2c0.irqs;
+    _sample_done = 0;
+    start = _mock_now_us();
+    TEST_ASSERT_TRUE(mpu_sampleAsync(accel, gyro, &temp, _onSample));
+    uint64_t isr_us = _mock_now_us() - start;
+
+    TEST_ASSERT_EQUAL_UINT32(0, _sample_done);
+    mock_advance(1000);
+    TEST_ASSERT_EQUAL_UINT32(1, _sample_done);
+    TEST_ASSERT_TRUE(_sample_ok);
+
+    int16_t want_accel[3], want_gyro[3], want_temp;
+    mock_mpu_sample(mock_mpu.samples - 1, want_accel, want_gyro, &want_temp);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(want_accel, accel, 3);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(want_gyro, gyro, 3);
+    TEST_ASSERT_EQUAL_INT16(want_temp, temp);
+
+    printf("bench mpu sample: blocking read waits %llu us, async start waits %llu us "
+           "then takes %u I2C interrupts of a few register accesses each\n",
+           (unsigned long long) blocking_us, (unsigned long long) isr_us, mock_i2c0.irqs - irqs);
+
+    TEST_ASSERT_EQUAL_UINT32(0, isr_us);
+    TEST_ASSERT_EQUAL_UINT32(17, mock_i2c0.irqs - irqs);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_read_completes_once);
+    RUN_TEST(test_single_byte);
+    RUN_TEST(test_back_to_back_reads_in_order);
+    RUN_TEST(test_shares_bus_with_wire);
+    RUN_TEST(test_nack_completes_with_failure);
+    RUN_TEST(test_lost_interrupt_times_out);
+    RUN_TEST(test_async_sample_frees_the_isr);
+    return UNITY_END();
+}
@@ -0,0 +1,300 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the sampling plan. The sample ISR must take its
+ *            channels and timing from the published plan without reading
+ *            the config, and samples already in the ring must be written
+ *            with the layout they were taken with when the plan changes.
+ */
+
+#include <unity.h>
+
+#include "../../src/csv.cpp"
+#include "../../src/logger.cpp"
+
+// Bytes the fake card has taken, one write per sample
+typedef struct written_t
+{
+    uint16_t len;
+    uint16_t mask;          // logger_channelMask() when it was written
+    int16_t accel_x;
+    int16_t temp;
+    uint16_t adc_data[LOGGER_MAX_ADC_CHANNELS];
+} written_t;
+
+static float _config_num[CONFIG_COUNT];
+static char _config_mask[CONFIG_STRING_LEN];
+static uint32_t _config_reads;
+static std::vector<written_t> _written;
+static bool _card_fails;
+static float _channel_us;
+static bool _scan_starts;
+static bool _imu_reads;         // The IMU answers reads
+static int16_t _imu_next;       // What the next IMU read returns
+
+// Stand-ins for the modules logger.cpp calls that aren't under test
+float storage_configGetNum(config_keys_t option) { _config_reads++; return _config_num[option]; }
+char* storage_configGetString(config_keys_t option) { _config_reads++; return _config_mask; }
+log_format_t storage_logFormat() { return LOG_FORMAT_BIN; }
+void storage_serviceLog() {}
+bool storage_addToImuFile(const mpu_sample_t* sample) { return true; }
+bool storage_addToScanFile(const log_scan_block_t* block) { return true; }
+void storage_addToRollup(const log_entry_t* entry, uint8_t channels) {}
+
+bool storage_addToLogFile(char* text, uint16_t len, log_format_t format, uint32_t time)
+{
+    written_t w = {};
+
+    if (_card_fails)
+        return false;
+
+    w.len = len;
+    w.mask = logger_channelMask();
+    w.accel_x = ((log_entry_t*) text)->mpu_accel[0];
+    w.temp = ((log_entry_t*) text)->mpu_temp;
+    memcpy(w.adc_data, ((log_entry_t*) text)->adc_data, len - offsetof(log_entry_t, adc_data));
+    _written.push_back(w);
+    return true;
+}
+
+uint32_t clock_getLocalNowSeconds() { return 1767225600; }
+uint16_t clock_millis() { return 0; }
+
+uint8_t adc_resolution() { return 13; }
+float adc_channelTime() { return _channel_us; }
+bool adc_scanStart(const uint16_t* channels, uint8_t count, uint16_t rate) { return _scan_starts; }
+void adc_scanStop() {}
+bool adc_scanRunning() { return false; }
+void adc_scanLatest(uint16_t* channels, uint8_t count) {}
+uint16_t adc_scanNextBlock(uint16_t* out, uint32_t* seq) { return 0; }
+
+void adc_sample(uint16_t* channels, uint8_t count)
+{
+    // A reading that shows which channel it came from
+    for (uint8_t i = 0; i < count; i++)
+        channels[i] = 100 + channels[i];
+}
+
+bool mpu_sampleAsync(int16_t accel[3], int16_t gyro[3], int16_t* temp, mpu_done_t done)
+{
+    if (!_imu_reads)
+        return false;
+
+    // Finishes straight away, as if the I2C interrupt came before the ISR returned
+    for (uint8_t i = 0; i < 3; i++)
+        accel[i] = gyro[i] = _imu_next;
+    *temp = _imu_next++;
+    done(true);
+    return true;
+}
+bool mpu_startFifo(uint16_t rate) { return false; }
+void mpu_stopFifo() {}
+uint16_t mpu_fifoRate() { return 0; }
+uint16_t mpu_readFifo(mpu_sample_t* out, uint16_t max, uint16_t* behind) { return 0; }
+
+bool i2c_busy() { return false; }
+
+bool bt_isLive() { return false; }
+void bt_sendSample(log_entry_t* sample) {}
+
+void setUp()
+{
+    Serial.muted = true;
+    logger_stopSampling();
+    while (_ring.peek())
+        _ring.pop();
+
+    memset(_config_num, 0, sizeof(_config_num));
+    _config_num[CONFIG_POLL_RATE] = 10;
+    strcpy(_config_mask, "0-3");
+    _written.clear();
+    _card_fails = false;
+    _channel_us = 10;
+    _scan_starts = false;
+    _imu_reads = false;
+    _imu_next = 0;
+    _sample_timer = IntervalTimer();
+    logger_loadConfig();
+}
+
+void tearDown()
+{
+    logger_stopSampling();
+}
+
+/*
+ * Name:    _sample
+ *  count:  samples to take, as the timer would
+ */
+static void _sample(uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+        _sampleISR();
+}
+
+/*
+ * Name:    _writeAll
+ * Desc:    Run the main loop's writer until the ring is empty, and once more
+ */
+static void _writeAll()
+{
+    while (_ring.peek())
+        logger_serviceBuffer();
+
+    logger_serviceBuffer();
+}
+
+void test_isr_walks_the_plan()
+{
+    strcpy(_config_mask, "2,5-7");
+    logger_startSampling();
+
+    TEST_ASSERT_EQUAL_HEX16(0xE4, logger_channelMask());
+    TEST_ASSERT_EQUAL_UINT8(4, logger_channelCount());
+    TEST_ASSERT_EQUAL_UINT32(10000, _sample_timer.period_us);
+
+    // The ISR converts the plan's channels and never reads the config
+    _config_reads = 0;
+    _sample(5);
+    TEST_ASSERT_EQUAL_UINT32(0, _config_reads);
+    TEST_ASSERT_EQUAL_UINT32(1, _sample_timer.begins);
+
+    _writeAll();
+    TEST_ASSERT_EQUAL(5, _written.size());
+    TEST_ASSERT_EQUAL(LOG_BIN_RECORD_SIZE(4), _written[4].len);
+    TEST_ASSERT_EQUAL_UINT16(102, _written[4].adc_data[0]);
+    TEST_ASSERT_EQUAL_UINT16(105, _written[4].adc_data[1]);
+    TEST_ASSERT_EQUAL_UINT16(107, _written[4].adc_data[3]);
+}
+
+void test_new_period_while_sampling()
+{
+    logger_startSampling();
+
+    // The timer is updated, not restarted, and the layout stays
+    _config_num[CONFIG_POLL_RATE] = 20;
+    strcpy(_config_mask, "0-7");
+    logger_loadConfig();
+
+    TEST_ASSERT_EQUAL_UINT32(20000, _sample_timer.period_us);
+    TEST_ASSERT_EQUAL_UINT32(1, _sample_timer.begins);
+    TEST_ASSERT_EQUAL_HEX16(0x0F, logger_channelMask());
+
+    _sample(1);
+    _writeAll();
+    TEST_ASSERT_EQUAL(LOG_BIN_RECORD_SIZE(4), _written[0].len);
+}
+
+void test_new_layout_waits_for_the_ring()
+{
+    logger_startSampling();
+    _sample(3);
+    logger_stopSampling();
+
+    // Samples taken on channels 0-3 are still waiting when the config changes
+    strcpy(_config_mask, "4-9");
+    logger_loadConfig();
+    TEST_ASSERT_EQUAL_HEX16(0x0F, logger_channelMask());
+
+    _writeAll();
+    TEST_ASSERT_EQUAL(3, _written.size());
+    for (const written_t& w : _written)
+    {
+        TEST_ASSERT_EQUAL(LOG_BIN_RECORD_SIZE(4), w.len);
+        TEST_ASSERT_EQUAL_HEX16(0x0F, w.mask);
+    }
+
+    // Then the new plan takes over
+    TEST_ASSERT_EQUAL_HEX16(0x3F0, logger_channelMask());
+    TEST_ASSERT_EQUAL_UINT8(6, logger_channelCount());
+}
+
+void test_start_writes_old_samples_first()
+{
+    logger_startSampling();
+    _sample(3);
+    logger_stopSampling();
+
+    strcpy(_config_mask, "4-9");
+    logger_startSampling();
+
+    // Written with their own layout before the new plan was published
+    TEST_ASSERT_EQUAL(3, _written.size());
+    TEST_ASSERT_EQUAL(LOG_BIN_RECORD_SIZE(4), _written[2].len);
+    TEST_ASSERT_EQUAL_HEX16(0x0F, _written[2].mask);
+
+    _sample(1);
+    _writeAll();
+    TEST_ASSERT_EQUAL(LOG_BIN_RECORD_SIZE(6), _written[3].len);
+    TEST_ASSERT_EQUAL_HEX16(0x3F0, _written[3].mask);
+    TEST_ASSERT_EQUAL_UINT16(104, _written[3].adc_data[0]);
+}
+
+void test_start_drops_what_the_card_wont_take()
+{
+    logger_startSampling();
+    _sample(3);
+    logger_stopSampling();
+
+    // Rather than writing them later with the wrong layout
+    _card_fails = true;
+    strcpy(_config_mask, "4-9");
+    logger_startSampling();
+
+    TEST_ASSERT_TRUE(logger_getState());
+    TEST_ASSERT_NULL(_ring.peek());
+    TEST_ASSERT_EQUAL_HEX16(0x3F0, logger_channelMask());
+}
+
+void test_slow_profile_needs_the_scan()
+{
+    // 13 channels take 1.3 ms, more than half of a 1 ms period
+    _config_num[CONFIG_POLL_RATE] = 1;
+    _config_num[CONFIG_ADC_SCAN_RATE] = 1000;
+    _channel_us = 100;
+    strcpy(_config_mask, "0-12");
+
+    // The ISR would have to convert every channel if the scan can't start
+    logger_startSampling();
+    TEST_ASSERT_FALSE(logger_getState());
+    TEST_ASSERT_EQUAL_UINT32(0, _sample_timer.begins);
+
+    _scan_starts = true;
+    logger_startSampling();
+    TEST_ASSERT_TRUE(logger_getState());
+}
+
+void test_failed_imu_read_repeats_last()
+{
+    _imu_reads = true;
+    _imu_next = 5;
+    logger_startSampling();
+    _sample(1);
+
+    // Reads that can't start keep the last sample rather than logging zeros
+    _imu_reads = false;
+    _sample(2);
+    _imu_reads = true;
+    _sample(1);
+    _writeAll();
+
+    TEST_ASSERT_EQUAL(4, _written.size());
+    TEST_ASSERT_EQUAL_INT16(5, _written[0].accel_x);
+    TEST_ASSERT_EQUAL_INT16(5, _written[1].accel_x);
+    TEST_ASSERT_EQUAL_INT16(5, _written[2].temp);
+    TEST_ASSERT_EQUAL_INT16(6, _written[3].accel_x);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_isr_walks_the_plan);
+    RUN_TEST(test_new_period_while_sampling);
+    RUN_TEST(test_new_layout_waits_for_the_ring);
+    RUN_TEST(test_start_writes_old_samples_first);
+    RUN_TEST(test_start_drops_what_the_card_wont_take);
+    RUN_TEST(test_slow_profile_needs_the_scan);
+    RUN_TEST(test_failed_imu_read_repeats_last);
+    return UNITY_END();
+}
@@ -0,0 +1,296 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the MPU 6050 driver on a simulated I2C bus that
+ *            counts transactions, bytes and bus time. Compares the one burst
+ *            sample read with the three reads it replaced, checks the
+ *            health monitor brings a lost sensor back, and drains the FIFO.
+ */
+
+#include <unity.h>
+
+#include "../../src/i2c.cpp"
+#include "../../src/mpu.cpp"
+
+// Stand-ins for the modules mpu.cpp calls that aren't under test
+float storage_configGetNum(config_keys_t option) { return 0; }
+
+void setUp()
+{
+    Serial.muted = true;
+    mock_time_frozen = true;
+    mock_i2c_reset();
+    mock_i2c0_reset();
+
+    _connected = false;
+    _fail_run = 0;
+    _reads = _read_fails = 0;
+    _reinits = 0;
+    _next_health = 0;
+    _fifo_rate = _fifo_actual = 0;
+    _fifo_overflows = 0;
+
+    TEST_ASSERT_TRUE(mpu_init());
+
+    // Let the sensor take a first sample
+    mock_advance(2000);
+}
+
+void tearDown()
+{
+    mock_time_frozen = false;
+}
+
+void test_sample_is_one_burst()
+{
+    int16_t accel[3], gyro[3], temp;
+    int16_t old_accel[3], old_gyro[3], old_temp;
+
+    // The reads mpu_sampleRaw used to make
+    mock_i2c.stats = mock_i2c_stats_t();
+    TEST_ASSERT_TRUE(_mpu.testConnection());
+    _mpu.getMotion6(&old_accel[0], &old_accel[1], &old_accel[2], &old_gyro[0], &old_gyro[1], &old_gyro[2]);
+    old_temp = _mpu.getTemperature();
+    mock_i2c_stats_t old = mock_i2c.stats;
+
+    mock_i2c.stats = mock_i2c_stats_t();
+    TEST_ASSERT_TRUE(mpu_sampleRaw(accel, gyro, &temp));
+    mock_i2c_stats_t now = mock_i2c.stats;
+
+    printf("bench mpu sample at %u Hz: %u transactions, %u bytes, %.1f us on the bus "
+           "(was %u transactions, %u bytes, %.1f us)\n",
+           (unsigned) MPU_I2C_CLOCK, now.transactions, now.bytes, now.bus_ns / 1e3,
+           old.transactions, old.bytes, old.bus_ns / 1e3);
+
+    // One register read, a write of the register number then a read, where
+    //   there were three
+    TEST_ASSERT_EQUAL_UINT32(2, now.transactions);
+    TEST_ASSERT_EQUAL_UINT32(3 * now.transactions, old.transactions);
+    TEST_ASSERT_EQUAL_UINT32(2 + 1 + 14, now.bytes);
+    TEST_ASSERT_TRUE(now.bus_ns < old.bus_ns);
+
+    // The blocking read holds the CPU for as long as the bus is busy
+    TEST_ASSERT_UINT32_WITHIN(1, now.bus_ns / 1000, _read_us);
+
+    TEST_ASSERT_EQUAL_INT16_ARRAY(old_accel, accel, 3);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(old_gyro, gyro, 3);
+    TEST_ASSERT_EQUAL_INT16(old_temp, temp);
+}
+
+void test_sample_values()
+{
+    int16_t accel[3], gyro[3], temp;
+    int16_t want_accel[3], want_gyro[3], want_temp;
+
+    mock_advance(10000);
+    TEST_ASSERT_TRUE(mpu_sampleRaw(accel, gyro, &temp));
+
+    mock_mpu_sample(mock_mpu.samples - 1, want_accel, want_gyro, &want_temp);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(want_accel, accel, 3);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(want_gyro, gyro, 3);
+    TEST_ASSERT_EQUAL_INT16(want_temp, temp);
+}
+
+void test_lost_sensor_is_reinitialized()
+{
+    int16_t accel[3], gyro[3], temp;
+
+    mock_mpu.present = false;
+    for (uint8_t i = 0; i < MPU_FAIL_LIMIT; i++)
+        TEST_ASSERT_FALSE(mpu_sampleRaw(accel, gyro, &temp));
+
+    TEST_ASSERT_EQUAL_UINT32(MPU_FAIL_LIMIT, _read_fails);
+
+    // Still missing, so the health check retries after MPU_RETRY_MS
+    mpu_tick();
+    TEST_ASSERT_EQUAL_UINT32(1, _reinits);
+    TEST_ASSERT_FALSE(_connected);
+
+    mock_mpu.present = true;
+    mock_advance(MPU_HEALTH_MS * 1000ULL);
+    mpu_tick();
+    TEST_ASSERT_EQUAL_UINT32(1, _reinits);
+
+    mock_advance(MPU_RETRY_MS * 1000ULL);
+    mpu_tick();
+    TEST_ASSERT_EQUAL_UINT32(2, _reinits);
+    TEST_ASSERT_TRUE(_connected);
+
+    mock_advance(2000);
+    TEST_ASSERT_TRUE(mpu_sampleRaw(accel, gyro, &temp));
+    TEST_ASSERT_EQUAL_UINT8(0, _fail_run);
+
+    // Healthy, so the next check leaves it alone
+    mock_advance(MPU_HEALTH_MS * 1000ULL);
+    mpu_tick();
+    TEST_ASSERT_EQUAL_UINT32(2, _reinits);
+}
+
+void test_single_failure_is_not_a_reinit()
+{
+    int16_t accel[3], gyro[3], temp;
+
+    mock_mpu.present = false;
+    TEST_ASSERT_FALSE(mpu_sampleRaw(accel, gyro, &temp));
+    mock_mpu.present = true;
+    TEST_ASSERT_TRUE(mpu_sampleRaw(accel, gyro, &temp));
+
+    mpu_tick();
+    TEST_ASSERT_EQUAL_UINT32(0, _reinits);
+    TEST_ASSERT_EQUAL_UINT32(1, _read_fails);
+}
+
+// Async reads that have finished, and how many of them succeeded
+static uint32_t _async_calls;
+static uint32_t _async_ok;
+
+static void _countDone(bool ok)
+{
+    _async_calls++;
+    _async_ok += ok;
+}
+
+void test_refused_read_is_counted()
+{
+    int16_t accel[3], gyro[3], temp;
+    int16_t other[3] = { 7, 7, 7 };
+    int16_t other_temp = 7;
+    int16_t want_accel[3], want_gyro[3], want_temp;
+
+    _async_calls = _async_ok = 0;
+
+    // A second read while the first is on the bus is refused and counted,
+    //   and the first still lands in its own outputs
+    TEST_ASSERT_TRUE(mpu_sampleAsync(accel, gyro, &temp, _countDone));
+    TEST_ASSERT_FALSE(mpu_sampleAsync(other, other, &other_temp, _countDone));
+    TEST_ASSERT_EQUAL_UINT32(1, _read_fails);
+
+    mock_advance(I2C_TIMEOUT_US / 2);
+    TEST_ASSERT_EQUAL_UINT32(1, _async_calls);
+    TEST_ASSERT_EQUAL_UINT32(1, _async_ok);
+    mock_mpu_sample(mock_mpu.samples - 1, want_accel, want_gyro, &want_temp);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(want_accel, accel, 3);
+    TEST_ASSERT_EQUAL_INT16(7, other[0]);
+    TEST_ASSERT_EQUAL_INT16(7, other_temp);
+
+    // So is a read of a disconnected sensor, without counting towards a
+    //   reinit
+    _connected = false;
+    TEST_ASSERT_FALSE(mpu_sampleAsync(accel, gyro, &temp, _countDone));
+    TEST_ASSERT_EQUAL_UINT32(2, _read_fails);
+    TEST_ASSERT_EQUAL_UINT8(0, _fail_run);
+    TEST_ASSERT_EQUAL_UINT32(1, _async_calls);
+}
+
+// mpu_readFifo calls made by _drain, and the I2Cdev reads of samples in them
+static uint32_t _drain_calls;
+static uint32_t _drain_chunks;
+
+/*
+ * Name:    _drain
+ *  next:   number of the sample expected next, updated
+ *  return: samples read
+ * Desc:    Read the FIFO until it is empty, as the logger does, checking
+ *            samples come out in order
+ */
+static uint32_t _drain(uint32_t* next)
+{
+    mpu_sample_t burst[MPU_FIFO_BURST];
+    uint16_t behind, n;
+    uint32_t total = 0;
+
+    do
+    {
+        n = mpu_readFifo(burst, MPU_FIFO_BURST, &behind);
+        _drain_calls++;
+        _drain_chunks += (n + 1) / 2;
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            int16_t accel[3], gyro[3], temp;
+
+            mock_mpu_sample(*next, accel, gyro, &temp);
+            TEST_ASSERT_EQUAL_INT16_ARRAY(accel, burst[i].accel, 3);
+            TEST_ASSERT_EQUAL_INT16_ARRAY(gyro, burst[i].gyro, 3);
+            TEST_ASSERT_EQUAL_INT16(temp, burst[i].temp);
+            (*next)++;
+        }
+        total += n;
+    } while (behind);
+
+    return total;
+}
+
+void test_fifo_drain()
+{
+    TEST_ASSERT_TRUE(mpu_startFifo(1000));
+    TEST_ASSERT_EQUAL_UINT16(1000, mpu_fifoRate());
+
+    uint32_t next = mock_mpu.samples;
+
+    // More than a burst waiting, so it takes more than one call
+    mock_advance(50000);
+    mock_i2c.stats = mock_i2c_stats_t();
+    _drain_calls = _drain_chunks = 0;
+    uint32_t n = _drain(&next);
+    mock_i2c_stats_t stats = mock_i2c.stats;
+
+    TEST_ASSERT_TRUE(n >= 50);
+    TEST_ASSERT_TRUE(_drain_calls > 1);
+
+    // Each call reads the count, then up to two samples per I2Cdev chunk.
+    //   Every read is a write of the register number (address and register
+    //   bytes) then a read (address and data).
+    uint32_t reads = _drain_calls + _drain_chunks;
+    TEST_ASSERT_EQUAL_UINT32(2 * reads, stats.transactions);
+    TEST_ASSERT_EQUAL_UINT32(3 * reads + 2 * _drain_calls + n * SAMPLE_BYTES, stats.bytes);
+
+    printf("bench mpu fifo drain at %u Hz: %u samples in %u transactions, %.1f us on the bus\n",
+           (unsigned) MPU_I2C_CLOCK, n, stats.transactions, stats.bus_ns / 1e3);
+
+    // Drained often enough, nothing is lost: every sample has been read in
+    //   order or is still in the FIFO
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        mock_advance(LOGGER_IMU_DRAIN_MS * 1000);
+        n += _drain(&next);
+    }
+    TEST_ASSERT_EQUAL_UINT32(mock_mpu.samples - next, mock_mpu.fifo.size() / SAMPLE_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(0, _fifo_overflows);
+}
+
+void test_fifo_overflow_resets()
+{
+    TEST_ASSERT_TRUE(mpu_startFifo(1000));
+
+    // 100 samples don't fit in 1 KB, and the FIFO loses its alignment
+    mock_advance(100000);
+
+    uint16_t behind;
+    mpu_sample_t burst[MPU_FIFO_BURST];
+
+    TEST_ASSERT_EQUAL_UINT16(0, mpu_readFifo(burst, MPU_FIFO_BURST, &behind));
+    TEST_ASSERT_EQUAL_UINT32(1, _fifo_overflows);
+    TEST_ASSERT_TRUE(mock_mpu.overflows > 0);
+
+    // Carries on from the reset
+    uint32_t next = mock_mpu.samples;
+
+    mock_advance(LOGGER_IMU_DRAIN_MS * 1000);
+    TEST_ASSERT_TRUE(_drain(&next) >= LOGGER_IMU_DRAIN_MS);
+    TEST_ASSERT_EQUAL_UINT32(1, _fifo_overflows);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_is_one_burst);
+    RUN_TEST(test_sample_values);
+    RUN_TEST(test_lost_sensor_is_reinitialized);
+    RUN_TEST(test_single_failure_is_not_a_reinit);
+    RUN_TEST(test_refused_read_is_counted);
+    RUN_TEST(test_fifo_drain);
+    RUN_TEST(test_fifo_overflow_resets);
+    return UNITY_END();
+}
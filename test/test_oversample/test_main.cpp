@@ -0,0 +1,237 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the oversampling and decimation kernel. Readings
+ *            must match a floating point reference for every profile's
+ *            settings, clamp at full scale, and gain resolution from a
+ *            dithered input. The kernel is timed against the reference.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <random>
+
+#include "../../src/oversample.cpp"
+
+#define RANDOM_SUMS 100000
+
+std::mt19937 _rng(1234);
+
+// Settings the ADC profiles use, plus scaling up and a clamp
+typedef struct settings_t
+{
+    uint8_t in_bits;
+    uint8_t oversample;
+    uint8_t out_bits;
+} settings_t;
+
+const settings_t _settings[] =
+{
+    { 16, 0, 13 },          // default
+    { 10, 0, 10 },          // fast
+    { 16, 3, 16 },          // quiet
+    { 12, 0, 16 },          // Fewer bits converted than returned
+    { 16, 3, 14 },          // Full scale rounds past the largest reading
+    { 12, 4, 14 },          // 16 conversions for two more bits
+};
+
+void setUp() {}
+void tearDown() {}
+
+/*
+ * Name:    _reference
+ *  sum:    sum of 2^oversample conversions
+ *  return: the reading, worked out in floating point
+ */
+static uint16_t _reference(uint32_t sum, const settings_t* s)
+{
+    double value = ldexp((double) sum, (int) s->out_bits - s->in_bits - s->oversample);
+    double max = ldexp(1.0, s->out_bits) - 1;
+
+    // Rounds halves up, as the kernel does
+    value = floor(value + 0.5);
+    return (uint16_t) (value > max ? max : value);
+}
+
+/*
+ * Name:    _floatDecimate
+ * Desc:    The kernel as it might be written with the FPU, to time against
+ */
+static void _floatDecimate(const uint32_t* sums, uint16_t* out, uint8_t count,
+                           uint8_t in_bits, uint8_t oversample, uint8_t out_bits)
+{
+    float scale = ldexpf(1.0f, (int) out_bits - in_bits - oversample);
+    float max = ldexpf(1.0f, out_bits) - 1;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        float value = floorf(sums[i] * scale + 0.5f);
+        out[i] = (uint16_t) (value > max ? max : value);
+    }
+}
+
+/*
+ * Name:    _randomSum
+ *  s:      settings the sum is for
+ *  return: a sum of 2^oversample conversions, favouring the ends of the range
+ */
+static uint32_t _randomSum(const settings_t* s)
+{
+    uint32_t conversions = 1UL << s->oversample;
+    uint32_t max = ((1UL << s->in_bits) - 1) * conversions;
+
+    switch (_rng() % 8)
+    {
+      case 0:
+        return _rng() % 16;
+      case 1:
+        return max - _rng() % 16;
+      default:
+        return _rng() % (max + 1);
+    }
+}
+
+void test_matches_reference()
+{
+    for (const settings_t& s : _settings)
+    {
+        for (uint32_t n = 0; n < RANDOM_SUMS; n++)
+        {
+            uint32_t sum = _randomSum(&s);
+            uint16_t out;
+
+            oversample_decimate(&sum, &out, 1, s.in_bits, s.oversample, s.out_bits);
+            TEST_ASSERT_EQUAL_UINT16(_reference(sum, &s), out);
+        }
+    }
+}
+
+void test_identity()
+{
+    // No oversampling at the converted resolution changes nothing
+    uint32_t sums[] = { 0, 1, 511, 1022, 1023 };
+    uint16_t out[5];
+
+    oversample_decimate(sums, out, 5, 10, 0, 10);
+    for (uint8_t i = 0; i < 5; i++)
+        TEST_ASSERT_EQUAL_UINT16(sums[i], out[i]);
+}
+
+void test_rounding_and_clamp()
+{
+    uint16_t out[4];
+
+    // Dropping 3 bits: 3/8 rounds down, 4/8 and 5/8 up
+    uint32_t sums[] = { 3, 4, 5, 8 };
+    oversample_decimate(sums, out, 4, 16, 0, 13);
+    TEST_ASSERT_EQUAL_UINT16(0, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, out[1]);
+    TEST_ASSERT_EQUAL_UINT16(1, out[2]);
+    TEST_ASSERT_EQUAL_UINT16(1, out[3]);
+
+    // Eight full scale conversions would round to 16384, which doesn't fit
+    uint32_t full = 8 * 65535UL;
+    oversample_decimate(&full, out, 1, 16, 3, 14);
+    TEST_ASSERT_EQUAL_UINT16(16383, out[0]);
+
+    // Nothing is written past `count`
+    out[1] = 0xBEEF;
+    oversample_decimate(sums, out, 1, 16, 0, 13);
+    TEST_ASSERT_EQUAL_HEX16(0xBEEF, out[1]);
+}
+
+void test_dither_gains_bits()
+{
+    // A level between codes of a 12-bit ADC with about half a code of noise.
+    //   Summing 16 conversions gives two more bits, so the 14-bit reading
+    //   lands much closer to the level than a single conversion can.
+    std::normal_distribution<double> noise(0, 0.5);
+    const uint16_t runs = 2000;
+    double single_err = 0, over_err = 0;
+
+    for (uint16_t run = 0; run < runs; run++)
+    {
+        double level = 1000 + (_rng() % 1000) / 1000.0;
+        uint32_t sum = 0;
+        uint32_t first = 0;
+
+        for (uint8_t i = 0; i < 16; i++)
+        {
+            uint32_t conversion = (uint32_t) lround(level + noise(_rng));
+            if (!i)
+                first = conversion;
+            sum += conversion;
+        }
+
+        uint16_t out;
+        oversample_decimate(&sum, &out, 1, 12, 4, 14);
+
+        // Errors in 12-bit codes
+        single_err += fabs(first - level);
+        over_err += fabs(out / 4.0 - level);
+    }
+
+    single_err /= runs;
+    over_err /= runs;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "dither: mean error %.3f codes single, %.3f codes from 16 summed",
+             single_err, over_err);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(over_err < single_err / 2);
+}
+
+void test_decimate_speed()
+{
+    const uint32_t blocks = 2000000;
+    static uint32_t sums[1024][16];
+    uint16_t out[16];
+    uint32_t check = 0;
+
+    // The quiet profile, which is the only one that averages in software
+    const settings_t* s = &_settings[2];
+    for (uint16_t i = 0; i < 1024; i++)
+    {
+        for (uint8_t c = 0; c < 16; c++)
+            sums[i][c] = _randomSum(s);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < blocks; n++)
+    {
+        oversample_decimate(sums[n % 1024], out, 16, s->in_bits, s->oversample, s->out_bits);
+        check += out[n % 16];
+    }
+    double fixed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < blocks; n++)
+    {
+        _floatDecimate(sums[n % 1024], out, 16, s->in_bits, s->oversample, s->out_bits);
+        check -= out[n % 16];
+    }
+    double flt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "decimate: fixed point %.1f ns, float %.1f ns per 16 channel sample (host)",
+             fixed / blocks * 1e9, flt / blocks * 1e9);
+    TEST_MESSAGE(msg);
+
+    // Same readings either way
+    TEST_ASSERT_EQUAL_UINT32(0, check);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_reference);
+    RUN_TEST(test_identity);
+    RUN_TEST(test_rounding_and_clamp);
+    RUN_TEST(test_dither_gains_bits);
+    RUN_TEST(test_decimate_speed);
+    return UNITY_END();
+}
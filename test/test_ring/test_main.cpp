@@ -0,0 +1,174 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the SPSC ring, plus a two-thread throughput run
+ *            standing in for the sample ISR and the main loop.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+#include "ring.h"
+
+// Sized like a logger entry so the benchmark moves a realistic amount
+typedef struct item_t
+{
+    uint32_t seq;
+    uint32_t pad[15];
+} item_t;
+
+#define THROUGHPUT_ITEMS 1000000UL
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty()
+{
+    ring_t<uint32_t, 8> ring;
+
+    TEST_ASSERT_NULL(ring.peek());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.count());
+    TEST_ASSERT_EQUAL_UINT32(8, ring.capacity());
+}
+
+void test_order_and_wrap()
+{
+    ring_t<uint32_t, 8> ring;
+    uint32_t next_in = 0, next_out = 0;
+
+    // Enough rounds for the free-running indices to wrap the buffer many times
+    for (uint32_t round = 0; round < 100; round++)
+    {
+        for (uint32_t i = 0; i < 5; i++)
+            TEST_ASSERT_TRUE(ring.push(next_in++));
+
+        while (uint32_t* item = ring.peek())
+        {
+            TEST_ASSERT_EQUAL_UINT32(next_out++, *item);
+            ring.pop();
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(next_in, next_out);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.drops());
+}
+
+void test_full_drops()
+{
+    ring_t<uint32_t, 4> ring;
+
+    for (uint32_t i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(ring.push(i));
+
+    TEST_ASSERT_FALSE(ring.push(99));
+    TEST_ASSERT_NULL(ring.reserve());
+    TEST_ASSERT_EQUAL_UINT32(2, ring.drops());
+    TEST_ASSERT_EQUAL_UINT32(4, ring.count());
+
+    // The entries that made it in are untouched
+    TEST_ASSERT_EQUAL_UINT32(0, *ring.peek());
+    ring.pop();
+    TEST_ASSERT_TRUE(ring.push(4));
+    TEST_ASSERT_EQUAL_UINT32(1, *ring.peek());
+}
+
+void test_reserve_commit()
+{
+    ring_t<uint32_t, 4> ring;
+
+    uint32_t* slot = ring.reserve();
+    TEST_ASSERT_NOT_NULL(slot);
+    *slot = 7;
+
+    // Nothing is visible until it is committed
+    TEST_ASSERT_NULL(ring.peek());
+    ring.commit();
+    TEST_ASSERT_EQUAL_UINT32(7, *ring.peek());
+}
+
+void test_high_water()
+{
+    ring_t<uint32_t, 8> ring;
+
+    for (uint32_t i = 0; i < 6; i++)
+        ring.push(i);
+    for (uint32_t i = 0; i < 6; i++)
+        ring.pop();
+    ring.push(0);
+
+    TEST_ASSERT_EQUAL_UINT32(6, ring.highWater());
+
+    ring.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, ring.highWater());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.drops());
+}
+
+void test_threaded_throughput()
+{
+    static ring_t<item_t, 256> ring;
+    uint32_t errors = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Producer retries on a full ring so every item must arrive, in order.
+    //   Both sides yield when blocked so this also runs on a single core.
+    std::thread producer([]()
+    {
+        for (uint32_t seq = 0; seq < THROUGHPUT_ITEMS; )
+        {
+            item_t* slot = ring.reserve();
+            if (!slot)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            slot->seq = seq;
+            slot->pad[14] = ~seq;
+            ring.commit();
+            seq++;
+        }
+    });
+
+    for (uint32_t seq = 0; seq < THROUGHPUT_ITEMS; )
+    {
+        item_t* item = ring.peek();
+        if (!item)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        errors += (item->seq != seq || item->pad[14] != ~seq);
+        ring.pop();
+        seq++;
+    }
+
+    producer.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char msg[96];
+    snprintf(msg, sizeof(msg), "ring: %.1f M items/s, high water %lu of %lu",
+             THROUGHPUT_ITEMS / secs / 1e6, (unsigned long) ring.highWater(),
+             (unsigned long) ring.capacity());
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.count());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty);
+    RUN_TEST(test_order_and_wrap);
+    RUN_TEST(test_full_drops);
+    RUN_TEST(test_reserve_commit);
+    RUN_TEST(test_high_water);
+    RUN_TEST(test_threaded_throughput);
+    return UNITY_END();
+}
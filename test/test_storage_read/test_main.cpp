@@ -0,0 +1,674 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for reading logs back on a fake card, including an
+ *            hour whose format changed part way through and files cut off
+ *            by power loss. Also times reading a whole generated hour
+ *            against the readBytesUntil and sscanf reader it replaced.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include "fakes.h"
+#include "../../src/csv.cpp"
+#include "../../src/storage.cpp"
+
+#define HOUR         1767225600UL       // Local epoch, 2026-01-01 00:00
+#define HOUR_ARG     (HOUR + 25200)     // As passed to storage_getNextSample
+#define CHANNELS     13
+#define HOUR_ROWS    (3600 * 100)       // An hour at a 10 ms poll rate
+#define CSV_NAME     "DataSock_2026-01-01_00.csv"
+#define BIN_NAME     "DataSock_2026-01-01_00.bin"
+#define IMU_NAME     "DataSock_2026-01-01_00.imu"
+#define SCAN_NAME    "DataSock_2026-01-01_00.scn"
+#define SCAN_NAME_2  "DataSock_2026-01-01_01.scn"
+
+void setUp()
+{
+    Serial.muted = true;
+    mock_sd_reset();
+    _log = log_session_t();
+    _log.catalog = -1;
+    _log_buf_len = 0;
+    _log_pending = false;
+    _index_buf_len = 0;
+    _reader.file.close();
+    _rollup = log_rollup_acc_t();
+    _rollup_file.close();
+    _imu.len = 0;
+    _imu.file.close();
+    _scan.len = 0;
+    _scan.file.close();
+    fake_local_now = HOUR;
+    fake_timezone = -7;
+    fake_channel_mask = (1 << CHANNELS) - 1;
+    storage_init();
+}
+
+void tearDown()
+{
+    _logClose();
+}
+
+/*
+ * Name:    _entry
+ *  n:      sample number
+ *  entry:  set to a sample that can be recognised by its number
+ */
+static void _entry(uint32_t n, log_entry_t* entry)
+{
+    memset(entry, 0, sizeof(*entry));
+    entry->time = fake_local_now;
+    entry->millis = (n * 100) % 1000;
+    entry->mpu_accel[0] = (int16_t) n;
+    for (uint8_t i = 0; i < CHANNELS; i++)
+        entry->adc_data[i] = (uint16_t) ((n + i) % 8192);
+}
+
+/*
+ * Name:    _logSamples
+ *  first:  number of the first sample
+ *  count:  samples to log, 10 per second
+ *  format: format to log in
+ *  rollup: also add the samples to the minute rollups, as the logger does
+ */
+static void _logSamples(uint32_t first, uint32_t count, log_format_t format, bool rollup = false)
+{
+    config_values[CONFIG_LOG_FORMAT].num_value = format;
+
+    for (uint32_t n = first; n < first + count; n++)
+    {
+        log_entry_t entry;
+        char buf[CSV_ROW_MAX_LEN];
+        uint16_t len;
+
+        if (n && n % 10 == 0)
+            fake_local_now++;
+
+        _entry(n, &entry);
+
+        if (format == LOG_FORMAT_BIN)
+        {
+            len = LOG_BIN_RECORD_SIZE(CHANNELS);
+            memcpy(buf, &entry, len);
+        }
+        else
+            len = csv_formatRow(buf, &entry, CHANNELS);
+
+        // The first row after a format change opens the new file
+        if (!storage_addToLogFile(buf, len, format, entry.time))
+            TEST_ASSERT_TRUE(storage_addToLogFile(buf, len, format, entry.time));
+
+        if (rollup)
+            storage_addToRollup(&entry, CHANNELS);
+    }
+
+    storage_flushLog();
+}
+
+void test_index_per_format()
+{
+    _logSamples(0, 50, LOG_FORMAT_CSV);
+    _logSamples(50, 50, LOG_FORMAT_BIN);
+
+    TEST_ASSERT_TRUE(_sd.exists("DataSock_2026-01-01_00.csv.idx"));
+    TEST_ASSERT_TRUE(_sd.exists("DataSock_2026-01-01_00.bin.idx"));
+    TEST_ASSERT_FALSE(_sd.exists("DataSock_2026-01-01_00.idx"));
+}
+
+void test_mixed_hour_in_order()
+{
+    // Binary first this time, so the reader can't rely on CSV coming first
+    _logSamples(0, 50, LOG_FORMAT_BIN);
+    _logSamples(50, 70, LOG_FORMAT_CSV);
+    _logClose();
+
+    log_entry_t log;
+    uint32_t n = 0;
+
+    while (storage_getNextSample(HOUR_ARG, &log))
+    {
+        TEST_ASSERT_EQUAL(n, log.mpu_accel[0]);
+        TEST_ASSERT_EQUAL(CHANNELS, storage_getSampleChannels());
+        n++;
+        TEST_ASSERT_EQUAL(n, storage_getSampleIndex());
+    }
+
+    TEST_ASSERT_EQUAL(120, n);
+}
+
+void test_mixed_hour_seek_index()
+{
+    _logSamples(0, 50, LOG_FORMAT_CSV);
+    _logSamples(50, 50, LOG_FORMAT_BIN);
+    _logClose();
+
+    log_entry_t log;
+    const uint32_t samples[] = { 0, 37, 49, 50, 51, 99 };
+
+    for (uint8_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        TEST_ASSERT_TRUE(storage_seekSampleIndex(HOUR_ARG, samples[i]));
+        TEST_ASSERT_EQUAL(samples[i], storage_getSampleIndex());
+        TEST_ASSERT_TRUE(storage_getNextSample(HOUR_ARG, &log));
+        TEST_ASSERT_EQUAL(samples[i], log.mpu_accel[0]);
+    }
+
+    // Past the end reports where the hour ends
+    TEST_ASSERT_FALSE(storage_seekSampleIndex(HOUR_ARG, 100));
+    TEST_ASSERT_EQUAL(100, storage_getSampleIndex());
+}
+
+void test_mixed_hour_seek_time()
+{
+    _logSamples(0, 50, LOG_FORMAT_CSV);
+    _logSamples(50, 50, LOG_FORMAT_BIN);
+    _logClose();
+
+    log_entry_t log;
+
+    // Sample 73 is at 7.3 s, in the binary file
+    TEST_ASSERT_TRUE(storage_seekSample(HOUR_ARG, HOUR + 7, 300));
+    TEST_ASSERT_EQUAL(73, storage_getSampleIndex());
+    TEST_ASSERT_TRUE(storage_getNextSample(HOUR_ARG, &log));
+    TEST_ASSERT_EQUAL(73, log.mpu_accel[0]);
+
+    TEST_ASSERT_TRUE(storage_seekSample(HOUR_ARG, HOUR + 2, 500));
+    TEST_ASSERT_TRUE(storage_getNextSample(HOUR_ARG, &log));
+    TEST_ASSERT_EQUAL(25, log.mpu_accel[0]);
+}
+
+/*
+ * Name:    _writeCsv
+ *  rows:   number of rows
+ *  return: contents of an hour's CSV file
+ */
+static std::string _writeCsv(uint32_t rows)
+{
+    std::string file;
+    char buf[CSV_ROW_MAX_LEN];
+    log_entry_t entry;
+
+    file.reserve(rows * 90);
+    for (uint32_t n = 0; n < rows; n++)
+    {
+        _entry(n, &entry);
+        entry.time = HOUR + n / 100;
+        file.append(buf, csv_formatRow(buf, &entry, CHANNELS));
+    }
+
+    return file;
+}
+
+/*
+ * Name:    _readAll
+ *  last:   set to the last sample read
+ *  return: number of samples read from the hour
+ */
+static uint32_t _readAll(log_entry_t* last)
+{
+    uint32_t n = 0;
+
+    while (storage_getNextSample(HOUR_ARG, last))
+    {
+        TEST_ASSERT_EQUAL((int16_t) n, last->mpu_accel[0]);
+        n++;
+    }
+
+    return n;
+}
+
+void test_truncated_csv()
+{
+    std::string file = _writeCsv(100);
+    log_entry_t log;
+
+    // Power lost part way through writing the last row
+    file += "1767225601.000,100,0,0,0,0,0,0,100,101,1";
+    mock_sd_files[CSV_NAME].assign(file.begin(), file.end());
+
+    TEST_ASSERT_EQUAL(100, _readAll(&log));
+    TEST_ASSERT_EQUAL(99, log.mpu_accel[0]);
+
+    // Only the line ending was lost, so the row is incomplete too
+    file = _writeCsv(100);
+    file.resize(file.size() - 1);
+    mock_sd_files[CSV_NAME].assign(file.begin(), file.end());
+
+    TEST_ASSERT_EQUAL(99, _readAll(&log));
+}
+
+void test_damaged_csv_row()
+{
+    std::string file = _writeCsv(10);
+    std::string damaged = _writeCsv(20).substr(file.size());
+    log_entry_t log;
+
+    // A row cut short by a reset mid-write, followed by more rows
+    file += "1767225600.900,9,0";
+    file += "\r\n";
+    file += damaged;
+    mock_sd_files[CSV_NAME].assign(file.begin(), file.end());
+
+    // The short row is skipped and the rows after it still read
+    TEST_ASSERT_EQUAL(20, _readAll(&log));
+}
+
+void test_csv_channel_mask()
+{
+    const uint16_t low = (1 << CHANNELS) - 1;
+    const uint16_t high = low << 3;
+    log_entry_t log;
+    uint32_t n = 0;
+
+    // Sampling restarts part way through the hour on other channels, then
+    //   on the first ones again
+    _logSamples(0, 50, LOG_FORMAT_CSV);
+    _logClose();
+    fake_channel_mask = high;
+    _logSamples(50, 50, LOG_FORMAT_CSV);
+    _logClose();
+    fake_channel_mask = low;
+    _logSamples(100, 30, LOG_FORMAT_CSV);
+    _logClose();
+
+    while (storage_getNextSample(HOUR_ARG, &log))
+    {
+        TEST_ASSERT_EQUAL(n, log.mpu_accel[0]);
+        TEST_ASSERT_EQUAL_HEX16((n >= 50 && n < 100) ? high : low, storage_getSampleMask());
+        n++;
+    }
+    TEST_ASSERT_EQUAL(130, n);
+
+    // Seeks by the index land in each session with its mask
+    const uint32_t samples[] = { 20, 75, 115, 99, 0 };
+    for (uint8_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        TEST_ASSERT_TRUE(storage_seekSampleIndex(HOUR_ARG, samples[i]));
+        TEST_ASSERT_TRUE(storage_getNextSample(HOUR_ARG, &log));
+        TEST_ASSERT_EQUAL(samples[i], log.mpu_accel[0]);
+        TEST_ASSERT_EQUAL_HEX16((samples[i] >= 50 && samples[i] < 100) ? high : low, storage_getSampleMask());
+    }
+
+    TEST_ASSERT_TRUE(storage_seekSample(HOUR_ARG, HOUR + 8, 0));
+    TEST_ASSERT_TRUE(storage_getNextSample(HOUR_ARG, &log));
+    TEST_ASSERT_EQUAL(80, log.mpu_accel[0]);
+    TEST_ASSERT_EQUAL_HEX16(high, storage_getSampleMask());
+
+    // Comments are not counted as samples
+    uint16_t count;
+    TEST_ASSERT_TRUE(storage_catalogRebuild());
+    TEST_ASSERT_EQUAL(130, storage_getLogFiles(&count, 0, 0)->samples);
+
+    // Files from before the mask was recorded hold the lowest channels
+    std::string file = _writeCsv(10);
+    mock_sd_files[CSV_NAME].assign(file.begin(), file.end());
+    mock_sd_files.erase("DataSock_2026-01-01_00.csv.idx");
+    _reader.file.close();
+
+    TEST_ASSERT_TRUE(storage_getNextSample(HOUR_ARG, &log));
+    TEST_ASSERT_EQUAL_HEX16(low, storage_getSampleMask());
+}
+
+void test_truncated_bin()
+{
+    _logSamples(0, 30, LOG_FORMAT_BIN);
+    _logClose();
+
+    // Half a record at the end of the file is ignored
+    std::vector<uint8_t>& data = mock_sd_files[BIN_NAME];
+    data.resize(data.size() - LOG_BIN_RECORD_SIZE(CHANNELS) / 2);
+
+    log_entry_t log;
+    TEST_ASSERT_EQUAL(29, _readAll(&log));
+}
+
+void test_bin_header_checks()
+{
+    _logSamples(0, 30, LOG_FORMAT_BIN);
+    _logClose();
+
+    std::vector<uint8_t> good = mock_sd_files[BIN_NAME];
+    log_bin_header_t* header = (log_bin_header_t*) mock_sd_files[BIN_NAME].data();
+    log_entry_t log;
+
+    // Counting samples would divide by a zero record size
+    header->record_size = 0;
+    TEST_ASSERT_FALSE(storage_getNextSample(HOUR_ARG, &log));
+
+    // Version 1 headers end before adc_bits, and hold a range of channels
+    uint8_t v1_size = offsetof(log_bin_header_t, adc_bits);
+    std::vector<uint8_t> v1(good.begin(), good.begin() + v1_size);
+
+    v1.insert(v1.end(), good.begin() + sizeof(log_bin_header_t), good.end());
+    header = (log_bin_header_t*) v1.data();
+    header->version = 1;
+    header->header_size = v1_size;
+    header->channel_bottom = 2;
+    mock_sd_files[BIN_NAME] = v1;
+
+    _reader.header.adc_bits = 0;
+    TEST_ASSERT_EQUAL(30, _readAll(&log));
+    TEST_ASSERT_EQUAL(13, _reader.header.adc_bits);
+    TEST_ASSERT_EQUAL_HEX16(((1 << CHANNELS) - 1) << 2, storage_getSampleMask());
+
+    // Even before any records, when the file is shorter than today's header
+    v1.resize(v1_size);
+    mock_sd_files[BIN_NAME] = v1;
+
+    _reader.header.adc_bits = 0;
+    TEST_ASSERT_EQUAL(0, _readAll(&log));
+    TEST_ASSERT_EQUAL(13, _reader.header.adc_bits);
+
+    // Version 2 headers must hold the channel mask
+    v1[4] = 2;
+    mock_sd_files[BIN_NAME] = v1;
+    TEST_ASSERT_FALSE(storage_getNextSample(HOUR_ARG, &log));
+}
+
+void test_imu_file()
+{
+    // A second of 1 kHz FIFO samples
+    for (uint32_t n = 0; n < 1000; n++)
+    {
+        mpu_sample_t sample = {};
+
+        sample.time = HOUR;
+        sample.millis = n;
+        sample.accel[0] = (int16_t) n;
+        sample.temp = -(int16_t) n;
+        TEST_ASSERT_TRUE(storage_addToImuFile(&sample));
+    }
+    TEST_ASSERT_TRUE(_sideFlush(&_imu, true));
+
+    mpu_sample_t out[64];
+    uint32_t read = 0;
+    uint16_t n;
+
+    while ((n = storage_getImuSamples(HOUR_ARG, read, out, 64)))
+    {
+        for (uint16_t i = 0; i < n; i++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(HOUR, out[i].time);
+            TEST_ASSERT_EQUAL_UINT16(read + i, out[i].millis);
+            TEST_ASSERT_EQUAL_INT16((int16_t) (read + i), out[i].accel[0]);
+            TEST_ASSERT_EQUAL_INT16(-(int16_t) (read + i), out[i].temp);
+        }
+        read += n;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1000, read);
+
+    // Longer records from newer firmware are stepped over
+    std::vector<uint8_t> good = mock_sd_files[IMU_NAME];
+    std::vector<uint8_t> longer(good.begin(), good.begin() + sizeof(log_imu_header_t));
+
+    for (size_t pos = sizeof(log_imu_header_t); pos < good.size(); pos += sizeof(mpu_sample_t))
+    {
+        longer.insert(longer.end(), good.begin() + pos, good.begin() + pos + sizeof(mpu_sample_t));
+        longer.insert(longer.end(), 4, 0xAA);
+    }
+    ((log_imu_header_t*) longer.data())->record_size = sizeof(mpu_sample_t) + 4;
+    mock_sd_files[IMU_NAME] = longer;
+
+    TEST_ASSERT_EQUAL_UINT16(2, storage_getImuSamples(HOUR_ARG, 998, out, 64));
+    TEST_ASSERT_EQUAL_UINT16(998, out[0].millis);
+    TEST_ASSERT_EQUAL_UINT16(999, out[1].millis);
+
+    // Bad headers, and hours with no file
+    mock_sd_files[IMU_NAME] = good;
+    ((log_imu_header_t*) mock_sd_files[IMU_NAME].data())->magic[0] = 'X';
+    TEST_ASSERT_EQUAL_UINT16(0, storage_getImuSamples(HOUR_ARG, 0, out, 64));
+
+    mock_sd_files[IMU_NAME] = good;
+    ((log_imu_header_t*) mock_sd_files[IMU_NAME].data())->record_size = 2;
+    TEST_ASSERT_EQUAL_UINT16(0, storage_getImuSamples(HOUR_ARG, 0, out, 64));
+
+    TEST_ASSERT_EQUAL_UINT16(0, storage_getImuSamples(HOUR_ARG + SECS_PER_HOUR, 0, out, 64));
+}
+
+/*
+ * Name:    _scanBlock
+ *  seq:    block number
+ *  count:  channels in each scan
+ *  block:  set to a block of ADC_SCAN_BLOCK scans recognisable by its number
+ */
+static void _scanBlock(uint32_t seq, uint8_t count, log_scan_block_t* block)
+{
+    memset(block, 0, sizeof(*block));
+    block->time = HOUR + seq * ADC_SCAN_BLOCK / 1000;
+    block->millis = seq * ADC_SCAN_BLOCK % 1000;
+    block->rate = 1000;
+    block->seq = seq;
+    block->channel_mask = (1 << count) - 1;
+    block->channel_count = count;
+    block->adc_bits = 13;
+    block->scans = ADC_SCAN_BLOCK;
+
+    for (uint16_t i = 0; i < ADC_SCAN_BLOCK * count; i++)
+        block->adc_data[i] = (uint16_t) (seq * 1000 + i);
+}
+
+void test_scan_file()
+{
+    log_scan_block_t block;
+
+    // Two runs in the hour with different channels, then a block in the next
+    //   hour. A gap in the numbers is a block the card didn't keep up with.
+    const uint32_t seqs[] = { 0, 1, 2, 5, 0, 1 };
+    const uint8_t counts[] = { 4, 4, 4, 4, 16, 16 };
+
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        _scanBlock(seqs[i], counts[i], &block);
+        TEST_ASSERT_TRUE(storage_addToScanFile(&block));
+    }
+
+    _scanBlock(0, 1, &block);
+    block.time = HOUR + SECS_PER_HOUR;
+    TEST_ASSERT_TRUE(storage_addToScanFile(&block));
+    TEST_ASSERT_TRUE(_sideFlush(&_scan, true));
+
+    const std::vector<uint8_t>& file = mock_sd_files[SCAN_NAME];
+    const log_scan_header_t* header = (const log_scan_header_t*) file.data();
+
+    TEST_ASSERT_EQUAL_MEMORY(LOG_SCAN_MAGIC, header->magic, 4);
+    TEST_ASSERT_EQUAL_UINT8(LOG_SCAN_VERSION, header->version);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(log_scan_header_t), header->header_size);
+    TEST_ASSERT_EQUAL_UINT16(18, header->block_header_size);
+
+    // Each block is its header then only the readings it holds
+    size_t pos = header->header_size;
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        log_scan_block_t read;
+
+        TEST_ASSERT_TRUE(pos + header->block_header_size <= file.size());
+        memcpy(&read, file.data() + pos, header->block_header_size);
+        pos += header->block_header_size;
+
+        TEST_ASSERT_EQUAL_UINT32(seqs[i], read.seq);
+        TEST_ASSERT_EQUAL_UINT8(counts[i], read.channel_count);
+        TEST_ASSERT_EQUAL_UINT16(ADC_SCAN_BLOCK, read.scans);
+
+        uint16_t readings = read.scans * read.channel_count;
+        memcpy(read.adc_data, file.data() + pos, readings * sizeof(uint16_t));
+        pos += readings * sizeof(uint16_t);
+
+        TEST_ASSERT_EQUAL_UINT16(seqs[i] * 1000, read.adc_data[0]);
+        TEST_ASSERT_EQUAL_UINT16(seqs[i] * 1000 + readings - 1, read.adc_data[readings - 1]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(file.size(), pos);
+
+    size_t next = sizeof(log_scan_header_t) + LOG_SCAN_BLOCK_SIZE(&block);
+    TEST_ASSERT_EQUAL_UINT32(next, mock_sd_files[SCAN_NAME_2].size());
+}
+
+void test_read_hour_speed()
+{
+    std::string file = _writeCsv(HOUR_ROWS);
+    log_entry_t log;
+
+    mock_sd_files[CSV_NAME].assign(file.begin(), file.end());
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t rows = 0;
+    while (storage_getNextSample(HOUR_ARG, &log))
+        rows++;
+    double fast = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_EQUAL(HOUR_ROWS, rows);
+
+    // How the hour used to be read: a line at a time, then sscanf
+    FsFile old;
+    old.open(CSV_NAME, O_RDONLY);
+
+    start = std::chrono::steady_clock::now();
+    uint32_t old_rows = 0;
+    char line[200];
+    while (old.available())
+    {
+        size_t len = old.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[len] = '\0';
+
+        uint32_t time;
+        uint8_t count = sscanf(line, "%u.%hu,%hd,%hd,%hd,%hd,%hd,%hd,%hd,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu",
+            &time, &log.millis, &log.mpu_accel[0], &log.mpu_accel[1], &log.mpu_accel[2],
+            &log.mpu_gyro[0], &log.mpu_gyro[1], &log.mpu_gyro[2], &log.mpu_temp,
+            &log.adc_data[0], &log.adc_data[1], &log.adc_data[2], &log.adc_data[3],
+            &log.adc_data[4], &log.adc_data[5], &log.adc_data[6], &log.adc_data[7],
+            &log.adc_data[8], &log.adc_data[9], &log.adc_data[10], &log.adc_data[11],
+            &log.adc_data[12], &log.adc_data[13], &log.adc_data[14], &log.adc_data[15]);
+        old_rows += (count >= 9);
+    }
+    double slow = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_EQUAL(HOUR_ROWS, old_rows);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "read: %lu rows (%.1f MB), block reader %.2f M rows/s, "
+             "readBytesUntil + sscanf %.2f M rows/s (%.1fx)",
+             (unsigned long) rows, file.size() / 1e6, rows / fast / 1e6, rows / slow / 1e6, slow / fast);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(slow, fast);
+}
+
+void test_catalog_merges_formats()
+{
+    uint16_t count;
+
+    _logSamples(0, 50, LOG_FORMAT_CSV);
+    _logSamples(50, 70, LOG_FORMAT_BIN);
+    storage_flushLog();
+
+    // One entry for the hour, kept up to date while logging
+    const log_catalog_entry_t* entry = storage_getLogFiles(&count, 0, 0);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL((1 << LOG_FORMAT_CSV) | (1 << LOG_FORMAT_BIN), entry->formats);
+    TEST_ASSERT_EQUAL(120, entry->samples);
+    TEST_ASSERT_EQUAL(HOUR, entry->first);
+    TEST_ASSERT_EQUAL(HOUR + 11, entry->last);
+    TEST_ASSERT_EQUAL(mock_sd_files[CSV_NAME].size() + mock_sd_files[BIN_NAME].size(), entry->size);
+
+    log_catalog_entry_t logged = *entry;
+    _logClose();
+
+    // And the same again from scanning the card
+    TEST_ASSERT_TRUE(storage_catalogRebuild());
+    entry = storage_getLogFiles(&count, 0, 0);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL_MEMORY(&logged, entry, sizeof(logged));
+}
+
+void test_timezone()
+{
+    uint16_t count;
+    log_entry_t log;
+
+    fake_timezone = 2;
+    config_values[CONFIG_TIMEZONE].num_value = fake_timezone;
+    _logSamples(0, 50, LOG_FORMAT_BIN);
+    _logClose();
+
+    // The catalog and the reader agree on the UTC hour of the local file
+    const log_catalog_entry_t* entry = storage_getLogFiles(&count, 0, 0);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(HOUR - 2 * SECS_PER_HOUR, entry->hour);
+    TEST_ASSERT_TRUE(storage_seekSampleIndex(entry->hour, 10));
+    TEST_ASSERT_TRUE(storage_getNextSample(entry->hour, &log));
+    TEST_ASSERT_EQUAL(10, log.mpu_accel[0]);
+    TEST_ASSERT_FALSE(storage_getNextSample(HOUR_ARG, &log));
+}
+
+void test_rollups()
+{
+    log_rollup_t rollup;
+    uint32_t start = HOUR;
+
+    // Three and a half minutes, closing the log part way through the last
+    _logSamples(0, 1900, LOG_FORMAT_CSV, true);
+    _logClose();
+
+    const uint16_t counts[] = { 600, 600, 600, 100 };
+    for (uint16_t count : counts)
+    {
+        TEST_ASSERT_TRUE(storage_getNextRollup(start, HOUR + SECS_PER_HOUR - 1, &rollup));
+        TEST_ASSERT_EQUAL(start, rollup.minute);
+        TEST_ASSERT_EQUAL(count, rollup.count);
+        start = rollup.minute + SECS_PER_MIN;
+    }
+    TEST_ASSERT_FALSE(storage_getNextRollup(start, HOUR + SECS_PER_HOUR - 1, &rollup));
+
+    // Carrying on in the same minute replaces the early copy
+    _logSamples(1900, 200, LOG_FORMAT_CSV, true);
+    _logClose();
+
+    TEST_ASSERT_TRUE(storage_getNextRollup(HOUR + 3 * SECS_PER_MIN, HOUR + SECS_PER_HOUR - 1, &rollup));
+    TEST_ASSERT_EQUAL(HOUR + 3 * SECS_PER_MIN, rollup.minute);
+    TEST_ASSERT_EQUAL(300, rollup.count);
+    TEST_ASSERT_FALSE(storage_getNextRollup(rollup.minute + SECS_PER_MIN, HOUR + SECS_PER_HOUR - 1, &rollup));
+}
+
+void test_rollups_skip_empty_hours()
+{
+    _logSamples(0, 100, LOG_FORMAT_CSV, true);
+    _logClose();
+
+    // The next log a year later
+    fake_local_now = HOUR + 365 * SECS_PER_DAY;
+    _logSamples(0, 100, LOG_FORMAT_CSV, true);
+    _logClose();
+
+    log_rollup_t rollup;
+    uint32_t misses = mock_sd_misses;
+
+    TEST_ASSERT_TRUE(storage_getNextRollup(HOUR + SECS_PER_MIN, UINT32_MAX, &rollup));
+    TEST_ASSERT_EQUAL(HOUR + 365 * SECS_PER_DAY, rollup.minute);
+    TEST_ASSERT_TRUE(mock_sd_misses - misses < 10);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_index_per_format);
+    RUN_TEST(test_mixed_hour_in_order);
+    RUN_TEST(test_mixed_hour_seek_index);
+    RUN_TEST(test_mixed_hour_seek_time);
+    RUN_TEST(test_csv_channel_mask);
+    RUN_TEST(test_catalog_merges_formats);
+    RUN_TEST(test_timezone);
+    RUN_TEST(test_rollups);
+    RUN_TEST(test_rollups_skip_empty_hours);
+    RUN_TEST(test_truncated_csv);
+    RUN_TEST(test_damaged_csv_row);
+    RUN_TEST(test_truncated_bin);
+    RUN_TEST(test_bin_header_checks);
+    RUN_TEST(test_imu_file);
+    RUN_TEST(test_scan_file);
+    RUN_TEST(test_read_hour_speed);
+    return UNITY_END();
+}
@@ -0,0 +1,269 @@
+/*
+ * File:    test_main.cpp
+ * Authors: Gary Huang, Yao Li, Joby Matwick, and Jason Zhang
+ * Created: 2026-10-16
+ * Desc:    Host tests for the log write path on a fake block device: rows
+ *            must reach the card in whole sectors, nothing may wait longer
+ *            than LOG_FLUSH_MS, and the file must hold exactly the rows
+ *            logged. Also reports write counts and per-row latency against
+ *            the old open-append-flush-close per row.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include "fakes.h"
+#include "../../src/csv.cpp"
+#include "../../src/storage.cpp"
+
+#define POLL_MS      10
+#define LOG_SECONDS  60
+
+void setUp()
+{
+    Serial.muted = true;
+    mock_sd_reset();
+    _log = log_session_t();
+    _log.catalog = -1;
+    _log_buf_len = 0;
+    _log_pending = false;
+    _index_buf_len = 0;
+    storage_init();
+}
+
+void tearDown()
+{
+    _logClose();
+}
+
+/*
+ * Name:    _row
+ *  n:      sample number
+ *  buf:    set to the CSV row for the sample
+ *  return: length of the row
+ */
+static uint16_t _row(uint32_t n, char* buf)
+{
+    log_entry_t entry;
+
+    memset(&entry, 0, sizeof(entry));
+    entry.time = fake_local_now;
+    entry.millis = (n * POLL_MS) % 1000;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        entry.mpu_accel[i] = (int16_t) (n * 7 + i);
+        entry.mpu_gyro[i] = (int16_t) -(n * 3 + i);
+    }
+    for (uint8_t i = 0; i < 13; i++)
+        entry.adc_data[i] = (uint16_t) ((n + i * 97) % 8192);
+
+    return csv_formatRow(buf, &entry, 13);
+}
+
+/*
+ * Name:    _mask
+ *  return: the channel mask comment that starts every file
+ */
+static std::string _mask()
+{
+    char buf[CSV_MASK_MAX_LEN];
+
+    return std::string(buf, csv_formatMask(buf, logger_channelMask()));
+}
+
+/*
+ * Name:    _logFor
+ *  seconds: how long to log for at POLL_MS
+ *  expect: set to the bytes that should be in the file
+ * Desc:    Log rows as the main loop would, servicing the log between rows
+ */
+static void _logFor(uint32_t seconds, std::string* expect)
+{
+    char buf[CSV_ROW_MAX_LEN];
+
+    for (uint32_t n = 0; n < seconds * 1000 / POLL_MS; n++)
+    {
+        uint16_t len = _row(n, buf);
+
+        TEST_ASSERT_TRUE(storage_addToLogFile(buf, len, LOG_FORMAT_CSV, fake_local_now));
+        expect->append(buf, len);
+
+        mock_advance(POLL_MS * 1000);
+        if (n % (1000 / POLL_MS) == 0)
+            fake_local_now++;
+
+        storage_serviceLog();
+    }
+}
+
+void test_whole_sectors()
+{
+    std::string expect = _mask();
+
+    _logFor(LOG_SECONDS, &expect);
+    TEST_ASSERT_TRUE(storage_flushLog());
+
+    mock_sd_stats_t* stats = &mock_sd_stats[_log.filename];
+    const std::vector<uint8_t>& data = mock_sd_files[_log.filename];
+
+    TEST_ASSERT_EQUAL(expect.size(), data.size());
+    TEST_ASSERT_EQUAL_MEMORY(expect.data(), data.data(), expect.size());
+
+    // Only deadline flushes may end part way through a sector, and the next
+    //   write tops that sector up, so at most two partial writes a flush
+    TEST_ASSERT_LESS_OR_EQUAL(2 * stats->flushes, stats->partial);
+
+    uint32_t rows = LOG_SECONDS * 1000 / POLL_MS;
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "write: %lu rows, %lu bytes in %lu writes (%lu partial, %lu sectors read back), "
+             "%lu syncs; flush per row would be %lu partial writes",
+             (unsigned long) rows, (unsigned long) stats->bytes, (unsigned long) stats->writes,
+             (unsigned long) stats->partial, (unsigned long) stats->rmw_sectors,
+             (unsigned long) stats->flushes, (unsigned long) rows);
+    TEST_MESSAGE(msg);
+}
+
+void test_flush_deadline()
+{
+    char buf[CSV_ROW_MAX_LEN];
+    uint16_t len = _row(0, buf);
+
+    TEST_ASSERT_TRUE(storage_addToLogFile(buf, len, LOG_FORMAT_CSV, fake_local_now));
+    TEST_ASSERT_EQUAL(0, mock_sd_files[_log.filename].size());
+
+    mock_advance((LOG_FLUSH_MS - 1) * 1000);
+    storage_serviceLog();
+    TEST_ASSERT_EQUAL(0, mock_sd_files[_log.filename].size());
+
+    mock_advance(2 * 1000);
+    storage_serviceLog();
+    TEST_ASSERT_EQUAL(_mask().size() + len, mock_sd_files[_log.filename].size());
+    TEST_ASSERT_FALSE(_log_pending);
+}
+
+void test_session_stays_open()
+{
+    std::string expect;
+    uint32_t begins = mock_sd_begins;
+
+    _logFor(1, &expect);
+    uint32_t opens = mock_sd_stats[_log.filename].opens;
+    _logFor(5, &expect);
+
+    // Once the file is open, rows touch neither the card nor the directory
+    TEST_ASSERT_EQUAL(begins, mock_sd_begins);
+    TEST_ASSERT_EQUAL(opens, mock_sd_stats[_log.filename].opens);
+}
+
+void test_hour_rollover()
+{
+    char buf[CSV_ROW_MAX_LEN];
+    uint16_t len = _row(0, buf);
+
+    fake_local_now = 1767225600 + SECS_PER_HOUR - 1;
+    TEST_ASSERT_TRUE(storage_addToLogFile(buf, len, LOG_FORMAT_CSV, fake_local_now));
+    std::string first = _log.filename;
+
+    fake_local_now++;
+    TEST_ASSERT_TRUE(storage_addToLogFile(buf, len, LOG_FORMAT_CSV, fake_local_now));
+    storage_flushLog();
+
+    // Rows buffered for the old hour were written before it was closed
+    TEST_ASSERT_TRUE(first != _log.filename);
+    TEST_ASSERT_EQUAL(_mask().size() + len, mock_sd_files[first].size());
+    TEST_ASSERT_EQUAL(_mask().size() + len, mock_sd_files[_log.filename].size());
+}
+
+void test_index_never_ahead()
+{
+    char buf[CSV_ROW_MAX_LEN];
+    char index_name[LOG_FILENAME_LEN];
+    uint16_t len = _row(0, buf);
+
+    // One row a second with the log never serviced, so the index buffer
+    //   fills before any deadline flush
+    for (uint8_t n = 0; n < 3 * INDEX_BUF_LEN; n++)
+    {
+        TEST_ASSERT_TRUE(storage_addToLogFile(buf, len, LOG_FORMAT_CSV, fake_local_now));
+        fake_local_now++;
+
+        _indexFileName(index_name, sizeof(index_name), _log.start, LOG_FORMAT_CSV);
+        const std::vector<uint8_t>& index = mock_sd_files[index_name];
+        const log_index_entry_t* entries = (const log_index_entry_t*) index.data();
+
+        for (size_t i = 0; i < index.size() / sizeof(log_index_entry_t); i++)
+            TEST_ASSERT_LESS_THAN(mock_sd_files[_log.filename].size(), entries[i].offset);
+    }
+
+    TEST_ASSERT_TRUE(_log.indexed);
+    TEST_ASSERT_GREATER_THAN(0, mock_sd_files[index_name].size());
+}
+
+void test_row_latency()
+{
+    char buf[CSV_ROW_MAX_LEN];
+    const uint32_t rows = 20000;
+    double session_max = 0, reopen_max = 0;
+
+    uint16_t len = _row(1, buf);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rows; n++)
+    {
+        auto row_start = std::chrono::steady_clock::now();
+        storage_addToLogFile(buf, len, LOG_FORMAT_CSV, fake_local_now);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - row_start).count();
+        session_max = max(session_max, us);
+    }
+    double session_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rows;
+
+    // What every row used to cost: start the card, find the file by name,
+    //   then open, append, flush and close it
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rows; n++)
+    {
+        auto row_start = std::chrono::steady_clock::now();
+        char filename[LOG_FILENAME_LEN];
+        FsFile file;
+
+        storage_start();
+        _logFileName(filename, sizeof(filename), fake_local_now, "old");
+        _sd.exists(filename);
+        file.open(filename, O_RDWR | O_CREAT | O_APPEND);
+        file.write(buf, len);
+        file.flush();
+        file.close();
+
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - row_start).count();
+        reopen_max = max(reopen_max, us);
+    }
+    double reopen_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rows;
+
+    // The fake card costs nothing, so this is CPU overhead only; on the
+    //   card every reopened row also pays a partial sector write
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "latency: session %.3f us/row (max %.1f), reopen per row %.3f us/row (max %.1f), "
+             "%lu vs %lu partial writes",
+             session_us, session_max, reopen_us, reopen_max,
+             (unsigned long) mock_sd_stats[_log.filename].partial,
+             (unsigned long) rows);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(reopen_us, session_us);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_sectors);
+    RUN_TEST(test_flush_deadline);
+    RUN_TEST(test_session_stays_open);
+    RUN_TEST(test_hour_rollover);
+    RUN_TEST(test_index_never_ahead);
+    RUN_TEST(test_row_latency);
+    return UNITY_END();
+}